@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Times one step of the multi-ball swarm with each kernel the CPU supports, per ball per tick
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/BallSwarm.h"
+
+using namespace pong;
+
+static const char *kernelName(SwarmKernel _kernel) {
+  switch (_kernel) {
+  case SwarmKernel::SSE:
+    return "sse";
+  case SwarmKernel::AVX2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+static void fill(BallSwarm &_swarm, size_t _count, const SwarmField &_field) {
+  // Spread the balls over the field with a simple LCG so every kernel sees the same ones
+  uint32_t state = 1;
+  auto     next = [&state](float _low, float _high) {
+    state = state * 214013u + 2531011u;
+    return _low + float((state >> 16) & 0x7fff) / 32767.0f * (_high - _low);
+  };
+  _swarm.resize(_count, _field.width / 2, _field.height / 2);
+  for (size_t i = 0; i < _count; i++) {
+    float vx = next(2, 3);
+    _swarm.set(i, next(1, _field.width - 1), next(3, _field.height - 1), next(0, 1) < 0.5f ? -vx : vx, next(-1.5f, 1.5f));
+  }
+}
+
+int main() {
+  const size_t      COUNTS[] = {1000, 10000, 100000, 1000000};
+  const SwarmKernel KERNELS[] = {SwarmKernel::SCALAR, SwarmKernel::SSE, SwarmKernel::AVX2};
+
+  // Paddles sit in the middle, so most balls are returned and the rest are served again from the middle
+  SwarmField field;
+  field.leftPaddleY = 19;
+  field.rightPaddleY = 19;
+
+  for (size_t count : COUNTS) {
+    for (SwarmKernel kernel : KERNELS) {
+      if (!BallSwarm::isSupported(kernel)) continue;
+
+      BallSwarm swarm;
+      swarm.setKernel(kernel);
+      fill(swarm, count, field);
+      std::vector<uint32_t> missed;
+      missed.reserve(count);
+
+      const uint64_t ticks = 20000000 / count;
+      bench::Result  result = bench::run("swarm step", ticks * count, [&](uint64_t) {
+        for (uint64_t tick = 0; tick < ticks; tick++) {
+          swarm.step(field, missed);
+          for (uint32_t index : missed) swarm.set(index, field.width / 2, field.height / 2, -swarm.getXVelocity(index), swarm.getYVelocity(index));
+        }
+        bench::doNotOptimize(swarm);
+      });
+      printf("%8zu balls  %-6s  %6.3f ns/ball/tick  (best %.3f)\n", count, kernelName(kernel), result.nsPerOp, result.minNsPerOp);
+    }
+  }
+  return 0;
+}
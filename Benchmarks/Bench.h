@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_BENCH_H
+#define PONG_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace pong {
+  namespace bench {
+
+    // How the benchmarks were compiled, written alongside the results
+#ifdef NDEBUG
+    static const char *const BUILD_TYPE = "release";
+#else
+    static const char *const BUILD_TYPE = "debug";
+#endif
+
+    // Keep the compiler from throwing away a value the benchmark only computes
+    template <typename T>
+    inline void doNotOptimize(const T &_value) {
+#if defined(__GNUC__) || defined(__clang__)
+      asm volatile("" : : "r,m"(_value) : "memory");
+#else
+      static volatile const void *sink;
+      sink = &_value;
+#endif
+    }
+
+    // The timing of one benchmark
+    struct Result {
+      const char *name = "";       // What was measured
+      uint64_t    ops = 0;         // Operations per repeat
+      double      nsPerOp = 0;     // Median time per operation over the repeats
+      double      minNsPerOp = 0;  // Fastest time per operation over the repeats
+    };
+
+    // The median and best of timings per operation taken by the caller
+    inline Result summarize(const char *_name, uint64_t _ops, std::vector<double> _samples) {
+      std::sort(_samples.begin(), _samples.end());
+
+      Result result;
+      result.name = _name;
+      result.ops = _ops;
+      result.nsPerOp = _samples[_samples.size() / 2];
+      result.minNsPerOp = _samples[0];
+      return result;
+    }
+
+    // Time _body(_ops) a few times after a warm up run and keep the median and best
+    template <typename Body>
+    Result run(const char *_name, uint64_t _ops, Body &&_body, int _repeats = 5) {
+      _body(_ops);
+
+      std::vector<double> samples;
+      for (int i = 0; i < _repeats; i++) {
+        auto startTime = std::chrono::steady_clock::now();
+        _body(_ops);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+        samples.push_back(ns / double(_ops));
+      }
+      return summarize(_name, _ops, samples);
+    }
+
+    inline void print(const Result &_result) {
+      printf("%-32s %10.2f ns/op  (best %.2f, %llu ops)\n", _result.name, _result.nsPerOp, _result.minNsPerOp,
+             (unsigned long long)_result.ops);
+    }
+
+    inline bool writeJson(const char *_path, const std::vector<Result> &_results) {
+      // The layout Google Benchmark writes with --benchmark_format=json, so its compare.py can diff two runs
+      FILE *file = fopen(_path, "w");
+      if (!file) return false;
+      fprintf(file, "{\n  \"context\": {\n    \"library_build_type\": \"%s\"\n  },\n  \"benchmarks\": [", BUILD_TYPE);
+      for (size_t i = 0; i < _results.size(); i++) {
+        const Result &result = _results[i];
+        fprintf(file,
+                "%s\n    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %llu, "
+                "\"real_time\": %.4f, \"cpu_time\": %.4f, \"best_time\": %.4f, \"time_unit\": \"ns\"}",
+                i ? "," : "", result.name, result.name, (unsigned long long)result.ops, result.nsPerOp, result.nsPerOp,
+                result.minNsPerOp);
+      }
+      fprintf(file, "\n  ]\n}\n");
+      return fclose(file) == 0;
+    }
+
+  }  // namespace bench
+}  // namespace pong
+
+#endif  // PONG_BENCH_H
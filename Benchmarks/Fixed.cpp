@@ -0,0 +1,103 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Compares the ball's path maths in float and Q16.16, then times a whole match in whichever the build plays in and
+// prints a hash of every tick's state. Build it with and without -DPONG_FIXED_POINT, and with different compilers and
+// flags, the fixed point hash should never change.
+
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Replay.h"
+
+using namespace pong;
+
+// The work of a ball tick: the time to the nearest wall or paddle plane, then the position along the path
+template <typename T>
+static T pathStep(T _originX, T _originY, T _vx, T _vy, T _age, T _timeScale) {
+  T stepX = _vx * _timeScale, stepY = _vy * _timeScale;
+  T toWall = (stepY < 0) ? (T(3) - _originY) / stepY : (T(34) - _originY) / stepY;
+  T toPlane = (stepX < 0) ? (T(1) - _originX) / stepX : (T(78) - _originX) / stepX;
+  T eventAge = (toWall < toPlane) ? toWall : toPlane;
+  T age = (_age < eventAge) ? _age : eventAge;
+  return _originX + stepX * age + _originY + stepY * age;
+}
+
+template <typename T>
+static bench::Result runPaths(const char *_name, uint64_t _paths) {
+  // The same spread of paths in either type, converted once up front
+  std::vector<T> values;
+  uint32_t       state = 1;
+  for (int i = 0; i < 4096; i++) {
+    state = state * 214013u + 2531011u;
+    values.push_back(T(float((state >> 16) & 0x7fff) / 32767.0f * 3.0f - 1.5f));
+  }
+  return bench::run(_name, _paths, [&](uint64_t _count) {
+    T sum = T(0);
+    T timeScale = T(0.25f);
+    for (uint64_t i = 0; i < _count; i++) {
+      size_t j = size_t(i & 4095);
+      sum = sum + pathStep(T(39) + values[j], T(18) + values[(j + 1) & 4095], values[(j + 2) & 4095] + T(2), values[(j + 3) & 4095],
+                           T(int(i & 7)), timeScale);
+    }
+    bench::doNotOptimize(sum);
+  });
+}
+
+// A long CPU against CPU match at the game's tick rate
+static void setUp(Simulation &_sim) {
+  _sim.seed(1);
+  _sim.setTickRate(240);
+  _sim.autoServe = true;
+  _sim.winningScore = INT_MAX;
+  _sim.resetGame();
+  _sim.setMode(GameMode::HARD);
+  _sim.setPlayer1Cpu(GameMode::HARD);
+  _sim.serve();
+  _sim.start();
+}
+
+int main() {
+  const uint64_t TICKS = 2000000;
+  const uint64_t HASHED_TICKS = 100000;
+
+  bench::print(runPaths<float>("ball path float", 10000000));
+  bench::print(runPaths<Fixed>("ball path Q16.16", 10000000));
+
+#ifdef PONG_FIXED_POINT
+  const char *numbers = "Q16.16";
+#else
+  const char *numbers = "float";
+#endif
+  printf("\nsimulation built with %s\n", numbers);
+  bench::print(bench::run("Simulation::tick", TICKS, [](uint64_t _ticks) {
+    Simulation sim;
+    setUp(sim);
+    for (uint64_t i = 0; i < _ticks; i++) sim.tick(Inputs());
+    bench::doNotOptimize(sim.ball);
+  }));
+
+  // Chain the state after every tick into one hash, any tick that differs changes it
+  Simulation sim;
+  setUp(sim);
+  uint64_t hash = 0;
+  for (uint64_t i = 0; i < HASHED_TICKS; i++) {
+    sim.tick(Inputs());
+    hash = (hash ^ hashState(sim)) * 1099511628211ull;
+  }
+  printf("state hash of %llu ticks: %016llx\n", (unsigned long long)HASHED_TICKS, (unsigned long long)hash);
+  return 0;
+}
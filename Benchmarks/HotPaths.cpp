@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Times the paths the game runs every tick and every frame: moving the ball, bouncing it off a wall or a paddle,
+// clamping its velocity, each CPU difficulty steering, and rendering a frame into memory. Runs without a console and
+// can write its results as JSON so two runs can be compared.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Banners.h"
+#include "Pong/Screen.h"
+#include "Pong/Simulation.h"
+
+using namespace pong;
+
+static void printUsage() {
+  printf(
+      "Usage: pong_bench [options]\n"
+      "  --json PATH      Also write the results to PATH as JSON\n"
+      "  --filter TEXT    Only run the benchmarks whose name contains TEXT\n");
+}
+
+static void setUpRally(Simulation &_sim) {
+  // Two players who never touch their keys, so a tick is only the ball
+  _sim.seed(1);
+  _sim.resetGame();
+  _sim.setMode(GameMode::MULTIPLAYER);
+  _sim.serve();
+  _sim.start();
+}
+
+static void placeBall(Simulation &_sim, int _x, int _y, Real _vx, Real _vy) {
+  _sim.ball.setAbsPosition(_x, _y, _sim);
+  _sim.ball.setVelocities(_vx, _vy, _sim);
+  _sim.gameState = GameState::IN_PLAY;
+}
+
+static void drawFrame(Screen &_screen, const Simulation &_sim, int _ballX, int _ballY) {
+  // The game's in play frame: borders, the score line, both paddles, the ball and a banner over the field
+  int width = _screen.getWidth(), height = _screen.getHeight() - 1;
+  for (int y = 0; y <= height; y++) {
+    char glyph = (y == 0 || y == 2 || y == height) ? '-' : ' ';
+    for (int x = 0; x < width; x++) _screen.put(x, y, glyph, COLOUR_WHITE);
+  }
+  _screen.setCursorPosition(0, 1);
+  _screen.print("Player 1 Score: 3 | CPU Score: 4");
+  for (int i = -2; i <= 2; i++) {
+    _screen.put(0, int(_sim.player1.getY()) + i, 'I', COLOUR_AQUA);
+    _screen.put(width - 1, int(_sim.cpu.getY()) + i, 'I', COLOUR_AQUA);
+  }
+  _screen.blit((width - BANNER_WIDTH) / 2, 8, &HARD_BANNER.glyphs[0][0], BANNER_WIDTH, 7, COLOUR_RED);
+  _screen.put(_ballX, _ballY, 'O', COLOUR_GREEN);
+}
+
+int main(int argc, char **argv) {
+  const char *jsonPath = NULL;
+  const char *filter = "";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+      filter = argv[++i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  std::vector<bench::Result> results;
+  auto run = [&](const char *_name, uint64_t _ops, auto &&_body) {
+    if (!strstr(_name, filter)) return;
+    results.push_back(bench::run(_name, _ops, _body));
+    bench::print(results.back());
+  };
+
+  // Ball integration, flying across the middle with nothing to hit, placed again every 16 ticks
+  Simulation sim;
+  setUpRally(sim);
+  run("tick/flight", 1000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      if (i % 16 == 0) placeBall(sim, 20, 19, Real(2), Real(0.25f));
+      bench::doNotOptimize(sim.tick(Inputs()));
+    }
+  });
+
+  // Collisions, a tick where the ball meets the top wall and one where it's returned by player 1's paddle
+  run("tick/wall_bounce", 1000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      placeBall(sim, 39, 4, Real(1), Real(-1.5f));
+      bench::doNotOptimize(sim.tick(Inputs()));
+    }
+  });
+  run("tick/paddle_return", 1000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      placeBall(sim, 2, int(sim.player1.getY()), Real(-1.5f), Real(0));
+      bench::doNotOptimize(sim.tick(Inputs()));
+    }
+  });
+
+  // Velocity clamping when the ball's velocity is set, with speeds inside and outside every limit
+  Real velocities[64][2];
+  for (int i = 0; i < 64; i++) {
+    velocities[i][0] = Real(float((i * 37) % 64 - 32) / 8.0f);
+    velocities[i][1] = Real(float((i * 23) % 64 - 32) / 8.0f);
+  }
+  run("clamp/velocity", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      const Real *velocity = velocities[i % 64];
+      sim.ball.setVelocities(velocity[0], velocity[1], sim);
+      bench::doNotOptimize(sim.ball.getXVelocity());
+    }
+  });
+
+  // Each CPU steering through a run of approaches, predicting each one once it has reacted to it
+  const int APPROACHES = 256, APPROACH_TICKS = 32;
+  Real      approaches[APPROACHES][4];
+  Random    random(7);
+  for (int i = 0; i < APPROACHES; i++) {
+    approaches[i][0] = Real(random.nextFloat(10, 40));
+    approaches[i][1] = Real(random.nextFloat(4, 33));
+    approaches[i][2] = Real(random.nextFloat(0.5f, 2));
+    approaches[i][3] = Real(random.nextFloat(-1.5f, 1.5f));
+  }
+  const GameMode difficulties[] = {GameMode::EASY, GameMode::MEDIUM, GameMode::HARD, GameMode::IMPOSSIBLE};
+  const char *   names[] = {"cpu/easy", "cpu/medium", "cpu/hard", "cpu/impossible"};
+  for (int d = 0; d < 4; d++) {
+    CpuPlayer cpu;
+    cpu.setProfile(Simulation::cpuProfile(difficulties[d]));
+    cpu.setRandom(Random(1));
+    CpuField field;
+    Real     paddleY = 19;
+    run(names[d], 1000000, [&](uint64_t _count) {
+      for (uint64_t i = 0; i < _count; i++) {
+        uint32_t    target = uint32_t(i / APPROACH_TICKS);
+        const Real *ball = approaches[target % APPROACHES];
+        Real        age = Real(int(i % APPROACH_TICKS));
+        paddleY = cpu.steer(paddleY, true, target, ball[0] + ball[2] * age, ball[1], ball[2], ball[3], field);
+        bench::doNotOptimize(paddleY);
+      }
+    });
+  }
+
+  // Rendering into memory, every cell of a frame and then a frame where only the ball moved
+  Screen screen;
+  screen.resize(sim.width, sim.height + 1);
+  size_t fullBytes = 0, moveBytes = 0;
+  run("render/full_frame", 100000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      drawFrame(screen, sim, 39, 19);
+      screen.invalidate();
+      fullBytes = screen.present().size();
+    }
+  });
+  run("render/ball_move", 100000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      drawFrame(screen, sim, 20 + int(i % 40), 19);
+      moveBytes = screen.present().size();
+    }
+  });
+  if (fullBytes) printf("\nframe output:    %zu bytes full, %zu bytes when the ball moves\n", fullBytes, moveBytes);
+
+  if (jsonPath && !bench::writeJson(jsonPath, results)) {
+    fprintf(stderr, "Can't write %s\n", jsonPath);
+    return 1;
+  }
+  return 0;
+}
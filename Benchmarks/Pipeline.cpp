@@ -0,0 +1,192 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+
+// Plays the game's frame loop against a terminal that takes as long to write to as one at the far end of a slow SSH
+// connection, once showing frames on the game's thread and once through the render thread, and reports how late the
+// physics ticks ran and how steady the frames were each way.
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/FramePipeline.h"
+#include "Pong/Simulation.h"
+
+using namespace pong;
+using namespace std::chrono;
+
+// A terminal that blocks on every frame for a base delay plus some random jitter, like writing over a slow link
+class SlowTerminal : public Terminal {
+ public:  // Constructor
+  SlowTerminal(double _delayMs, double _jitterMs) : delayMs(_delayMs), jitterMs(_jitterMs), random(3) {}
+
+ public:  // Terminal
+  bool open(int, int) override {
+    return true;
+  }
+  void close() override {}
+  void present(const std::string &_frame) override {
+    std::this_thread::sleep_for(duration<double, std::milli>(delayMs + random.nextFloat(0, float(jitterMs))));
+    stats.frames++;
+    stats.syscalls++;
+    stats.bytes += _frame.size();
+    stats.syscallsLastFrame = 1;
+  }
+  void setTitle(const char *) override {}
+
+ private:  // Data
+  double delayMs, jitterMs;  // How long each frame blocks for
+  Random random;             // Picks the jitter
+};
+
+// What a run of the frame loop measured
+struct LoopResult {
+  std::vector<double>  intervals;  // Milliseconds between one frame's ticks and the next's
+  std::vector<double>  lateness;   // Milliseconds each tick ran after the moment it stands for
+  FramePipeline::Stats output;     // What was shown
+};
+
+static void printUsage() {
+  printf(
+      "Usage: pong_bench_pipeline [options]\n"
+      "  --seconds N      How long to play each way (default 5)\n"
+      "  --delay MS       Time every frame takes to write (default 8)\n"
+      "  --jitter MS      Extra random time up to this much per frame (default 12)\n");
+}
+
+static void drawFrame(Screen &_screen, const Simulation &_sim) {
+  // Borders, both paddles and the ball, which is most of what changes from frame to frame in play
+  int width = _screen.getWidth(), height = _screen.getHeight() - 1;
+  for (int y = 0; y <= height; y++) {
+    char glyph = (y == 0 || y == 2 || y == height) ? '-' : ' ';
+    for (int x = 0; x < width; x++) _screen.put(x, y, glyph, COLOUR_WHITE);
+  }
+  for (int i = -2; i <= 2; i++) {
+    _screen.put(0, int(_sim.player1.getY()) + i, 'I', COLOUR_AQUA);
+    _screen.put(width - 1, int(_sim.cpu.getY()) + i, 'I', COLOUR_AQUA);
+  }
+  _screen.put(int(_sim.ball.getX()), int(_sim.ball.getY()), 'O', COLOUR_GREEN);
+}
+
+static LoopResult playLoop(double _seconds, double _delayMs, double _jitterMs, bool _threaded) {
+  const double PHYSICS_RATE = 240, RENDER_RATE = 60;
+  SlowTerminal terminal(_delayMs, _jitterMs);
+  LoopResult   result;
+  {
+    FramePipeline pipeline(terminal);
+    if (_threaded) pipeline.start();
+
+    // Two CPUs playing forever at the game's rates
+    Simulation sim;
+    sim.seed(1);
+    sim.setTickRate(float(PHYSICS_RATE));
+    sim.autoServe = true;
+    sim.winningScore = INT_MAX;
+    sim.resetGame();
+    sim.setMode(GameMode::HARD);
+    sim.setPlayer1Cpu(GameMode::HARD);
+    sim.serve();
+    sim.start();
+    Screen screen(sim.width, sim.height + 1);
+
+    // The game's loop: bank real time, tick at a fixed rate until caught up, draw, show and wait for the next frame
+    double            tickSeconds = 1.0 / PHYSICS_RATE, accumulator = 0;
+    Clock::time_point startTime = Clock::now(), loopStartTime = startTime, nextFrameTime = startTime;
+    while (Clock::now() - startTime < duration<double>(_seconds)) {
+      Clock::time_point loopEndTime = Clock::now();
+      if (loopStartTime != startTime) result.intervals.push_back(duration<double, std::milli>(loopEndTime - loopStartTime).count());
+      accumulator = std::min(accumulator + duration<double>(loopEndTime - loopStartTime).count(), 0.25);
+      loopStartTime = loopEndTime;
+      Clock::time_point tickEndTime = loopEndTime - duration_cast<Clock::duration>(duration<double>(accumulator));
+      while (accumulator >= tickSeconds) {
+        accumulator -= tickSeconds;
+        tickEndTime += duration_cast<Clock::duration>(duration<double>(tickSeconds));
+        sim.tick(Inputs());
+        result.lateness.push_back(duration<double, std::milli>(Clock::now() - tickEndTime).count());
+      }
+      drawFrame(screen, sim);
+      pipeline.publish(screen);
+      nextFrameTime += duration_cast<Clock::duration>(duration<double>(1.0 / RENDER_RATE));
+      if (nextFrameTime < Clock::now()) nextFrameTime = Clock::now();
+      waitUntil(nextFrameTime);
+    }
+    pipeline.stop();
+    result.output = pipeline.getStats();
+  }
+  return result;
+}
+
+static void printSamples(const char *_label, std::vector<double> &_samples) {
+  // Mean, standard deviation and tail of a set of times in milliseconds
+  double mean = 0, variance = 0;
+  for (double value : _samples) mean += value;
+  mean /= double(_samples.empty() ? 1 : _samples.size());
+  for (double value : _samples) variance += (value - mean) * (value - mean);
+  variance /= double(_samples.empty() ? 1 : _samples.size());
+  std::sort(_samples.begin(), _samples.end());
+  double p99 = _samples.empty() ? 0 : _samples[_samples.size() * 99 / 100];
+  double max = _samples.empty() ? 0 : _samples.back();
+  printf("  %-15s%6zu, mean %6.2f ms, stddev %6.2f ms, p99 %6.2f ms, max %6.2f ms\n", _label, _samples.size(), mean, sqrt(variance),
+         p99, max);
+}
+
+static void printResult(const char *_name, LoopResult &_result) {
+  const FramePipeline::Stats &output = _result.output;
+  printf("%s\n", _name);
+  printSamples("tick batches:", _result.intervals);
+  printSamples("tick lateness:", _result.lateness);
+  printf("  shown:         %llu of %llu published, %llu skipped, publish max %.1f us\n", (unsigned long long)output.shown,
+         (unsigned long long)output.published, (unsigned long long)output.skipped, output.maxPublishNs / 1000.0);
+}
+
+int main(int argc, char **argv) {
+  double seconds = 5, delayMs = 8, jitterMs = 12;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--seconds") && hasValue) {
+      seconds = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--delay") && hasValue) {
+      delayMs = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--jitter") && hasValue) {
+      jitterMs = atof(argv[++i]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // Handing a frame over is all the game's thread pays for once there's a render thread
+  Screen screen(79, 36);
+  SlowTerminal  fastTerminal(0, 0);
+  FramePipeline handOver(fastTerminal);
+  handOver.start();
+  bench::print(bench::run("FramePipeline::publish", 10000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) handOver.publish(screen);
+  }));
+  handOver.stop();
+
+  printf("\nterminal:        %.1f ms per frame plus up to %.1f ms jitter, %.1f s each way\n\n", delayMs, jitterMs, seconds);
+  LoopResult serial = playLoop(seconds, delayMs, jitterMs, false);
+  printResult("game thread", serial);
+  LoopResult threaded = playLoop(seconds, delayMs, jitterMs, true);
+  printResult("render thread", threaded);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Measures what a profiled scope costs with and without a profiler installed, and what profiling does to the cost of
+// a simulation tick. Build with -DPONG_PROFILER, without it every scope is compiled out and the ticks match.
+
+#include <climits>
+#include <cstdio>
+#include <memory>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Simulation.h"
+
+using namespace pong;
+
+static void setUp(Simulation &_sim) {
+  _sim.seed(1);
+  _sim.autoServe = true;
+  _sim.winningScore = INT_MAX;
+  _sim.resetGame();
+  _sim.setMode(GameMode::HARD);
+  _sim.setPlayer1Cpu(GameMode::HARD);
+  _sim.serve();
+  _sim.start();
+}
+
+int main() {
+#ifndef PONG_PROFILER
+  printf("PONG_PROFILER is off, scopes are compiled out\n");
+#endif
+  std::unique_ptr<Profiler> profiler(new Profiler());
+
+  // A scope on a thread nobody is profiling only checks for a profiler
+  bench::print(bench::run("scope, not installed", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      PONG_PROFILE(PHASE_BALL);
+      bench::doNotOptimize(i);
+    }
+  }));
+
+  Simulation sim;
+  setUp(sim);
+  bench::print(bench::run("Simulation::tick, not installed", 1000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) bench::doNotOptimize(sim.tick(Inputs()));
+  }));
+
+  // Installed, each scope reads the clock twice and records into a histogram and the rings
+  profiler->install();
+  bench::print(bench::run("scope, installed", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      PONG_PROFILE(PHASE_BALL);
+      bench::doNotOptimize(i);
+    }
+  }));
+  bench::print(bench::run("Simulation::tick, installed", 1000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      bench::doNotOptimize(sim.tick(Inputs()));
+      if (i % 4 == 3) PONG_PROFILE_FRAME();
+    }
+  }));
+
+  // Recording straight into a histogram, and reading a percentile back out
+  HdrHistogram histogram;
+  uint64_t     value = 1;
+  bench::print(bench::run("HdrHistogram::record", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      value = value * 6364136223846793005ull + 1442695040888963407ull;
+      histogram.record(value >> 44);
+    }
+  }));
+  bench::print(bench::run("HdrHistogram::percentile", 10000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) bench::doNotOptimize(histogram.percentile(0.99));
+  }));
+
+  const HdrHistogram &ball = profiler->getHistogram(PHASE_BALL);
+  printf("\nball phase: %llu scopes, p50 %llu ns, p99 %llu ns, max %llu ns\n", (unsigned long long)ball.getCount(),
+         (unsigned long long)ball.percentile(0.50), (unsigned long long)ball.percentile(0.99), (unsigned long long)ball.getMax());
+  return 0;
+}
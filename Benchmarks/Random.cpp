@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Compares the game's old rand() floats with the per game xoshiro256** generator, on one thread and on many
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Random.h"
+
+using namespace pong;
+
+// The float the game used to draw, from the shared C library generator
+static float randFloat(float _low, float _high) {
+  float random = float(rand()) / float(RAND_MAX);
+  return _low + random * (_high - _low);
+}
+
+// Run _body(thread, numbers) on _threads threads at once, each drawing _numbers numbers
+template <typename Body>
+static bench::Result runThreads(const char *_name, size_t _threads, uint64_t _numbers, Body &&_body) {
+  return bench::run(_name, _numbers * _threads, [&](uint64_t) {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < _threads; t++) threads.emplace_back([&, t] { _body(t, _numbers); });
+    for (std::thread &thread : threads) thread.join();
+  });
+}
+
+int main(int argc, char **argv) {
+  const uint64_t NUMBERS = 10000000;
+  size_t         threadCount = (argc > 1) ? size_t(atoi(argv[1])) : size_t(std::thread::hardware_concurrency());
+  if (threadCount < 1) threadCount = 1;
+
+  printf("one thread\n");
+  bench::print(bench::run("rand() float", NUMBERS, [](uint64_t _numbers) {
+    float sum = 0;
+    for (uint64_t i = 0; i < _numbers; i++) sum += randFloat(-1, 1);
+    bench::doNotOptimize(sum);
+  }));
+  bench::print(bench::run("Random::nextFloat", NUMBERS, [](uint64_t _numbers) {
+    Random random(1);
+    float  sum = 0;
+    for (uint64_t i = 0; i < _numbers; i++) sum += random.nextFloat(-1, 1);
+    bench::doNotOptimize(sum);
+  }));
+  std::vector<float> batch(4096);
+  bench::print(bench::run("Random::fill", NUMBERS, [&](uint64_t _numbers) {
+    Random random(1);
+    for (uint64_t i = 0; i < _numbers; i += batch.size()) {
+      random.fill(batch.data(), batch.size(), -1, 1);
+      bench::doNotOptimize(batch[0]);
+    }
+  }));
+
+  // rand() shares one generator between threads, each game owns its own Random and never waits on the others
+  printf("\n%zu threads\n", threadCount);
+  bench::print(runThreads("rand() float", threadCount, NUMBERS / threadCount, [](size_t, uint64_t _numbers) {
+    float sum = 0;
+    for (uint64_t i = 0; i < _numbers; i++) sum += randFloat(-1, 1);
+    bench::doNotOptimize(sum);
+  }));
+  bench::print(runThreads("Random::nextFloat", threadCount, NUMBERS / threadCount, [](size_t _thread, uint64_t _numbers) {
+    Random random(_thread + 1);
+    float  sum = 0;
+    for (uint64_t i = 0; i < _numbers; i++) sum += random.nextFloat(-1, 1);
+    bench::doNotOptimize(sum);
+  }));
+  return 0;
+}
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Times what recording costs each tick against the game's 240 Hz tick period, and times seeking in a recording
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Replay.h"
+
+using namespace pong;
+
+static const char *PATH = "bench_replay.tmp";
+static const double TICK_PERIOD_NS = 1e9 / 240;  // How often the game ticks
+
+// A long match that never ends, the way the game plays at 240 ticks per second
+static void setUp(Simulation &_sim) {
+  _sim.seed(1);
+  _sim.setTickRate(240);
+  _sim.autoServe = true;
+  _sim.winningScore = INT_MAX;
+  _sim.resetGame();
+  _sim.setMode(GameMode::HARD);
+  _sim.serve();
+  _sim.start();
+}
+
+int main() {
+  const uint64_t TICKS = 2000000;
+
+  // Key holds like a person makes, changing every few ticks
+  std::vector<Inputs> inputs(TICKS);
+  uint32_t            state = 1;
+  Inputs              held;
+  for (uint64_t i = 0; i < TICKS; i++) {
+    state = state * 214013u + 2531011u;
+    if ((state >> 16) % 8 == 0) held.player1 = int8_t(int((state >> 20) % 3 - 1) * Inputs::FULL_TICK);
+    inputs[i] = held;
+  }
+
+  // Time the writer on its own, taking turns with plain ticks so slow and fast spells of the machine hit both. The
+  // match stands still while recording so only the writer is timed, its keyframes save a state of the same size.
+  const int           ROUNDS = 15;
+  std::vector<double> writing, playing;
+  for (int round = 0; round <= ROUNDS; round++) {
+    Simulation   still;
+    ReplayWriter writer;
+    setUp(still);
+    writer.begin(PATH, still, 1);
+    auto startTime = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < TICKS; i++) writer.tick(inputs[i]);
+    double writeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+    writer.finish();
+
+    Simulation sim;
+    setUp(sim);
+    startTime = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < TICKS; i++) sim.tick(inputs[i]);
+    bench::doNotOptimize(sim.ball);
+    double playNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+
+    // The first round only warms up
+    if (round == 0) continue;
+    writing.push_back(writeNs / double(TICKS));
+    playing.push_back(playNs / double(TICKS));
+  }
+  bench::Result record = bench::summarize("ReplayWriter::tick", TICKS, writing);
+  bench::print(bench::summarize("Simulation::tick", TICKS, playing));
+  bench::print(record);
+  printf("recording: %.5f%% of the %.2f ms tick period (best %.5f%%)\n\n", 100.0 * record.nsPerOp / TICK_PERIOD_NS,
+         TICK_PERIOD_NS / 1e6, 100.0 * record.minNsPerOp / TICK_PERIOD_NS);
+
+  // Record a real match to seek in
+  {
+    Simulation   sim;
+    ReplayWriter writer;
+    setUp(sim);
+    writer.begin(PATH, sim, 1);
+    for (uint64_t i = 0; i < TICKS; i++) {
+      writer.tick(inputs[i]);
+      sim.tick(inputs[i]);
+    }
+    if (!writer.finish()) return 1;
+  }
+
+  // Seek to spread out ticks, each costs a binary search and at most one keyframe interval of ticks
+  ReplayFile replay;
+  if (!replay.open(PATH)) return 1;
+  printf("replay: %llu ticks, %llu bytes, %llu keyframes\n", (unsigned long long)replay.getTicks(),
+         (unsigned long long)replay.getSize(), (unsigned long long)replay.getKeyframeCount());
+  bench::print(bench::run("ReplayFile::seek", 1000, [&](uint64_t _seeks) {
+    Simulation sim;
+    for (uint64_t i = 0; i < _seeks; i++) replay.seek(sim, (i * 7919 * 1031) % TICKS);
+    bench::doNotOptimize(sim.ball);
+  }));
+  replay.close();
+  remove(PATH);
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+
+// Checks that the compact state's step() plays exactly as Simulation::tick, times cloning and stepping it, counts the
+// nodes the expert searches each tick, then plays the expert against the hard CPU and the hard CPU against itself.
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/SearchPlayer.h"
+
+using namespace pong;
+
+static void setUp(Simulation &_sim, uint64_t _seed, GameMode _opponent) {
+  // Endless rallies at the game's physics rate with player 1 left to the inputs
+  _sim.seed(_seed);
+  _sim.setTickRate(240);
+  _sim.autoServe = true;
+  _sim.winningScore = INT_MAX;
+  _sim.resetGame();
+  _sim.setMode(_opponent);
+  _sim.serve();
+  _sim.start();
+}
+
+static bool sameState(CompactState _a, CompactState _b) {
+  // Field by field, the padding between them is never written. Copies so the generators can be drawn from
+  return _a.random.next() == _b.random.next() && _a.ballX == _b.ballX && _a.ballY == _b.ballY && _a.ballVX == _b.ballVX &&
+         _a.ballVY == _b.ballVY && _a.originX == _b.originX && _a.originY == _b.originY && _a.pathOffset == _b.pathOffset &&
+         _a.pathTicks == _b.pathTicks && !memcmp(_a.paddleY, _b.paddleY, sizeof(_a.paddleY)) &&
+         !memcmp(_a.score, _b.score, sizeof(_a.score)) && _a.flags == _b.flags && _a.gameMode == _b.gameMode &&
+         _a.gameState == _b.gameState;
+}
+
+static uint64_t checkStep(GameMode _mode, uint64_t _ticks) {
+  // Both paddles on random keys, returns the tick the two first disagree at or 0 when they never do
+  Simulation sim;
+  setUp(sim, 11, _mode);
+  StepRules    rules = StepRules::capture(sim);
+  CompactState state = CompactState::capture(sim);
+  Random       keys(3);
+  for (uint64_t tick = 1; tick <= _ticks; tick++) {
+    Inputs inputs;
+    inputs.player1 = int8_t(int(keys.next() % 255) - Inputs::FULL_TICK);
+    inputs.player2 = int8_t(int(keys.next() % 255) - Inputs::FULL_TICK);
+    uint32_t simEvents = sim.tick(inputs);
+    uint32_t stepEvents = step(state, inputs, rules);
+    if (simEvents != stepEvents || !sameState(CompactState::capture(sim), state)) return tick;
+  }
+  return 0;
+}
+
+static void playMatch(const char *_name, bool _expert, int _points, const SearchBudget &_budget) {
+  // Player 1 is the hard CPU, the opponent either the expert or another hard CPU, played for a number of points
+  Simulation sim;
+  setUp(sim, 5, _expert ? GameMode::EXPERT : GameMode::HARD);
+  sim.setPlayer1Cpu(GameMode::HARD);
+  SearchPlayer expert;
+  expert.setBudget(_budget);
+  uint64_t ticks = 0;
+  while (sim.player1.getScore() + sim.cpu.getScore() < _points) {
+    Inputs inputs;
+    if (_expert) inputs.player2 = expert.choose(sim);
+    sim.tick(inputs);
+    ticks++;
+  }
+  printf("%-22s hard CPU %3d - %3d %s over %llu ticks\n", _name, sim.player1.getScore(), sim.cpu.getScore(),
+         _expert ? "expert" : "hard CPU", (unsigned long long)ticks);
+}
+
+int main(int argc, char **argv) {
+  int          points = 10;
+  SearchBudget budget;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--points") && i + 1 < argc) {
+      points = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--budget") && i + 1 < argc) {
+      budget.microseconds = atoi(argv[++i]);
+    } else {
+      printf("Usage: bench_search [--points N] [--budget MICROSECONDS]\n");
+      return 1;
+    }
+  }
+
+  // step() has to play the same game as the simulation or the search plans for a different one
+  const GameMode modes[] = {GameMode::MULTIPLAYER, GameMode::EXPERT};
+  for (GameMode mode : modes) {
+    uint64_t badTick = checkStep(mode, 1000000);
+    printf("step vs tick, %-11s %s", mode == GameMode::EXPERT ? "expert:" : "multiplayer:", badTick ? "differ at tick " : "identical\n");
+    if (badTick) {
+      printf("%llu\n", (unsigned long long)badTick);
+      return 1;
+    }
+  }
+  printf("compact state:   %zu bytes, simulation %zu bytes\n\n", sizeof(CompactState), sizeof(Simulation));
+
+  // Cloning and stepping, the two things a rollout does
+  Simulation sim;
+  setUp(sim, 1, GameMode::EXPERT);
+  StepRules    rules = StepRules::capture(sim);
+  CompactState root = CompactState::capture(sim);
+  bench::print(bench::run("CompactState clone", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      CompactState clone = root;
+      clone.pathTicks += uint32_t(i);
+      bench::doNotOptimize(clone);
+    }
+  }));
+  bench::print(bench::run("Simulation copy", 100000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      Simulation copy = sim;
+      bench::doNotOptimize(copy.ball);
+    }
+  }));
+  CompactState state = root;
+  bench::print(bench::run("step", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) bench::doNotOptimize(step(state, Inputs(), rules));
+  }));
+
+  // The search itself, over a rally against the hard CPU
+  Simulation rally;
+  setUp(rally, 2, GameMode::EXPERT);
+  rally.setPlayer1Cpu(GameMode::HARD);
+  SearchPlayer expert;
+  expert.setBudget(budget);
+  for (int tick = 0; tick < 2400; tick++) {
+    Inputs inputs;
+    inputs.player2 = expert.choose(rally);
+    rally.tick(inputs);
+  }
+  const SearchPlayer::Stats &stats = expert.getStats();
+  double seconds = double(stats.searchNs) / 1e9;
+  printf("\nsearch:          %.0f nodes/tick, %.0f rollouts/tick, %.0f us/tick\n", double(stats.nodes) / double(stats.decisions),
+         double(stats.rollouts) / double(stats.decisions), double(stats.searchNs) / 1e3 / double(stats.decisions));
+  printf("                 %.2f M clones/sec, %.2f M nodes/sec\n\n", double(stats.clones) / seconds / 1e6,
+         double(stats.nodes) / seconds / 1e6);
+
+  // What the search is worth, points against the hard CPU
+  playMatch("hard vs hard:", false, points, budget);
+  playMatch("hard vs expert:", true, points, budget);
+  return 0;
+}
@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Compares the old std::function shape callbacks with the compile time shape events
+
+#include <cstdio>
+#include <functional>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Simulation.h"
+
+using namespace pong;
+
+namespace legacy {
+
+  // The shapes as they were, with type erased callbacks and virtual drawing
+  class Shape {
+   public:  // Typedefs
+    typedef std::function<void(Shape *)> shapeCallback;
+
+   public:  // Constructor
+    Shape(int _width, int _height) : width(_width), height(_height) {}
+    virtual ~Shape() {}
+
+   public:  // Accessors
+    void setXPosition(float _xPosition, bool _fireEvents = true) {
+      if (_fireEvents && onBeforePositionEvent) onBeforePositionEvent(this);
+      x = _xPosition;
+      if (_fireEvents && onAfterPositionEvent) onAfterPositionEvent(this);
+    }
+    void setYPosition(float _yPosition, bool _fireEvents = true) {
+      if (_fireEvents && onBeforePositionEvent) onBeforePositionEvent(this);
+      y = _yPosition;
+      if (_fireEvents && onAfterPositionEvent) onAfterPositionEvent(this);
+    }
+    void setAbsPosition(int _xPosition, int _yPosition, bool _fireEvents = true) {
+      if (_fireEvents && onBeforePositionEvent) onBeforePositionEvent(this);
+      x = float(_xPosition);
+      y = float(_yPosition);
+      if (_fireEvents && onAfterPositionEvent) onAfterPositionEvent(this);
+    }
+    void setXVelocity(float _vx, bool _fireEvents = true) {
+      if (_fireEvents && onBeforeVelocityEvent) onBeforeVelocityEvent(this);
+      vx = _vx;
+      if (_fireEvents && onAfterVelocityEvent) onAfterVelocityEvent(this);
+    }
+    void setYVelocity(float _vy, bool _fireEvents = true) {
+      if (_fireEvents && onBeforeVelocityEvent) onBeforeVelocityEvent(this);
+      vy = _vy;
+      if (_fireEvents && onAfterVelocityEvent) onAfterVelocityEvent(this);
+    }
+    void setVelocities(float _vx, float _vy, bool _fireEvents = true) {
+      if (_fireEvents && onBeforeVelocityEvent) onBeforeVelocityEvent(this);
+      vx = _vx;
+      vy = _vy;
+      if (_fireEvents && onAfterVelocityEvent) onAfterVelocityEvent(this);
+    }
+
+   public:  // Draw Methods
+    virtual void draw(Screen *_screen) = 0;
+    virtual void clear(Screen *_screen) = 0;
+
+   public:  // Data
+    bool          visible = false;
+    int           width = 0, height = 0;
+    float         x = 0, y = 0;
+    float         vx = 0, vy = 0;
+    Position      position;
+    shapeCallback onBeforePositionEvent = [](Shape *) {};
+    shapeCallback onAfterPositionEvent = [](Shape *) {};
+    shapeCallback onBeforeVelocityEvent = [](Shape *) {};
+    shapeCallback onAfterVelocityEvent = [](Shape *) {};
+  };
+
+  class Player : public Shape {
+   public:
+    Player() : Shape(1, 5) {}
+    virtual void draw(Screen *) override {}
+    virtual void clear(Screen *) override {}
+  };
+
+  class Ball : public Shape {
+   public:
+    Ball() : Shape(1, 1) {}
+    virtual void draw(Screen *) override {}
+    virtual void clear(Screen *) override {}
+  };
+
+}  // namespace legacy
+
+// The same rally written against both kinds of shape: a paddle chasing the ball, wall and end bounces and the
+// velocity clamp on every bounce. The static shapes hold a Real like the simulation, so they follow PONG_FIXED_POINT
+static const int   WIDTH = 79, HEIGHT = 35;
+static const float MAX_X_SPEED = 3, MIN_X_SPEED = 2, MAX_Y_SPEED = 1.5f;
+
+struct LegacyRally {
+  legacy::Player paddle;
+  legacy::Ball   ball;
+
+  LegacyRally() {
+    paddle.onAfterPositionEvent = [](legacy::Shape *_this) {
+      legacy::Player *player = static_cast<legacy::Player *>(_this);
+      if (player->y < 3 + 2) player->setYPosition(5, false);
+      if (player->y > HEIGHT - 3) player->setYPosition(HEIGHT - 3, false);
+    };
+    ball.onAfterPositionEvent = [](legacy::Shape *_this) {
+      legacy::Ball *c_ball = static_cast<legacy::Ball *>(_this);
+      if ((c_ball->y < 3 && c_ball->vy < 0) || (c_ball->y > HEIGHT - 1 && c_ball->vy > 0)) {
+        c_ball->setAbsPosition(int(c_ball->x), c_ball->y < 3 ? 3 : HEIGHT - 1, false);
+        c_ball->setVelocities(c_ball->vx, -c_ball->vy * 1.1f);
+      }
+      if ((c_ball->x < 1 && c_ball->vx < 0) || (c_ball->x > WIDTH - 1 && c_ball->vx > 0)) {
+        c_ball->setAbsPosition(c_ball->x < 1 ? 1 : WIDTH - 2, int(c_ball->y), false);
+        c_ball->setVelocities(-c_ball->vx * 1.1f, c_ball->vy + 0.25f);
+      }
+    };
+    ball.onAfterVelocityEvent = [](legacy::Shape *_this) {
+      legacy::Ball *c_ball = static_cast<legacy::Ball *>(_this);
+      c_ball->setXVelocity((c_ball->vx > MAX_X_SPEED) ? MAX_X_SPEED : c_ball->vx, false);
+      c_ball->setXVelocity((c_ball->vx < -MAX_X_SPEED) ? -MAX_X_SPEED : c_ball->vx, false);
+      c_ball->setXVelocity((c_ball->vx > -MIN_X_SPEED && c_ball->vx < 0) ? -MIN_X_SPEED : c_ball->vx, false);
+      c_ball->setXVelocity((c_ball->vx < MIN_X_SPEED && c_ball->vx > 0) ? MIN_X_SPEED : c_ball->vx, false);
+      c_ball->setYVelocity((c_ball->vy > MAX_Y_SPEED) ? MAX_Y_SPEED : c_ball->vy, false);
+      c_ball->setYVelocity((c_ball->vy < -MAX_Y_SPEED) ? -MAX_Y_SPEED : c_ball->vy, false);
+    };
+    paddle.setAbsPosition(0, HEIGHT / 2);
+    ball.setAbsPosition(WIDTH / 2, HEIGHT / 2);
+    ball.setVelocities(2.5f, 0.7f);
+  }
+  void tick() {
+    paddle.setYPosition(paddle.y + (ball.y - paddle.y) * 0.3f);
+    ball.setXPosition(ball.x + ball.vx, false);
+    ball.setYPosition(ball.y + ball.vy);
+  }
+};
+
+struct StaticRally {
+  Player paddle;
+  Ball   ball;
+
+  // The shape events, resolved at compile time
+  template <typename S>
+  void beforePositionChange(S &) {}
+  template <typename S>
+  void beforeVelocityChange(S &) {}
+  void afterVelocityChange(Player &) {}
+  void afterPositionChange(Player &_player) {
+    if (_player.getY() < 3 + 2) _player.setYPosition(5);
+    if (_player.getY() > HEIGHT - 3) _player.setYPosition(HEIGHT - 3);
+  }
+  void afterPositionChange(Ball &_ball) {
+    Real x = _ball.getX(), y = _ball.getY(), vx = _ball.getXVelocity(), vy = _ball.getYVelocity();
+    if ((y < 3 && vy < 0) || (y > HEIGHT - 1 && vy > 0)) {
+      _ball.setAbsPosition(int(x), y < 3 ? 3 : HEIGHT - 1);
+      _ball.setVelocities(vx, -vy * Real(1.1f), *this);
+    }
+    x = _ball.getX(), y = _ball.getY(), vx = _ball.getXVelocity(), vy = _ball.getYVelocity();
+    if ((x < 1 && vx < 0) || (x > WIDTH - 1 && vx > 0)) {
+      _ball.setAbsPosition(x < 1 ? 1 : WIDTH - 2, int(y));
+      _ball.setVelocities(-vx * Real(1.1f), vy + Real(0.25f), *this);
+    }
+  }
+  void afterVelocityChange(Ball &_ball) {
+    Real vx = _ball.getXVelocity(), vy = _ball.getYVelocity();
+    Real maxX = Real(MAX_X_SPEED), minX = Real(MIN_X_SPEED), maxY = Real(MAX_Y_SPEED);
+    if (vx > maxX) vx = maxX;
+    if (vx < -maxX) vx = -maxX;
+    if (vx > -minX && vx < 0) vx = -minX;
+    if (vx < minX && vx > 0) vx = minX;
+    if (vy > maxY) vy = maxY;
+    if (vy < -maxY) vy = -maxY;
+    _ball.setVelocities(vx, vy);
+  }
+
+  StaticRally() {
+    paddle.setAbsPosition(0, HEIGHT / 2, *this);
+    ball.setAbsPosition(WIDTH / 2, HEIGHT / 2, *this);
+    ball.setVelocities(Real(2.5f), Real(0.7f), *this);
+  }
+  void tick() {
+    paddle.setYPosition(paddle.getY() + (ball.getY() - paddle.getY()) * Real(0.3f), *this);
+    ball.setXPosition(ball.getX() + ball.getXVelocity());
+    ball.setYPosition(ball.getY() + ball.getYVelocity(), *this);
+  }
+};
+
+int main() {
+  const uint64_t TICKS = 20000000;
+
+  printf("sizeof(Ball):        legacy %zu bytes, static %zu bytes\n", sizeof(legacy::Ball), sizeof(Ball));
+  printf("sizeof(Player):      legacy %zu bytes, static %zu bytes\n", sizeof(legacy::Player), sizeof(Player));
+  printf("sizeof(Simulation):  %zu bytes\n\n", sizeof(Simulation));
+
+  bench::print(bench::run("rally tick, std::function", TICKS, [](uint64_t _ticks) {
+    LegacyRally rally;
+    for (uint64_t i = 0; i < _ticks; i++) rally.tick();
+    bench::doNotOptimize(rally.ball.x);
+  }));
+  bench::print(bench::run("rally tick, static events", TICKS, [](uint64_t _ticks) {
+    StaticRally rally;
+    for (uint64_t i = 0; i < _ticks; i++) rally.tick();
+    bench::doNotOptimize(rally.ball);
+  }));
+
+  // The whole simulation for reference, CPU against CPU
+  bench::print(bench::run("Simulation::tick", TICKS, [](uint64_t _ticks) {
+    Simulation sim;
+    sim.autoServe = true;
+    sim.setMode(GameMode::HARD);
+    sim.setPlayer1Cpu(GameMode::HARD);
+    Inputs inputs;
+    for (uint64_t i = 0; i < _ticks; i++) {
+      if (sim.gameState != GameState::IN_PLAY) {
+        sim.resetGame();
+        sim.setMode(GameMode::HARD);
+        sim.serve();
+        sim.start();
+      }
+      sim.tick(inputs);
+    }
+    bench::doNotOptimize(sim.ball);
+  }));
+  return 0;
+}
@@ -0,0 +1,207 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Broadcasts a match to a thousand local viewers, some of which read too slowly to keep up, and reports what each
+// tick's fan-out costs. Every viewer decodes its stream and has to end on the frame the server last published.
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/Spectator.h"
+
+using namespace pong;
+
+static const char *PATH = "bench_spectator.sock";
+
+// A viewer's end of the connection
+struct Viewer {
+  int              fd = -1;       // The socket
+  bool             slow = false;  // Only reads every SLOW_READ_TICKS ticks with a small receive buffer
+  SpectatorDecoder decoder;       // What the viewer has seen
+  SpectatorFrame   frame;         // The newest frame decoded
+};
+
+static void printUsage() {
+  printf(
+      "Usage: pong_bench_spectator [options]\n"
+      "  --clients N      Viewers to connect (default 1000)\n"
+      "  --ticks N        Ticks to broadcast (default 2000)\n"
+      "  --slow N         Every Nth viewer reads slowly, 0 for none (default 10)\n"
+      "  --tcp            Connect over TCP loopback instead of a Unix socket\n");
+}
+
+static int connectViewer(bool _tcp, uint16_t _port, bool _slow) {
+  int fd = socket(_tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  if (_slow) {
+    // Leave the server little room, so a slow viewer backs up into its queue quickly
+    int size = 2048;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  }
+  int result;
+  if (_tcp) {
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(_port);
+    result = connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+  } else {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, PATH);
+    result = connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+  }
+  if (result != 0) {
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+static void readViewer(Viewer &_viewer) {
+  uint8_t buffer[4096];
+  ssize_t size;
+  while ((size = recv(_viewer.fd, buffer, sizeof(buffer), 0)) > 0) {
+    _viewer.decoder.feed(buffer, size_t(size));
+    _viewer.decoder.next(_viewer.frame);
+  }
+}
+
+int main(int argc, char **argv) {
+  const uint64_t SLOW_READ_TICKS = 256;
+  int            clients = 1000;
+  uint32_t       ticks = 2000;
+  int            slowEvery = 10;
+  bool           tcp = false;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--clients") && hasValue) {
+      clients = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--ticks") && hasValue) {
+      ticks = uint32_t(strtoul(argv[++i], NULL, 10));
+    } else if (!strcmp(argv[i], "--slow") && hasValue) {
+      slowEvery = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--tcp")) {
+      tcp = true;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // A match between two CPUs at the game's tick rate
+  Simulation sim;
+  sim.seed(1);
+  sim.setTickRate(60);
+  sim.autoServe = true;
+  sim.winningScore = INT_MAX;
+  sim.resetGame();
+  sim.setMode(GameMode::HARD);
+  sim.setPlayer1Cpu(GameMode::HARD);
+  sim.serve();
+  sim.start();
+
+  // Encoding is paid once per tick whatever the audience
+  SpectatorEncoder encoder;
+  uint32_t         encodeTick = 0;
+  bench::print(bench::run("SpectatorEncoder::encode", 1000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      encoder.encode(SpectatorFrame::capture(sim, encodeTick++));
+      bench::doNotOptimize(encoder.getDelta());
+    }
+  }));
+
+  SpectatorServer server;
+  if (tcp ? !server.listenTcp(0) : !server.listenUnix(PATH)) {
+    fprintf(stderr, "Can't listen for spectators\n");
+    return 1;
+  }
+
+  // Connect everyone and let the server accept them before the match starts
+  std::vector<Viewer> viewers(clients > 0 ? size_t(clients) : 0);
+  for (int i = 0; i < clients; i++) {
+    viewers[i].slow = slowEvery > 0 && i % slowEvery == slowEvery - 1;
+    viewers[i].fd = connectViewer(tcp, server.getTcpPort(), viewers[i].slow);
+    if (viewers[i].fd < 0) {
+      fprintf(stderr, "Can't connect viewer %d, try raising the open file limit\n", i);
+      return 1;
+    }
+    server.service(0);
+  }
+  while (server.getClientCount() < size_t(clients)) server.service(10);
+
+  // Broadcast the match, fast viewers read every tick and slow ones now and then
+  std::vector<uint64_t> fanout;
+  fanout.reserve(ticks);
+  uint64_t serviceNs = 0;
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+    sim.tick(Inputs());
+    server.publish(sim);
+    fanout.push_back(server.getStats().lastFanoutNs);
+    auto startTime = std::chrono::steady_clock::now();
+    server.service(0);
+    serviceNs += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+    for (Viewer &viewer : viewers) {
+      if (!viewer.slow || tick % SLOW_READ_TICKS == 0) readViewer(viewer);
+    }
+  }
+
+  // Drain what's left and check everyone ends on the last frame published
+  SpectatorFrame last = SpectatorFrame::capture(sim, ticks - 1);
+  int            behind = clients;
+  for (int attempt = 0; attempt < 1000 && behind > 0; attempt++) {
+    server.service(1);
+    behind = 0;
+    for (Viewer &viewer : viewers) {
+      readViewer(viewer);
+      if (viewer.frame.tick != last.tick) behind++;
+    }
+  }
+  int mismatched = 0;
+  for (Viewer &viewer : viewers) {
+    if (memcmp(viewer.frame.values, last.values, sizeof(last.values)) != 0 || viewer.frame.tick != last.tick) mismatched++;
+    close(viewer.fd);
+  }
+
+  std::sort(fanout.begin(), fanout.end());
+  const SpectatorStats &stats = server.getStats();
+  double                mean = double(stats.fanoutNs) / double(ticks ? ticks : 1);
+  printf("\nviewers:         %d over %s (%d slow)\n", clients, tcp ? "TCP loopback" : "a Unix socket",
+         slowEvery > 0 ? clients / slowEvery : 0);
+  printf("ticks:           %u\n", ticks);
+  printf("fan-out:         %.1f us per tick (median %.1f, p99 %.1f), %.1f ns per viewer\n", mean / 1000.0,
+         fanout[fanout.size() / 2] / 1000.0, fanout[fanout.size() * 99 / 100] / 1000.0, mean / clients);
+  printf("service:         %.1f us per tick\n", double(serviceNs) / double(ticks ? ticks : 1) / 1000.0);
+  printf("bytes:           %.1f per viewer per tick\n", double(stats.bytesSent) / double(ticks ? ticks : 1) / clients);
+  printf("keyframes:       %llu (%llu resyncs of slow viewers)\n", (unsigned long long)stats.keyframesSent,
+         (unsigned long long)stats.resyncs);
+  printf("final frame:     %d of %d viewers match\n", clients - mismatched, clients);
+  server.close();
+  return mismatched ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+
+// Times publishing the live stats with nobody watching and with reader threads copying the segment out as fast as
+// they can, and checks every copy a reader took was one whole publish rather than parts of two.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/StatsSegment.h"
+
+using namespace pong;
+
+int main(int argc, char **argv) {
+  const char * path = "bench_stats.tmp";
+  int          readers = (argc > 1) ? atoi(argv[1]) : 2;
+  StatsSegment writer;
+  if (!writer.create(path)) {
+    fprintf(stderr, "Can't create %s\n", path);
+    return 1;
+  }
+
+  // Every field of a publish is the same number, so a torn copy shows up as fields that disagree
+  GameStats stats;
+  auto      fill = [&](uint64_t _value) {
+    stats.updatedAtMs = stats.ticks = stats.frames = stats.rallies = stats.paddleHits = stats.renderBytes = _value;
+    stats.processId = stats.running = uint32_t(_value);
+  };
+  uint64_t value = 0;
+  bench::print(bench::run("publish, no readers", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      fill(++value);
+      writer.publish(stats);
+    }
+  }));
+
+  // Readers in their own mappings, like monitors in other processes
+  std::atomic<bool>        stop{false};
+  std::atomic<uint64_t>    reads{0}, failed{0}, torn{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < readers; i++) {
+    threads.emplace_back([&] {
+      StatsSegment reader;
+      if (!reader.open(path)) return;
+      GameStats copy;
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (!reader.read(&copy, 1)) {
+          failed.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        reads.fetch_add(1, std::memory_order_relaxed);
+        uint64_t first = copy.updatedAtMs;
+        if (copy.ticks != first || copy.frames != first || copy.rallies != first || copy.paddleHits != first ||
+            copy.renderBytes != first || copy.processId != uint32_t(first) || copy.running != uint32_t(first))
+          torn.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  bench::print(bench::run("publish, readers spinning", 10000000, [&](uint64_t _count) {
+    for (uint64_t i = 0; i < _count; i++) {
+      fill(++value);
+      writer.publish(stats);
+    }
+  }));
+  stop = true;
+  for (std::thread &thread : threads) thread.join();
+  writer.close();
+  remove(path);
+
+  printf("\n%d readers: %llu whole copies, %llu tries that met a publish, %llu torn\n", readers, (unsigned long long)reads.load(),
+         (unsigned long long)failed.load(), (unsigned long long)torn.load());
+  return torn.load() ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Steps batches of environments with random actions and reports env-steps/sec for each batch size
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Benchmarks/Bench.h"
+#include "Pong/VectorEnv.h"
+
+using namespace pong;
+
+int main(int argc, char **argv) {
+  const size_t COUNTS[] = {1, 4, 16, 64, 256, 1024, 4096};
+  size_t       threads = (argc > 1) ? size_t(atoi(argv[1])) : 0;
+
+  for (size_t count : COUNTS) {
+    VectorEnv env(count, GameMode::MEDIUM, threads);
+
+    // The caller owns every buffer, nothing is allocated once stepping starts
+    std::vector<uint32_t>       seeds(count);
+    std::vector<int8_t>         actions(count);
+    std::vector<EnvObservation> observations(count);
+    std::vector<float>          rewards(count);
+    std::vector<uint8_t>        done(count);
+    for (size_t i = 0; i < count; i++) seeds[i] = uint32_t(i + 1);
+    env.reset(seeds.data(), observations.data());
+
+    // Random actions from a cheap LCG so the agent costs next to nothing
+    uint32_t       state = 1;
+    uint64_t       episodes = 0;
+    const uint64_t steps = 2000000 / count + 1;
+    bench::Result  result = bench::run("env step", steps * count, [&](uint64_t) {
+      for (uint64_t step = 0; step < steps; step++) {
+        for (size_t i = 0; i < count; i++) {
+          state = state * 214013u + 2531011u;
+          actions[i] = int8_t(int((state >> 16) % 3) - 1);
+        }
+        env.step(actions.data(), observations.data(), rewards.data(), done.data());
+        for (size_t i = 0; i < count; i++) episodes += done[i];
+      }
+      bench::doNotOptimize(observations[0]);
+    });
+    printf("%6zu envs  %2zu threads  %12.0f env-steps/sec  (best %.0f)  %llu episodes\n", count, env.getThreadCount(),
+           1e9 / result.nsPerOp, 1e9 / result.minNsPerOp, (unsigned long long)episodes);
+  }
+  return 0;
+}
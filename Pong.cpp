@@ -12,221 +12,76 @@ The above copyright notice and this permission notice shall be included in all
 copies or substantial portions of the Software.
 */
 
-#ifndef _MSC_VER
-#error "This example of Pong requires the MSVC toolchain to compile and run"
-#else
-
 #ifndef __cplusplus
 #error "This example of Pong requires a C++ compiler"
 #else
 
-#define _WIN32_WINNT 0x0501
-#define TIME std::chrono::time_point<std::chrono::high_resolution_clock>
-#define NOW chrono::high_resolution_clock::now()
-#define DURATION(startTime, endTime) std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
-#define CONSOLE_WHITE 15
-#define CONSOLE_RED FOREGROUND_RED | FOREGROUND_INTENSITY
-#define CONSOLE_GREEN FOREGROUND_GREEN | FOREGROUND_INTENSITY
-#define CONSOLE_BLUE FOREGROUND_BLUE | FOREGROUND_INTENSITY
-#define CONSOLE_YELLOW FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY
-#define CONSOLE_AQUA FOREGROUND_GREEN | FOREGROUND_BLUE | FOREGROUND_INTENSITY
-#define CONSOLE_MAGENTA FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_INTENSITY
+#define TIME std::chrono::time_point<std::chrono::steady_clock>
+#define NOW chrono::steady_clock::now()
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <ctime>
 #include <chrono>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <thread>
+
+#ifdef _WIN32
+#define _WIN32_WINNT 0x0501
+#include <winsock2.h>
 #include <windows.h>
+#ifdef _MSC_VER
 #pragma comment(lib, "User32.lib")
+#pragma comment(lib, "Winmm.lib")
+#endif
+#endif
+
+#include "Pong/Audio.h"
+#include "Pong/Banners.h"
+#include "Pong/FramePipeline.h"
+#include "Pong/FrameTimer.h"
+#include "Pong/Input.h"
+#include "Pong/Netplay.h"
+#include "Pong/Replay.h"
+#include "Pong/Screen.h"
+#include "Pong/SearchPlayer.h"
+#include "Pong/Simulation.h"
+#include "Pong/Songs.h"
+#include "Pong/StatsSegment.h"
+#include "Pong/Terminal.h"
 
 using namespace std;
 using namespace std::chrono;
-
-class Game;
-class Player;
-class Ball;
-class Shape;
-
-class Shape {
- public:  // Typedefs
-  typedef std::function<void(Shape *)> shapeCallback;
-
- public:  // Constructor
-  Shape(int _width, int _height) : width(_width), height(_height) {}
-  virtual ~Shape() {}
-
- public:  // Accessors
-  void setVisibility(bool _visibility = true) {
-    visible = _visibility;
-  }
-  void setXPosition(float _xPosition, bool _fireEvents = true) {
-    if (_fireEvents && onBeforePositionEvent) onBeforePositionEvent(this);
-    x = _xPosition;
-    if (_fireEvents && onAfterPositionEvent) onAfterPositionEvent(this);
-  }
-  void setYPosition(float _yPosition, bool _fireEvents = true) {
-    if (_fireEvents && onBeforePositionEvent) onBeforePositionEvent(this);
-    y = _yPosition;
-    if (_fireEvents && onAfterPositionEvent) onAfterPositionEvent(this);
-  }
-  void setAbsPosition(int _xPosition, int _yPosition, bool _fireEvents = true) {
-    if (_fireEvents && onBeforePositionEvent) onBeforePositionEvent(this);
-
-    x = _xPosition;
-    position.X = _xPosition;
-    y = _yPosition;
-    position.Y = _yPosition;
-
-    if (_fireEvents && onAfterPositionEvent) onAfterPositionEvent(this);
-  }
-  void setXVelocity(float _vx, bool _fireEvents = true) {
-    if (_fireEvents && onBeforeVelocityEvent) onBeforeVelocityEvent(this);
-    vx = _vx;
-    if (_fireEvents && onAfterVelocityEvent) onAfterVelocityEvent(this);
-  }
-  void setYVelocity(float _vy, bool _fireEvents = true) {
-    if (_fireEvents && onBeforeVelocityEvent) onBeforeVelocityEvent(this);
-    vy = _vy;
-    if (_fireEvents && onAfterVelocityEvent) onAfterVelocityEvent(this);
-  }
-  void setVelocities(float _vx, float _vy, bool _fireEvents = true) {
-    if (_fireEvents && onBeforeVelocityEvent) onBeforeVelocityEvent(this);
-    vx = _vx;
-    vy = _vy;
-    if (_fireEvents && onAfterVelocityEvent) onAfterVelocityEvent(this);
-  }
-
- public:  // Events
-  void onBeforePositionChange(shapeCallback _callback) {
-    if (_callback) onBeforePositionEvent = _callback;
-  };
-  void onAfterPositionChange(shapeCallback _callback) {
-    if (_callback) onAfterPositionEvent = _callback;
-  };
-  void onBeforeVelocityChange(shapeCallback _callback) {
-    if (_callback) onBeforeVelocityEvent = _callback;
-  };
-  void onAfterVelocityChange(shapeCallback _callback) {
-    if (_callback) onAfterVelocityEvent = _callback;
-  };
-
- public:  // Draw Methods
-  virtual void draw(HANDLE *_console) = 0;
-  virtual void clear(HANDLE *_console) = 0;
-
- protected:  // Data
-  bool          visible;
-  int           height, width = 0;                            // The width and height of the object
-  float         x, y = 0;                                     // The coordinates of the player used for calculating position
-  float         vx, vy = 0;                                   // Velocity of the shape in space
-  COORD         position;                                     // the onscreen position of the middle of the player
-  shapeCallback onBeforePositionEvent = [](Shape *_this) {};  // Callback to call before the object has changed position
-  shapeCallback onAfterPositionEvent = [](Shape *_this) {};   // Callback to call after the object has changed position
-  shapeCallback onBeforeVelocityEvent = [](Shape *_this) {};  // Callback to call before the object has changed velocity
-  shapeCallback onAfterVelocityEvent = [](Shape *_this) {};   // Callback to call after the object has changed velocity
-};
-
-class Player : public Shape {
- public:  // Friends
-  friend Game;
-
- public:  // Constructor
-  Player() : Shape(1, 5) {}
-  ~Player() {}
-
- public:  // Player Movement Handles
-  void moveUp() {
-    setYPosition(y - vy);
-  }
-  void moveDown() {
-    setYPosition(y + vy);
-  }
-
- private:  // Drawing Overrides
-  virtual void draw(HANDLE *_console) override {
-    if (visible) {
-      // Update Player Position from the x y values
-      position.Y = int(y);
-      COORD drawPosition = position;
-      drawPosition.Y -= 2;
-
-      // Adjust the draw position and colour to draw the player
-      SetConsoleTextAttribute(*_console, CONSOLE_AQUA);
-      for (int i = 0; i < height; i++) {
-        SetConsoleCursorPosition(*_console, drawPosition);
-        cout << 'I';
-        drawPosition.Y += 1;
-      }
-      SetConsoleTextAttribute(*_console, CONSOLE_WHITE);
-    }
-  }
-  virtual void clear(HANDLE *_console) override {
-    // Update Player Position
-    COORD drawPosition = position;
-    drawPosition.Y -= 2;
-    for (int i = 0; i < height; i++) {
-      SetConsoleCursorPosition(*_console, drawPosition);
-      cout << ' ';
-      drawPosition.Y += 1;
-    }
-  }
-
- private:                      // Private Data
-  int  score = 0;              // The current score of the player
-  bool lostLastPoint = false;  // Keep track of if the player lost their last point
-};
-
-class Ball : public Shape {
- public:  // Friends
-  friend Game;
-
- public:  // Constructors
-  Ball() : Shape(1, 1) {}
-  ~Ball() {}
-
- private:  // Calculations
-  void calculatePosition() {
-    if (onBeforePositionEvent) onBeforePositionEvent(this);
-    x += vx;
-    y += vy;
-    if (onAfterPositionEvent) onAfterPositionEvent(this);
-  }
-
- private:  // Drawing Overrides
-  virtual void draw(HANDLE *_console) override {
-    // Update the position
-    position.X = int(x);
-    position.Y = int(y);
-    SetConsoleCursorPosition(*_console, position);
-
-    // Draw on console
-    SetConsoleTextAttribute(*_console, CONSOLE_GREEN);
-    cout << 'O';
-    SetConsoleTextAttribute(*_console, CONSOLE_WHITE);
-  }
-  virtual void clear(HANDLE *_console) override {
-    SetConsoleCursorPosition(*_console, position);
-    cout << ' ';
-  }
-};
+using namespace pong;
 
 class Game {
- public:  // Enums
-  enum class GameMode {
-    NOT_STARTED = -1,
-    MULTIPLAYER = 0,
-    EASY = 1,
-    MEDIUM = 2,
-    HARD = 3,
-    IMPOSSIBLE = 4
+ public:  // Constants
+  static const int AUDIO_SAMPLE_RATE = 22050;  // Samples per second of the synthesized sound
+  static constexpr const char *REPLAY_PATH = "last_match.pongreplay";  // Where every match is recorded
+  static constexpr float NETPLAY_TICK_RATE = 60;  // Frames per second of network matches, rollback covers 133 ms at this rate
+  static constexpr const char *PROFILE_TRACE_PATH = "pong_profile.json";  // Chrome trace of the last frames, with -DPONG_PROFILER
+  static constexpr const char *PROFILE_CSV_PATH = "pong_profile.csv";     // Phase percentiles and the last frames, with -DPONG_PROFILER
+  static constexpr const char *STATS_PATH = "pong.stats";  // Where the live stats are published for pong_stats to read
+  static const int STATS_PER_SECOND = 10;                   // Times a second the live stats are published
+
+ public:  // Types
+  enum class Flow {
+    TITLE,           // The title screen, waiting for a game mode
+    MODE_BANNER,     // The chosen mode's banner while its song plays
+    SURVIVAL_SCORE,  // Survival's score from the rally that just ended
+    SERVE_DELAY,     // A moment to see where the ball ended up before the serve
+    PLAYING,         // Served, in play or paused
+    WINNER,          // The winner screen
+    QUIT             // Leaving the game
   };
-  enum class GameState {
-    NOT_STARTED = -1,
-    PAUSED = 0,
-    IN_PLAY = 1,
-    PLAYER_1_WINNER = 2,
-    PLAYER_2_WINNER = 3,
-    CPU_WINNER = 4
+  struct RenderState {
+    float ballX = 0, ballY = 0;  // Position of the ball
+    float player1Y = 0;          // Position of player 1
+    float opponentY = 0;         // Position of player 2 or the CPU
   };
 
  public:  // Constructor
@@ -241,421 +96,416 @@ class Game {
     initGame();
   }
 
+ public:  // Netplay
+  bool hostNetplay(uint16_t _port) {
+    // Play player 1 against whoever joins, picking the seed of the match
+    return netplay.host(_port, uint64_t(time(NULL)));
+  }
+  bool joinNetplay(const char *_host, uint16_t _port) {
+    // Play player 2 against the host
+    return netplay.join(_host, _port);
+  }
+
+ public:  // Rendering
+  void setRenderThread(bool _enabled) {
+    // Show frames on their own thread so a slow terminal can't hold up the physics, or on the game's like before
+    renderThread = _enabled;
+  }
+
+ public:  // Monitoring
+  void setStatsPath(const char *_path) {
+    // Publish the live stats to another file, or nowhere when NULL
+    statsPath = _path;
+  }
+
+#ifdef PONG_PROFILER
+ public:  // Profiling
+  void saveProfile() {
+    // Write the recent frames out as a trace, and every phase's percentiles along with them as CSV
+    profiler->writeTrace(PROFILE_TRACE_PATH);
+    profiler->writeCsv(PROFILE_CSV_PATH);
+  }
+#endif
+
  private:  // Game Initializer
   void initGame() {
-    // Seed the random number generator
-    srand(unsigned int(time(NULL)));
-
-    // Get the output console object and set its size
+    // Seed the simulation's random number generator
+    sim.width = width;
+    sim.height = height;
+    sim.seed(uint64_t(time(NULL)));
+    sim.setTickRate(physicsRate);
+
+#ifdef _WIN32
+    // Ask for 1 ms scheduler ticks so the frame pacing sleeps are accurate
+    timeBeginPeriod(1);
+#endif
+
+#ifdef PONG_PROFILER
+    // Time the phases of every frame played on this thread
+    profiler->install();
+#endif
+
+    // Take over the terminal and size the frame to the game, before the keyboard reads from it in raw mode
     setGameArea(height, width);
 
-    // Hid the cursor for the whole Game
-    hideCursor();
-
-    // Create generic functors for player movement
-    Shape::shapeCallback playerBeforeCallback = [=](Shape *_this) {
-      beforePlayerChangeCallback(_this);
-    };
-    Shape::shapeCallback playerAfterCallback = [=](Shape *_this) {
-      afterPlayerChangeCallback(_this);
-    };
-
-    // Init the players
-    player1.setYVelocity(1);
-    player1.onBeforePositionChange(playerBeforeCallback);
-    player1.onAfterPositionChange(playerAfterCallback);
-
-    player2.setYVelocity(1);
-    player2.onBeforePositionChange(playerBeforeCallback);
-    player2.onAfterPositionChange(playerAfterCallback);
-
-    cpu.onBeforePositionChange(playerBeforeCallback);
-    cpu.onAfterPositionChange(playerAfterCallback);
-
-    // Init the ball
-    ball.onBeforePositionChange([=](Shape *_this) {
-      beforeBallChangeCallback(_this);
-    });
-    ball.onAfterPositionChange([=](Shape *_this) {
-      afterBallChangeCallback(_this);
-    });
-    ball.onAfterVelocityChange([=](Shape *_this) {
-      afterBallVelocityCallback(_this);
-    });
+    // Start the audio and keyboard threads
+    audio.start(&audioSink, AUDIO_SAMPLE_RATE);
+    keyboard.start();
   }
 
- private:  // Player and ball callbacks
-  void beforePlayerChangeCallback(Shape *_this) {
-    _this->clear(&console);
+ private:  // Game Logic Methods
+  Player *getOpponent() {
+    return sim.getOpponent();
   }
-  void afterPlayerChangeCallback(Shape *_this) {
-    // Cast back up to Player object
-    Player *player = static_cast<Player *>(_this);
-
-    // Check if there are collisions with the wall
-    int playerHalfHeight = int(player->height / 2);
-    int playerTop = player->y - playerHalfHeight;
-    int playerBottom = player->y + playerHalfHeight;
-    if (playerTop < 3) {
-      player->setYPosition(3 + playerHalfHeight, false);
-    } else if (playerBottom > height - 1) {
-      player->setYPosition(height - 1 - playerHalfHeight, false);
-    }
-
-    // Draw Player
-    player->draw(&console);
+  int8_t keyTravel(Key _up, Key _down) {
+    // How far the paddle should move this tick given how long each key was held during it
+    float fraction = keyboard.heldFraction(_down) - keyboard.heldFraction(_up);
+    return int8_t(lround(fraction * Inputs::FULL_TICK));
   }
-  void beforeBallChangeCallback(Shape *_this) {
-    _this->clear(&console);
+  Inputs checkInputs(TIME _tickEnd) {
+    PONG_PROFILE(PHASE_INPUT);
+    // Replay the key events up to the end of this tick
+    keyboard.advance(_tickEnd);
+
+    Inputs inputs;
+    inputs.player1 = keyTravel(Key::W, Key::S);
+    inputs.player2 = keyTravel(Key::UP, Key::DOWN);
+    return inputs;
   }
-  void afterBallChangeCallback(Shape *_this) {
-    // Cast back up to Player object
-    Ball *c_ball = static_cast<Ball *>(_this);
-
-    // Make a reset play bool
-    bool playNeedsReset = false;
-
-    // Check if it will collide with a wall
-    if (c_ball->y < 3) {
-      if (c_ball->vy < 0) {
-        c_ball->setAbsPosition(c_ball->x, 3, false);
-        c_ball->setVelocities(c_ball->vx, -c_ball->vy);
-      }
-    } else if (c_ball->y > height - 1) {
-      if (c_ball->vy > 0) {
-        c_ball->setAbsPosition(c_ball->x, height - 1, false);
-        c_ball->setVelocities(c_ball->vx, -c_ball->vy);
+  void waitForStart() {
+    //  Wait till the game mode is selected
+    if (keyboard.takePress(Key::SPACE)) {
+      sim.setMode(GameMode::MULTIPLAYER);
+    } else if (keyboard.takePress(Key::NUM_1)) {
+      sim.setMode(GameMode::EASY);
+    } else if (keyboard.takePress(Key::NUM_2)) {
+      sim.setMode(GameMode::MEDIUM);
+    } else if (keyboard.takePress(Key::NUM_3)) {
+      sim.setMode(GameMode::HARD);
+    } else if (keyboard.takePress(Key::NUM_4)) {
+      sim.setMode(GameMode::IMPOSSIBLE);
+    } else if (keyboard.takePress(Key::NUM_5)) {
+      sim.setMode(GameMode::MULTIBALL);
+    } else if (keyboard.takePress(Key::NUM_6)) {
+      sim.setMode(GameMode::EXPERT);
+    }
+  }
+  void waitForPlay() {
+    if (terminal.isFocused()) {
+      if (keyboard.takePress(Key::SPACE)) {
+        //  Clear the play area and draw the players and ball back in
+        drawPlayField();
+
+        // Set the game state to inplay with fresh timing
+        sim.start();
+        replay.start();
+        accumulator = 0;
+        loopStartTime = NOW;
+        nextFrameTime = loopStartTime;
+        frameTimer.restart();
+      } else {
+        sim.gameState = GameState::PAUSED;
       }
     }
+  }
 
-    // Check if it will collide with player 1
-    if (c_ball->x < 1) {
-      // Get position relative to player1
-      int ballRelPos = player1.position.Y - (int)c_ball->y;
-      int playerHalfHeight = (int)player1.height / 2;
-
-      if (ballRelPos <= playerHalfHeight && ballRelPos >= -playerHalfHeight) {
-        // Adjust Ball position
-        c_ball->setAbsPosition(1, c_ball->y, false);
-
-        // Invert ball x velocity
-        if (c_ball->vx < 0) {
-          float newXVelocity = randomFloat(minXSpeed, maxXSpeed);
-          float newYVelocity = c_ball->vy + ballRelPos / 4 + randomFloat(-0.5, 0.5);
-          c_ball->setVelocities(newXVelocity, newYVelocity);
-          Beep(300, 50);
-        }
+ public:  // Game Progression Methods
+  void run() {
+    if (renderThread) pipeline.start();
+    if (statsPath) startStats();
 
-        // If in impossible mode add to score each hit
-        if (gameMode == GameMode::IMPOSSIBLE) {
-          player1.score += 1;
-          drawScore();
-        }
-      } else {
-        // add score to CPU or player 2
-        c_ball->setAbsPosition(0, c_ball->y, false);
-        player1.lostLastPoint = true;
-        getOpponent()->score += 1;
-        playNeedsReset = true;
-      }
+    // A network match skips the menu, then it's back to the title like any other game
+    if (netplay.getState() != NetplayState::IDLE) {
+      if (!runNetplayGame()) return;
+    } else {
+      enterTitle();
     }
 
-    // Check if it will collide with player 2 or the CPU
-    if (c_ball->x > width - 1) {
-      // Get the opponent
-      Player *opponent = getOpponent();
-
-      // Get position relative to opponent
-      int ballRelPos = (int)c_ball->y - opponent->position.Y;
-      int playerHalfHeight = (int)opponent->height / 2;
-
-      if (ballRelPos <= playerHalfHeight && ballRelPos >= -playerHalfHeight) {
-        // Adjust Ball position
-        c_ball->setAbsPosition(width - 2, c_ball->y, false);
-
-        // Invert ball x velocity
-        if (c_ball->vx > 0) {
-          float newXVelocity = randomFloat(-maxXSpeed, -minXSpeed);
-          float newYVelocity = c_ball->vy + ballRelPos / 4 + randomFloat(-0.5, 0.5);
-          c_ball->setVelocities(newXVelocity, newYVelocity);
-          Beep(300, 50);
+    // Every stage of the game is a state the loop moves through, never a sleep, so each frame reads the keys and
+    // is drawn and ESC is seen within a frame wherever it's pressed
+    while (flow != Flow::QUIT) {
+      // Outside of play nothing else replays the key events
+      if (flow != Flow::PLAYING || sim.gameState != GameState::IN_PLAY) keyboard.advance(NOW);
+
+      // ESC quits from the title and goes back to it from anywhere else
+      if (keyboard.takePress(Key::ESCAPE)) {
+        if (flow == Flow::TITLE) {
+          closeTerminal();
+          flow = Flow::QUIT;
+          break;
         }
-      } else {
-        // add score to CPU or player 2
-        c_ball->setAbsPosition(width - 1, c_ball->y, false);
-        opponent->lostLastPoint = true;
-        player1.score += 1;
-        playNeedsReset = true;
+        replay.finish();
+        enterTitle();
       }
-    }
-
-    c_ball->draw(&console);
-    if (playNeedsReset) resetPlay();
-  }
-  void afterBallVelocityCallback(Shape *_this) {
-    // Cast back to ball
-    Ball *c_ball = static_cast<Ball *>(_this);
-
-    // Check if the velocities have breached their maximums or minimums
-    c_ball->setXVelocity((c_ball->vx > maxXSpeed) ? maxXSpeed : c_ball->vx, false);
-    c_ball->setXVelocity((c_ball->vx < -maxXSpeed) ? -maxXSpeed : c_ball->vx, false);
-    c_ball->setXVelocity((c_ball->vx > -minXSpeed && c_ball->vx < 0) ? -minXSpeed : c_ball->vx, false);
-    c_ball->setXVelocity((c_ball->vx < minXSpeed && c_ball->vx > 0) ? minXSpeed : c_ball->vx, false);
-    c_ball->setYVelocity((c_ball->vy > maxYSpeed) ? maxYSpeed : c_ball->vy, false);
-    c_ball->setYVelocity((c_ball->vy < -maxYSpeed) ? -maxYSpeed : c_ball->vy, false);
-  }
 
- private:  // Game Logic Methods
-  Player *getOpponent() {
-    Player *opponent;
-    if (gameMode == GameMode::MULTIPLAYER) {
-      opponent = &player2;
-    } else {
-      opponent = &cpu;
+      updateFlow();
+      presentFrame();
+      frameTimer.mark();
+      PONG_PROFILE_FRAME();
+      if (flow == Flow::PLAYING && pipeline.getStats().published % uint64_t(renderRate) == 0) showFrameJitter();
+      if (pipeline.getStats().published % uint64_t(renderRate / STATS_PER_SECOND) == 0) publishStats();
+      waitForNextFrame();
     }
-    return opponent;
   }
-  void checkInputs() {
-    if (isActiveWindow()) {
-      if (GetAsyncKeyState(0x57))
-        player1.moveUp();
-      if (GetAsyncKeyState(0x53))
-        player1.moveDown();
-      if (GetAsyncKeyState(VK_UP))
-        player2.moveUp();
-      if (GetAsyncKeyState(VK_DOWN))
-        player2.moveDown();
-    }
-  }
-  void calculateCpuPosition() {
-    // Shortcut the impossible mode
-    if (gameMode == GameMode::IMPOSSIBLE) {
-      cpu.setYPosition(ball.y);
-    }
 
-    // Only judge where the ball will be when if coming towards the CPU
-    else if (ball.vx > 0) {
-      // Get the difference between the ball and the center of the cpu
-      float deltaCpu = float(cpu.y - ball.y);
-
-      // Applied a weighted multiplier based on the difficulty
-      switch (gameMode) {
-      case GameMode::EASY:
-        cpu.vy -= deltaCpu / 10.0f;
-        cpu.vy *= 0.60f;
-        cpu.setYPosition(cpu.y + cpu.vy);
-        break;
-      case GameMode::MEDIUM:
-        cpu.vy -= deltaCpu / 10.0f;
-        cpu.vy *= 0.70f;
-        cpu.setYPosition(cpu.y + cpu.vy);
-        break;
-      case GameMode::HARD:
-        cpu.vy -= deltaCpu / 10.0f;
-        cpu.vy *= 0.80f;
-        cpu.setYPosition(cpu.y + cpu.vy);
-        break;
-      default:
-        break;
+ private:  // Game Flow
+  void updateFlow() {
+    switch (flow) {
+    case Flow::TITLE:
+      // Wait for user input for game mode
+      waitForStart();
+      if (sim.gameMode != GameMode::NOT_STARTED) {
+        // Show the game mode for as long as its song plays
+        flow = Flow::MODE_BANNER;
+        startTimer(drawGameModeScreen());
       }
-    }
-  }
-  void checkScore() {
-    if (gameMode != GameMode::IMPOSSIBLE) {
-      Player *opponent = getOpponent();
-      if (player1.score >= 5) {
-        gameState = GameState::PLAYER_1_WINNER;
-      } else if (opponent->score >= 5) {
-        if (gameMode == GameMode::MULTIPLAYER)
-          gameState = GameState::PLAYER_2_WINNER;
-        else
-          gameState = GameState::CPU_WINNER;
+      break;
+    case Flow::MODE_BANNER:
+      if (timerDone()) {
+        // Give every match its own seed and record it from here
+        sim.seed(uint64_t(time(NULL)));
+        replay.begin(REPLAY_PATH, sim, sim.getSeed());
+        resetPlay();
       }
-    }
-  }
-  void waitForStart() {
-    //  Wait till the game mode is selected
-    if (isActiveWindow()) {
-      if (GetAsyncKeyState(VK_SPACE) & 0x8000) {
-        gameMode = GameMode::MULTIPLAYER;
-      } else if (GetAsyncKeyState(0x31) & 0x8000) {
-        gameMode = GameMode::EASY;
-      } else if (GetAsyncKeyState(0x32) & 0x8000) {
-        gameMode = GameMode::MEDIUM;
-      } else if (GetAsyncKeyState(0x33) & 0x8000) {
-        gameMode = GameMode::HARD;
-      } else if (GetAsyncKeyState(0x34) & 0x8000) {
-        gameMode = GameMode::IMPOSSIBLE;
+      break;
+    case Flow::SURVIVAL_SCORE:
+      if (timerDone()) {
+        // Add small delay to see ball before reset
+        flow = Flow::SERVE_DELAY;
+        startTimer(500);
       }
-    }
-
-    // Show the correct players
-    switch (gameMode) {
-    case GameMode::NOT_STARTED:
-      player1.visible = false;
-      player2.visible = false;
-      cpu.visible = false;
       break;
-    case GameMode::MULTIPLAYER:
-      player1.visible = true;
-      player2.visible = true;
-      cpu.visible = false;
+    case Flow::SERVE_DELAY:
+      if (timerDone()) serve();
+      break;
+    case Flow::PLAYING:
+      playFrame();
+      break;
+    case Flow::WINNER:
+      if (timerDone()) enterTitle();
       break;
     default:
-      player1.visible = true;
-      player2.visible = false;
-      cpu.visible = true;
       break;
     }
   }
-  void waitForPlay() {
-    if (isActiveWindow()) {
-      if (GetAsyncKeyState(VK_SPACE) & 0x8000) {
-        //  Clear the play area
-        clearPlayArea();
-
-        // Draw the players and ball back in
-        player1.draw(&console);
-        getOpponent()->draw(&console);
-        ball.draw(&console);
-
-        // Set the game state to inplay
-        gameState = GameState::IN_PLAY;
-      } else {
-        gameState = GameState::PAUSED;
+  void playFrame() {
+    // If window is not active or p button is pressed pause the game
+    if ((!terminal.isFocused() || keyboard.takePress(Key::P)) && sim.gameState == GameState::IN_PLAY) {
+      sim.gameState = GameState::PAUSED;
+      drawPauseScreen();
+      return;
+    }
+
+    // Handle the start of paused play
+    if (sim.gameState == GameState::PAUSED) {
+      waitForPlay();
+      return;
+    }
+
+    // Bank the real time since the last frame, capped so a long stall can't snowball
+    TIME   loopEndTime = NOW;
+    double tickSeconds = 1.0 / physicsRate;
+    accumulator += duration<double>(loopEndTime - loopStartTime).count();
+    accumulator = min(accumulator, 0.25);
+    loopStartTime = loopEndTime;
+
+    // Step the physics at a fixed rate until it has caught up with real time, each tick reading the keys
+    // over the slice of real time it stands for
+    TIME tickEndTime = loopEndTime - duration_cast<steady_clock::duration>(duration<double>(accumulator));
+    while (accumulator >= tickSeconds && sim.gameState == GameState::IN_PLAY) {
+      accumulator -= tickSeconds;
+      tickEndTime += duration_cast<steady_clock::duration>(duration<double>(tickSeconds));
+      previousState = currentState;
+      Inputs inputs = checkInputs(tickEndTime);
+      if (sim.gameMode == GameMode::EXPERT) inputs.player2 = expert.choose(sim);
+      replay.tick(inputs);
+      uint32_t events = sim.tick(inputs);
+      countTick(events);
+      currentState = captureRenderState();
+
+      // React to what happened during the tick
+      if (events & EVENT_PADDLE_HIT) playSong(HIT_SOUND);
+      if (events & (EVENT_SURVIVAL_RETURN | EVENT_SCORE_CHANGED)) drawScore();
+      if ((events & EVENT_POINT_SCORED) && sim.gameState <= GameState::IN_PLAY) {
+        drawPlayField();
+        resetPlay();
       }
     }
-  }
 
- public:  // Game Progression Methods
-  bool runGame() {
+    // Draw the play between the last two physics states, or show the winner once there is one
+    if (sim.gameState == GameState::IN_PLAY) {
+      drawPlayField(float(accumulator / tickSeconds));
+    } else if (sim.gameState > GameState::IN_PLAY) {
+      replay.finish();
+      enterWinner();
+    }
+  }
+  void enterTitle() {
     // Draw the Title and setup game
+    flow = Flow::TITLE;
+    sim.setTickRate(physicsRate);
     resetGame();
     drawTitleScreen();
 
     // Play theme song
     playThemeSong();
 
-    // Handle the front options menu
-    while (gameMode == GameMode::NOT_STARTED) {
-      // Exit the console if on the main screen
-      if (isActiveWindow() && GetAsyncKeyState(VK_ESCAPE) & 0x8000) {
-        FreeConsole();
+    // Ignore anything pressed before the title was up
+    keyboard.restart(NOW);
+  }
+  void enterWinner() {
+    // Show the winner for three seconds
+    flow = Flow::WINNER;
+    drawWinnerScreen();
+    playWinningSong();
+    startTimer(3000);
+  }
+  void startTimer(int _milliseconds) {
+    // The current stage moves on once this much time has passed, checked every frame
+    flowDeadline = NOW + milliseconds(_milliseconds);
+  }
+  bool timerDone() {
+    return NOW >= flowDeadline;
+  }
+
+ public:  // Netplay Progression
+  bool runNetplayGame() {
+    // Wait for the other player, the session sets up the match from the host's seed once they're here
+    resetGame();
+    sim.setTickRate(NETPLAY_TICK_RATE);
+    drawBorder();
+    drawScore();
+    clearPlayArea();
+    setCursorPosition(0, height / 2);
+    padToMiddle((netplay.getLocalPlayer() == 0) ? "Waiting for player 2 to join" : "Joining the host");
+    presentFrame();
+    while (!netplay.poll(nowMicroseconds())) {
+      keyboard.advance(NOW);
+      if (keyboard.takePress(Key::ESCAPE) || netplay.getState() == NetplayState::DISCONNECTED) {
+        netplay.close();
+        closeTerminal();
         return false;
       }
-
-      // Wait for user input for game mode
-      waitForStart();
-      Sleep(50);
+      sleepFor(10);
     }
 
-    // Show game mode when selected
-    drawGameModeScreen();
-
-    // Reset the game play
-    resetPlay();
-
-    // Loop through the main game functions until there is a result
-    while (gameState <= GameState::IN_PLAY) {
-      // Use the esc key to escape the game
-      if (isActiveWindow() && GetAsyncKeyState(VK_ESCAPE) & 0x8000) {
-        Sleep(50);
-        return true;
-      }
-
-      // If window is not active or p button is pressed pause the game
-      if ((!isActiveWindow() || GetAsyncKeyState(0x50) & 0x8000) && gameState != GameState::PAUSED) {
-        gameState = GameState::PAUSED;
-        drawPauseScreen();
-        continue;
+    // Both peers steer their own paddle with W and S, there's no pausing a match someone else is playing
+    clearPlayArea();
+    drawScore();
+    currentState = previousState = captureRenderState();
+    keyboard.restart(NOW);
+    accumulator = 0;
+    loopStartTime = NOW;
+    nextFrameTime = loopStartTime;
+    frameTimer.restart();
+    int    scoreShown = 0;
+    bool   inputTaken = false;
+    int8_t localInput = 0;
+
+    // Play until the match is over on frames both peers agree on, a late input can still undo the last point
+    while (sim.gameState <= GameState::IN_PLAY || !netplay.isSynchronized()) {
+      if (keyboard.takePress(Key::ESCAPE) || netplay.getState() == NetplayState::DISCONNECTED) break;
+
+      // Bank the real time since the last frame like a local match
+      TIME   loopEndTime = NOW;
+      double tickSeconds = 1.0 / NETPLAY_TICK_RATE;
+      accumulator += duration<double>(loopEndTime - loopStartTime).count();
+      accumulator = min(accumulator, 0.25);
+      loopStartTime = loopEndTime;
+      if (sim.gameState > GameState::IN_PLAY) {
+        keyboard.advance(loopEndTime);
+        netplay.poll(nowMicroseconds());
+        accumulator = 0;
       }
 
-      // Handle the start of paused play
-      if (gameState == GameState::PAUSED) {
-        waitForPlay();
-        Sleep(50);
+      // Play frames until caught up, holding the time over while the other peer is too far behind
+      TIME tickEndTime = loopEndTime - duration_cast<steady_clock::duration>(duration<double>(accumulator));
+      while (accumulator >= tickSeconds && sim.gameState == GameState::IN_PLAY) {
+        tickEndTime += duration_cast<steady_clock::duration>(duration<double>(tickSeconds));
+        if (!inputTaken) {
+          localInput = checkInputs(tickEndTime).player1;
+          inputTaken = true;
+        }
+        uint32_t events;
+        if (!netplay.advance(localInput, nowMicroseconds(), &events)) break;
+        inputTaken = false;
+        accumulator -= tickSeconds;
+        countTick(events);
+        previousState = currentState;
+        currentState = captureRenderState();
+        if (events & EVENT_PADDLE_HIT) playSong(HIT_SOUND);
       }
 
-      // Run the game continuously
-      else if (gameState == GameState::IN_PLAY) {
-        // Check the keyboard inputs
-        checkInputs();
-
-        // Calculate the new CPU position
-        calculateCpuPosition();
-
-        // Calculate the new ball position
-        ball.calculatePosition();
-
-        // Check the score
-        checkScore();
-
-        // Delay for visuals
-        TIME loopEndTime = NOW;
-        auto ms = DURATION(loopStartTime, loopEndTime);
-        if (ms < 30)
-          Sleep(30 - ms);
-        loopStartTime = NOW;
+      // A rollback can change the score as well as a new frame, so check it every frame
+      int score = sim.player1.getScore() * 1000 + sim.player2.getScore();
+      if (score != scoreShown) {
+        drawScore();
+        scoreShown = score;
       }
+      if (sim.gameState == GameState::IN_PLAY) drawPlayField(float(min(accumulator / tickSeconds, 1.0)));
+      presentFrame();
+      frameTimer.mark();
+      PONG_PROFILE_FRAME();
+      if (pipeline.getStats().published % uint64_t(renderRate) == 0) showNetplayStats();
+      if (pipeline.getStats().published % uint64_t(renderRate / STATS_PER_SECOND) == 0) publishStats();
+      waitForNextFrame();
     }
 
-    // Show the winner
-    drawWinnerScreen();
-    playWinningSong();
-    Sleep(3000);
+    // Show the winner, or just go back to the menu when someone left
+    bool finished = sim.gameState > GameState::IN_PLAY && netplay.isSynchronized();
+    netplay.close();
+    if (finished) {
+      enterWinner();
+    } else {
+      enterTitle();
+    }
     return true;
   }
-  void resetPlay() {
-    // Get the opponent
-    Player *opponent = getOpponent();
 
-    // If the game mode was impossible reset player 1 score
-    if (gameMode == GameMode::IMPOSSIBLE && player1.score > 0) {
+ private:  // Serving
+  void resetPlay() {
+    // If the game mode was impossible show player 1 score before it is reset
+    if (sim.gameMode == GameMode::IMPOSSIBLE && sim.player1.getScore() > 0) {
       drawImpossibleModeScore();
-      Sleep(1000);
-      player1.score = 0;
+      flow = Flow::SURVIVAL_SCORE;
+      startTimer(1000);
+      return;
     }
 
     // Add small delay to see ball before reset
-    Sleep(500);
-
-    // Reset the game to start conditions
-    player1.setAbsPosition(0, height / 2);
-    opponent->setAbsPosition(width - 1, height / 2);
-    ball.setAbsPosition(width / 2, height / 2);
-
-    // Serve the ball towards the winner
-    if (player1.lostLastPoint) {
-      ball.setVelocities(randomFloat(minXSpeed / 2, maxXSpeed / 2), randomFloat(-maxYSpeed / 3, maxYSpeed / 3));
-      player1.lostLastPoint = false;
-    } else if (opponent->lostLastPoint) {
-      ball.setVelocities(randomFloat(-maxXSpeed / 2, -minXSpeed / 2), randomFloat(-maxYSpeed / 3, maxYSpeed / 3));
-      opponent->lostLastPoint = false;
-    } else {
-      ball.setVelocities(randomFloat(-maxXSpeed / 2, maxXSpeed / 2), randomFloat(-maxYSpeed / 3, maxYSpeed / 3));
-    }
+    flow = Flow::SERVE_DELAY;
+    startTimer(500);
+  }
+  void serve() {
+    // Reset the game to start conditions and serve the ball towards the winner
+    sim.serve();
+    replay.serve();
+    currentState = previousState = captureRenderState();
 
-    // Draw the start screen
+    // Draw the start screen and wait for space
     drawGameStartScreen();
-
-    // Set the game state
-    gameState = GameState::PAUSED;
+    flow = Flow::PLAYING;
   }
   void resetGame() {
-    // Reset the scores
-    player1.score = 0;
-    player2.score = 0;
-    cpu.score = 0;
-
-    // Reset the states
-    gameMode = GameMode::NOT_STARTED;
-    gameState = GameState::NOT_STARTED;
+    // Take up a new terminal size between games, it can't change under a match in progress
+    if (resizeWidth) {
+      width = max(resizeWidth, BANNER_WIDTH);
+      height = max(resizeHeight - 1, 35);
+      sim.width = width;
+      sim.height = height;
+      screen.resize(width, height + 1);
+      resizeWidth = resizeHeight = 0;
+    }
+
+    // Reset the scores and states
+    sim.resetGame();
   }
 
  private:  // Game Draw Methods
-  void drawBorder(int borderColour = CONSOLE_WHITE) {
+  void drawBorder(int borderColour = COLOUR_WHITE) {
+    PONG_PROFILE(PHASE_DRAW_BORDER);
     // Set the colour of the text
-    SetConsoleTextAttribute(console, borderColour);
+    screen.setColour(borderColour);
 
     // Draw the top border
     setCursorPosition(0, 0);
@@ -670,90 +520,79 @@ class Game {
     drawOverWidth('-');
 
     // Reset the colour
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
+    screen.setColour(COLOUR_WHITE);
   }
   void drawScore() {
+    PONG_PROFILE(PHASE_DRAW_SCORE);
     // Put the cursor at the top
     setCursorPosition(0, 1);
 
     // Get the opponent
     Player *    opponent = getOpponent();
-    const char *opponentName = (gameMode == GameMode::MULTIPLAYER) ? "P2" : "CPU";
+    const char *opponentLabel = (sim.gameMode == GameMode::MULTIPLAYER) ? "P2 Score: " : "CPU Score: ";
 
     // Draw the score board
-    if (gameMode == GameMode::NOT_STARTED) {
-      SetConsoleTextAttribute(console, CONSOLE_GREEN);
+    if (sim.gameMode == GameMode::NOT_STARTED) {
+      screen.setColour(COLOUR_GREEN);
       padToMiddle("   Waiting for Game Start   \n");
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-    } else if (gameMode != GameMode::IMPOSSIBLE) {
+      screen.setColour(COLOUR_WHITE);
+    } else if (sim.gameMode != GameMode::IMPOSSIBLE) {
       // Create the score strings
-      char p1Score[12];
-      char opponentScore[14];
-      sprintf(p1Score, "P1 Score: %d", player1.score);
-      sprintf(opponentScore, "%s Score: %d ", opponentName, opponent->score);
+      char p1Score[32];
+      char opponentScore[32];
+      formatNumber(p1Score, "P1 Score: ", sim.player1.getScore());
+      formatNumber(opponentScore, opponentLabel, opponent->getScore(), " ");
 
       // Print P1 score
-      if (player1.score > opponent->score) {
-        SetConsoleTextAttribute(console, CONSOLE_GREEN);
-      } else if (player1.score < opponent->score) {
-        SetConsoleTextAttribute(console, CONSOLE_RED);
+      if (sim.player1.getScore() > opponent->getScore()) {
+        screen.setColour(COLOUR_GREEN);
+      } else if (sim.player1.getScore() < opponent->getScore()) {
+        screen.setColour(COLOUR_RED);
       } else {
-        SetConsoleTextAttribute(console, CONSOLE_YELLOW);
+        screen.setColour(COLOUR_YELLOW);
       }
       padToWidth(p1Score, width / 2 - 12);
 
       // Print the divider
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-      cout << " | ";
+      screen.setColour(COLOUR_WHITE);
+      screen.print(" | ");
 
       // Print the opponent score
-      if (player1.score < opponent->score) {
-        SetConsoleTextAttribute(console, CONSOLE_GREEN);
-      } else if (player1.score > opponent->score) {
-        SetConsoleTextAttribute(console, CONSOLE_RED);
+      if (sim.player1.getScore() < opponent->getScore()) {
+        screen.setColour(COLOUR_GREEN);
+      } else if (sim.player1.getScore() > opponent->getScore()) {
+        screen.setColour(COLOUR_RED);
       } else {
-        SetConsoleTextAttribute(console, CONSOLE_YELLOW);
+        screen.setColour(COLOUR_YELLOW);
       }
-      cout << opponentScore;
+      screen.print(opponentScore);
 
       // Reset the colour
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-    } else if (gameMode == GameMode::IMPOSSIBLE) {
+      screen.setColour(COLOUR_WHITE);
+    } else if (sim.gameMode == GameMode::IMPOSSIBLE) {
       // Create the score strings
-      char p1Score[12];
-      sprintf(p1Score, "     P1 Score: %d     ", player1.score);
+      char p1Score[32];
+      formatNumber(p1Score, "     P1 Score: ", sim.player1.getScore(), "     ");
 
       // Print P1 score
-      SetConsoleTextAttribute(console, CONSOLE_GREEN);
+      screen.setColour(COLOUR_GREEN);
       padToMiddle(p1Score);
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
+      screen.setColour(COLOUR_WHITE);
 
       // Reset the colour
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
+      screen.setColour(COLOUR_WHITE);
     }
   }
   void drawTitleScreen() {
+    PONG_PROFILE(PHASE_DRAW_SCREEN);
     // Draw the border and score
     drawBorder();
     drawScore();
     clearPlayArea();
 
-    // Put the cursor in the right place
-    setCursorPosition(0, 9);
-
-    // Draw the welcome
-    SetConsoleTextAttribute(console, CONSOLE_BLUE);
-    padToMiddle(" Welcome to:                             \n");
-
-    // Draw the Game title
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
-    padToMiddle(" _______  _______  __    _  _______  __  \n");
-    padToMiddle("|       ||       ||  |  | ||       ||  | \n");
-    padToMiddle("|    _  ||   _   ||   |_| ||    ___||  | \n");
-    padToMiddle("|   |_| ||  | |  ||       ||   | __ |  | \n");
-    padToMiddle("|    ___||  |_|  ||  _    ||   ||  ||__| \n");
-    padToMiddle("|   |    |       || | |   ||   |_| | __  \n");
-    padToMiddle("|___|    |_______||_|  |__||_______||__| \n");
+    // Draw the welcome and the game title
+    drawBanner(WELCOME_BANNER, 9, COLOUR_BLUE);
+    drawBanner(TITLE_BANNER, 10);
 
     // Draw the instructions
     setCursorPosition(0, 20);
@@ -766,146 +605,127 @@ class Game {
 
     // Draw the multiplayer options
     setCursorPosition(0, 26);
-    SetConsoleTextAttribute(console, CONSOLE_GREEN);
+    screen.setColour(COLOUR_GREEN);
     padToWidth("Easy : 1", 14);
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
-    cout << " | ";
-    SetConsoleTextAttribute(console, CONSOLE_YELLOW);
-    cout << "Medium : 2";
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
-    cout << " | ";
-    SetConsoleTextAttribute(console, CONSOLE_RED);
-    cout << "Hard : 3";
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
-    cout << " | ";
-    SetConsoleTextAttribute(console, CONSOLE_MAGENTA);
-    cout << "Survival : 4";
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
+    screen.setColour(COLOUR_WHITE);
+    screen.print(" | ");
+    screen.setColour(COLOUR_YELLOW);
+    screen.print("Medium : 2");
+    screen.setColour(COLOUR_WHITE);
+    screen.print(" | ");
+    screen.setColour(COLOUR_RED);
+    screen.print("Hard : 3");
+    screen.setColour(COLOUR_WHITE);
+    screen.print(" | ");
+    screen.setColour(COLOUR_MAGENTA);
+    screen.print("Survival : 4");
+
+    // Draw the multi-ball and expert options under the rest
+    setCursorPosition(0, 28);
+    screen.setColour(COLOUR_BLUE);
+    padToWidth("Multi-ball : 5", (width / 2) - int(strlen("Multi-ball : 5 | Expert : 6") / 2));
+    screen.setColour(COLOUR_WHITE);
+    screen.print(" | ");
+    screen.setColour(COLOUR_AQUA);
+    screen.print("Expert : 6");
+    screen.setColour(COLOUR_WHITE);
   }
-  void drawGameModeScreen() {
+  int drawGameModeScreen() {
+    PONG_PROFILE(PHASE_DRAW_SCREEN);
     // Reset the border
     drawScore();
     clearPlayArea();
 
     // Draw the appropriate game mode in the right colour
-    switch (gameMode) {
+    switch (sim.gameMode) {
     case GameMode::MULTIPLAYER:
       // Draw Text
       drawBorder();
-      setCursorPosition(0, height / 2 - 3);
-      padToMiddle(" _______  __   __  _______  __  \n");
-      padToMiddle("|       ||  | |  ||       ||  | \n");
-      padToMiddle("|    _  ||  |_|  ||    _  ||  | \n");
-      padToMiddle("|   |_| ||       ||   |_| ||  | \n");
-      padToMiddle("|    ___||       ||    ___||__| \n");
-      padToMiddle("|   |     |     | |   |     __  \n");
-      padToMiddle("|___|      |___|  |___|    |__| \n");
-
-      // Play Song
-      Beep(247, 300);
-      Beep(330, 300);
-      Beep(330, 300);
-      Beep(370, 300);
-      Beep(555, 300);
+      drawBanner(MULTIPLAYER_BANNER, height / 2 - 3);
 
-      break;
+      // Show the banner for as long as its song plays
+      return playSong(MULTIPLAYER_SONG);
     case GameMode::EASY:
       // Draw Text
-      drawBorder(CONSOLE_GREEN);
-      setCursorPosition(0, height / 2 - 3);
-      SetConsoleTextAttribute(console, CONSOLE_GREEN);
-      padToMiddle(" _______  _______  _______  __   __  __  \n");
-      padToMiddle("|       ||   _   ||       ||  | |  ||  | \n");
-      padToMiddle("|    ___||  |_|  ||  _____||  |_|  ||  | \n");
-      padToMiddle("|   |___ |       || |_____ |       ||  | \n");
-      padToMiddle("|    ___||       ||_____  ||_     _||__| \n");
-      padToMiddle("|   |___ |   _   | _____| |  |   |   __  \n");
-      padToMiddle("|_______||__| |__||_______|  |___|  |__| \n");
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-
-      // Play Song
-      Beep(494, 300);
-      Beep(440, 300);
-      Beep(392, 200);
-      Beep(440, 200);
-      Beep(494, 200);
-      Beep(440, 800);
-      break;
+      drawBorder(COLOUR_GREEN);
+      drawBanner(EASY_BANNER, height / 2 - 3, COLOUR_GREEN);
+
+      // Show the banner for as long as its song plays
+      return playSong(EASY_SONG);
     case GameMode::MEDIUM:
       // Draw Text
-      drawBorder(CONSOLE_YELLOW);
-      setCursorPosition(0, height / 2 - 3);
-      SetConsoleTextAttribute(console, CONSOLE_YELLOW);
-      padToMiddle(" __   __  _______  ______   ___   __   __  __   __  __  \n");
-      padToMiddle("|  |_|  ||       ||      | |   | |  | |  ||  |_|  ||  | \n");
-      padToMiddle("|       ||    ___||  _    ||   | |  | |  ||       ||  | \n");
-      padToMiddle("|       ||   |___ | | |   ||   | |  |_|  ||       ||  | \n");
-      padToMiddle("|       ||    ___|| |_|   ||   | |       ||       ||__| \n");
-      padToMiddle("| ||_|| ||   |___ |       ||   | |       || ||_|| | __  \n");
-      padToMiddle("|_|   |_||_______||______| |___| |_______||_|   |_||__| \n");
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-
-      // Play Song
-      Beep(440, 300);
-      Beep(494, 300);
-      Beep(440, 300);
-      Beep(392, 800);
-      break;
+      drawBorder(COLOUR_YELLOW);
+      drawBanner(MEDIUM_BANNER, height / 2 - 3, COLOUR_YELLOW);
+
+      // Show the banner for as long as its song plays
+      return playSong(MEDIUM_SONG);
     case GameMode::HARD:
       // Draw Text
-      drawBorder(CONSOLE_RED);
-      setCursorPosition(0, height / 2 - 3);
-      SetConsoleTextAttribute(console, CONSOLE_RED);
-      padToMiddle(" __   __  _______  ______    ______   __  \n");
-      padToMiddle("|  | |  ||   _   ||    _ |  |      | |  | \n");
-      padToMiddle("|  |_|  ||  |_|  ||   | ||  |  _    ||  | \n");
-      padToMiddle("|       ||       ||   |_||_ | | |   ||  | \n");
-      padToMiddle("|       ||       ||    __  || |_|   ||__| \n");
-      padToMiddle("|   _   ||   _   ||   |  | ||       | __  \n");
-      padToMiddle("|__| |__||__| |__||___|  |_||______| |__|\n");
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-
-      // Play Song
-      Beep(392, 800);
-      Beep(392, 300);
-      Beep(370, 300);
-      Beep(278, 600);
-      break;
+      drawBorder(COLOUR_RED);
+      drawBanner(HARD_BANNER, height / 2 - 3, COLOUR_RED);
+
+      // Show the banner for as long as its song plays
+      return playSong(HARD_SONG);
     case GameMode::IMPOSSIBLE:
       // Draw Text
-      drawBorder(CONSOLE_MAGENTA);
-      setCursorPosition(0, height / 2 - 3);
-      SetConsoleTextAttribute(console, CONSOLE_MAGENTA);
-      padToMiddle(" ______   _______  _______  _______  __   __  __  \n");
-      padToMiddle("|      | |       ||   _   ||       ||  | |  ||  | \n");
-      padToMiddle("|  _    ||    ___||  |_|  ||_     _||  |_|  ||  | \n");
-      padToMiddle("| | |   ||   |___ |       |  |   |  |       ||  | \n");
-      padToMiddle("| |_|   ||    ___||       |  |   |  |       ||__| \n");
-      padToMiddle("|       ||   |___ |   _   |  |   |  |   _   | __  \n");
-      padToMiddle("|______| |_______||__| |__|  |___|  |__| |__||__|\n");
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
-
-      // Play Song
-      Beep(494, 800);
-      Beep(440, 800);
-      Beep(392, 1600);
-      break;
+      drawBorder(COLOUR_MAGENTA);
+      drawBanner(IMPOSSIBLE_BANNER, height / 2 - 3, COLOUR_MAGENTA);
+
+      // Show the banner for as long as its song plays
+      return playSong(IMPOSSIBLE_SONG);
+    case GameMode::MULTIBALL:
+      // Draw Text
+      drawBorder(COLOUR_BLUE);
+      drawBanner(MULTIBALL_BANNER, height / 2 - 3, COLOUR_BLUE);
+
+      // Show the banner for as long as its song plays
+      return playSong(MULTIBALL_SONG);
+    case GameMode::EXPERT:
+      // Draw Text
+      drawBorder(COLOUR_AQUA);
+      drawBanner(EXPERT_BANNER, height / 2 - 3, COLOUR_AQUA);
+
+      // Show the banner for as long as its song plays
+      return playSong(EXPERT_SONG);
+    default:
+      return 0;
     }
   }
   void drawGameStartScreen() {
-    // Refresh the area
+    PONG_PROFILE(PHASE_DRAW_SCREEN);
+    // Refresh the area with the relevant players
     drawScore();
-    clearPlayArea();
-
-    // Draw the relevant players
-    player1.draw(&console);
-    getOpponent()->draw(&console);
-    ball.draw(&console);
+    drawPlayField();
 
     // Draw the press to start button
     drawPauseScreen();
   }
+  void drawPlayField(float _alpha = 1) {
+    PONG_PROFILE(PHASE_DRAW_PLAY_FIELD);
+    // Clear the play area, the frame diff only sends what actually moved
+    clearPlayArea();
+
+    // Draw the players and ball part way between the previous and current physics states
+    RenderState state = currentState;
+    if (_alpha < 1) {
+      state.ballX = previousState.ballX + (currentState.ballX - previousState.ballX) * _alpha;
+      state.ballY = previousState.ballY + (currentState.ballY - previousState.ballY) * _alpha;
+      state.player1Y = previousState.player1Y + (currentState.player1Y - previousState.player1Y) * _alpha;
+      state.opponentY = previousState.opponentY + (currentState.opponentY - previousState.opponentY) * _alpha;
+    }
+    sim.player1.drawAt(&screen, state.player1Y);
+    getOpponent()->drawAt(&screen, state.opponentY);
+    if (sim.gameMode != GameMode::MULTIBALL) {
+      sim.ball.drawAt(&screen, state.ballX, state.ballY);
+    } else {
+      // The swarm keeps no previous state, so its balls are drawn where the last tick left them
+      for (size_t i = 0; i < sim.swarm.size(); i++) {
+        screen.put(int(sim.swarm.getX(i)), int(sim.swarm.getY(i)), 'O', COLOUR_GREEN);
+      }
+    }
+  }
   void drawPauseScreen() {
+    PONG_PROFILE(PHASE_DRAW_SCREEN);
     // Show the game menu
     setCursorPosition(0, 6);
     padToMiddle("Press SPACE to start");
@@ -916,92 +736,53 @@ class Game {
 
     // Show how to win
     setCursorPosition(0, 10);
-    SetConsoleTextAttribute(console, CONSOLE_GREEN);
-    if (gameMode != GameMode::IMPOSSIBLE) {
+    screen.setColour(COLOUR_GREEN);
+    if (sim.gameMode == GameMode::MULTIBALL) {
+      padToMiddle("First to 20 wins!");
+    } else if (sim.gameMode != GameMode::IMPOSSIBLE) {
       padToMiddle("First to 5 wins!");
     } else {
       padToMiddle("Try return the ball as many times as you can!");
     }
-    SetConsoleTextAttribute(console, CONSOLE_WHITE);
+    screen.setColour(COLOUR_WHITE);
 
     // Show the player controls
     setCursorPosition(0, 28);
     padToMiddle("Player 1 Controls: W = up, S = down");
-    if (gameMode == GameMode::MULTIPLAYER) {
+    if (sim.gameMode == GameMode::MULTIPLAYER) {
       setCursorPosition(0, 29);
       padToMiddle("Player 2 Controls: UP ARROW = up, DOWN ARROW = down");
     }
   }
   void drawWinnerScreen() {
+    PONG_PROFILE(PHASE_DRAW_SCREEN);
     // Reset the screen
     clearPlayArea();
 
-    // Put the cursor back in the middle
-    setCursorPosition(0, 11);
-
     // Draw the Winner Sketch
-    switch (gameState) {
+    switch (sim.gameState) {
     case GameState::PLAYER_1_WINNER:
-      padToWidth("     _     _  ___   __    _  __    _  _______  ______    ___         \n", width / 2 - 34);
-      padToWidth("    | | _ | ||   | |  |  | ||  |  | ||       ||    _ |  |   |        \n", width / 2 - 34);
-      padToWidth("    | || || ||   | |   |_| ||   |_| ||    ___||   | ||  |___|        \n", width / 2 - 34);
-      padToWidth("    |       ||   | |       ||       ||   |___ |   |_||_  ___         \n", width / 2 - 34);
-      padToWidth("    |       ||   | |  _    ||  _    ||    ___||    __  ||   |        \n", width / 2 - 34);
-      padToWidth("    |   _   ||   | | | |   || | |   ||   |___ |   |  | ||___|        \n", width / 2 - 34);
-      padToWidth("    |__| |__||___| |_|  |__||_|  |__||_______||___|  |_|             \n", width / 2 - 34);
-      SetConsoleTextAttribute(console, CONSOLE_GREEN);
-      padToWidth(" _______  ___      _______  __   __  _______  ______      ____   __  \n", width / 2 - 34);
-      padToWidth("|       ||   |    |   _   ||  | |  ||       ||    _ |    |    | |  | \n", width / 2 - 34);
-      padToWidth("|    _  ||   |    |  |_|  ||  |_|  ||    ___||   | ||     |   | |  | \n", width / 2 - 34);
-      padToWidth("|   |_| ||   |    |       ||       ||   |___ |   |_||_    |   | |  | \n", width / 2 - 34);
-      padToWidth("|    ___||   |___ |       ||_     _||    ___||    __  |   |   | |__| \n", width / 2 - 34);
-      padToWidth("|   |    |       ||   _   |  |   |  |   |___ |   |  | |   |   |  __  \n", width / 2 - 34);
-      padToWidth("|___|    |_______||__| |__|  |___|  |_______||___|  |_|   |___| |__| \n", width / 2 - 34);
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
+      drawBanner(PLAYER_1_WINNER_BANNER, 11);
+      drawBanner(PLAYER_1_BANNER, 18, COLOUR_GREEN);
       break;
     case GameState::PLAYER_2_WINNER:
-      padToWidth("     _     _  ___   __    _  __    _  _______  ______    ___           \n", width / 2 - 34);
-      padToWidth("    | | _ | ||   | |  |  | ||  |  | ||       ||    _ |  |   |          \n", width / 2 - 34);
-      padToWidth("    | || || ||   | |   |_| ||   |_| ||    ___||   | ||  |___|          \n", width / 2 - 34);
-      padToWidth("    |       ||   | |       ||       ||   |___ |   |_||_  ___           \n", width / 2 - 34);
-      padToWidth("    |       ||   | |  _    ||  _    ||    ___||    __  ||   |          \n", width / 2 - 34);
-      padToWidth("    |   _   ||   | | | |   || | |   ||   |___ |   |  | ||___|          \n", width / 2 - 34);
-      padToWidth("    |__| |__||___| |_|  |__||_|  |__||_______||___|  |_|               \n", width / 2 - 34);
-      SetConsoleTextAttribute(console, CONSOLE_GREEN);
-      padToWidth(" _______  ___      _______  __   __  _______  ______      _______  __  \n", width / 2 - 34);
-      padToWidth("|       ||   |    |   _   ||  | |  ||       ||    _ |    |       ||  | \n", width / 2 - 34);
-      padToWidth("|    _  ||   |    |  |_|  ||  |_|  ||    ___||   | ||    |____   ||  | \n", width / 2 - 34);
-      padToWidth("|   |_| ||   |    |       ||       ||   |___ |   |_||_    ____|  ||  | \n", width / 2 - 34);
-      padToWidth("|    ___||   |___ |       ||_     _||    ___||    __  |  | ______||__| \n", width / 2 - 34);
-      padToWidth("|   |    |       ||   _   |  |   |  |   |___ |   |  | |  | |_____  __  \n", width / 2 - 34);
-      padToWidth("|___|    |_______||__| |__|  |___|  |_______||___|  |_|  |_______||__| \n", width / 2 - 34);
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
+      drawBanner(PLAYER_2_WINNER_BANNER, 11);
+      drawBanner(PLAYER_2_BANNER, 18, COLOUR_GREEN);
       break;
     case GameState::CPU_WINNER:
-      padToMiddle(" _     _  ___   __    _  __    _  _______  ______    ___  \n");
-      padToMiddle("| | _ | ||   | |  |  | ||  |  | ||       ||    _ |  |   | \n");
-      padToMiddle("| || || ||   | |   |_| ||   |_| ||    ___||   | ||  |___| \n");
-      padToMiddle("|       ||   | |       ||       ||   |___ |   |_||_  ___  \n");
-      padToMiddle("|       ||   | |  _    ||  _    ||    ___||    __  ||   | \n");
-      padToMiddle("|   _   ||   | | | |   || | |   ||   |___ |   |  | ||___| \n");
-      padToMiddle("|__| |__||___| |_|  |__||_|  |__||_______||___|  |_|      \n");
-      SetConsoleTextAttribute(console, CONSOLE_RED);
-      padToMiddle("           _______  _______  __   __  __                  \n");
-      padToMiddle("          |       ||       ||  | |  ||  |                 \n");
-      padToMiddle("          |       ||    _  ||  | |  ||  |                 \n");
-      padToMiddle("          |       ||   |_| ||  |_|  ||  |                 \n");
-      padToMiddle("          |      _||    ___||       ||__|                 \n");
-      padToMiddle("          |     |_ |   |    |       | __                  \n");
-      padToMiddle("          |_______||___|    |_______||__|                 \n");
-      SetConsoleTextAttribute(console, CONSOLE_WHITE);
+      drawBanner(CPU_WINNER_BANNER, 11);
+      drawBanner(CPU_BANNER, 18, COLOUR_RED);
 
+      break;
+    default:
       break;
     }
   }
   void drawImpossibleModeScore() {
+    PONG_PROFILE(PHASE_DRAW_SCREEN);
     // Create the string
-    char p1Score[21];
-    sprintf(p1Score, "Your Score was: %d", player1.score);
+    char p1Score[32];
+    formatNumber(p1Score, "Your Score was: ", sim.player1.getScore());
 
     // Print the string
     setCursorPosition(0, 9);
@@ -1011,20 +792,34 @@ class Game {
  private:  // Drawing Utilities
   void drawOverWidth(char inputChar) {
     for (int i = 0; i < width; i++) {
-      cout << inputChar;
+      screen.print(inputChar);
     }
   }
   void padToWidth(const char *inputString, int padding) {
     if (inputString) {
       for (int i = 0; i < padding; i++) {
-        cout << ' ';
+        screen.print(' ');
       }
-      cout << inputString;
+      screen.print(inputString);
     }
   }
   void padToMiddle(const char *inputString) {
-    int length = strlen(inputString);
-    padToWidth(inputString, (width / 2) - (strlen(inputString) / 2));
+    padToWidth(inputString, (width / 2) - int(strlen(inputString) / 2));
+  }
+  template <int ROWS>
+  void drawBanner(const BannerImage<ROWS> &_banner, int _y, uint8_t _colour = COLOUR_WHITE) {
+    // Banners are baked for the default width, this keeps them centred on any other
+    screen.blit((width - BANNER_WIDTH) / 2, _y, &_banner.glyphs[0][0], BANNER_WIDTH, ROWS, _colour);
+  }
+  template <size_t N>
+  static const char *formatNumber(char (&_text)[N], const char *_prefix, int _value, const char *_suffix = "") {
+    // Text around a number in a fixed buffer, cut short rather than written past the end
+    char *out = _text, *end = _text + N - 1;
+    while (*_prefix && out < end) *out++ = *_prefix++;
+    out = std::to_chars(out, end, _value).ptr;
+    while (*_suffix && out < end) *out++ = *_suffix++;
+    *out = '\0';
+    return _text;
   }
   void clearPlayArea() {
     setCursorPosition(0, 3);
@@ -1035,108 +830,248 @@ class Game {
   }
 
  private:  // Songs
+  template <size_t N>
+  int playSong(const Note (&_song)[N]) {
+    // Hand the notes to the audio thread, returns the length of the song in milliseconds
+    return audio.playSong(_song, N);
+  }
   void playThemeSong() {
-    Beep(220, 300);
-    Beep(294, 300);
-    Beep(294, 300);
-    Beep(370, 300);
-    Beep(494, 300);
-    Beep(370, 300);
-    Beep(440, 800);
+    playSong(THEME_SONG);
   }
   void playWinningSong() {
-    if (gameState == GameState::PLAYER_1_WINNER || gameState == GameState::PLAYER_2_WINNER) {
-      Beep(440, 300);
-      Beep(494, 300);
-      Beep(440, 300);
-      Beep(370, 300);
-      Beep(392, 300);
-      Beep(370, 300);
-      Beep(330, 800);
+    if (sim.gameState == GameState::PLAYER_1_WINNER || sim.gameState == GameState::PLAYER_2_WINNER) {
+      playSong(WINNING_SONG);
     } else {
-      Beep(392, 300);
-      Beep(370, 300);
-      Beep(247, 1600);
+      playSong(LOSING_SONG);
     }
   }
 
+ private:  // Live Stats
+  void startStats() {
+    // Carry on without monitoring if the segment can't be made, the game doesn't need it
+    if (!stats.create(statsPath)) return;
+    liveStats.processId = StatsSegment::processId();
+    liveStats.running = 1;
+    statsTime = NOW;
+    publishStats();
+  }
+  void countTick(uint32_t _events) {
+    // Count what each tick played, the rest of the stats are read when they're published
+    liveStats.ticks++;
+    if (_events & EVENT_PADDLE_HIT) {
+      liveStats.paddleHits++;
+      liveStats.longestRally = max(liveStats.longestRally, ++rallyHits);
+    }
+    if (_events & EVENT_POINT_SCORED) {
+      liveStats.rallies++;
+      rallyHits = 0;
+    }
+    if (sim.gameMode == GameMode::IMPOSSIBLE) liveStats.survivalBest = max(liveStats.survivalBest, int32_t(sim.player1.getScore()));
+  }
+  void publishStats() {
+    if (!stats.isOpen()) return;
+
+    // Rates are over the time since the last publish
+    FramePipeline::Stats output = pipeline.getStats();
+    TIME                 now = NOW;
+    double               seconds = duration<double>(now - statsTime).count();
+    uint64_t             events = keyboard.getEventCount();
+    if (output.shown > statsShown)
+      liveStats.renderBytesPerFrame = float(double(output.bytes - statsBytes) / double(output.shown - statsShown));
+    if (seconds > 0) liveStats.inputEventsPerSec = float(double(events - statsEvents) / seconds);
+    statsTime = now;
+    statsEvents = events;
+    statsShown = output.shown;
+    statsBytes = output.bytes;
+
+    // Everything else as it stands
+    liveStats.updatedAtMs = uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+    liveStats.frames = output.published;
+    liveStats.renderBytes = output.bytes;
+    liveStats.frameP50Ms = frameTimer.percentile(0.50f);
+    liveStats.frameP99Ms = frameTimer.percentile(0.99f);
+    liveStats.frameMaxMs = frameTimer.percentile(1.0f);
+    liveStats.gameMode = int32_t(sim.gameMode);
+    liveStats.gameState = int32_t(sim.gameState);
+    liveStats.player1Score = sim.player1.getScore();
+    liveStats.player2Score = sim.player2.getScore();
+    liveStats.cpuScore = sim.cpu.getScore();
+    stats.publish(liveStats);
+  }
+
  private:  // Console Utility Methods
   void setGameArea(int height, int width) {
-    // Get the output console object and set its size
-    SMALL_RECT consoleRectangle = {short(0), short(0), (short)width, short(height)};
-    console = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleWindowInfo(console, TRUE, &consoleRectangle);
-
-    // Set the max size of the window buffer
-    COORD consoleSize;
-    consoleSize.X = width;
-    consoleSize.Y = height;
-    SetConsoleScreenBufferSize(console, consoleSize);
-
-    // Set the title of the console
-    SetConsoleTitle("Pong! - A fun interactive demo by Mitch Coyer");
-
-    // Get the HWND of the console
-    windowsHandle = GetForegroundWindow();
+    // Put the terminal into game mode at this size
+    terminal.open(width, height);
+
+    // Size the frame to cover the borders drawn on rows 0 to height
+    screen.resize(width, height + 1);
+
+    // Set the title of the terminal
+    terminal.setTitle("Pong! - A fun interactive demo by Mitch Coyer");
   }
-  bool isActiveWindow() {
-    HWND currentWindow = GetForegroundWindow();
-    if (currentWindow == windowsHandle) {
-      return true;
-    } else {
-      return false;
+  void showFrameJitter() {
+    // Put the recent frame time percentiles in the title so pacing can be checked while playing, along with the
+    // writes each frame has taken to show
+    FramePipeline::Stats output = pipeline.getStats();
+    char                 title[200];
+    snprintf(title, sizeof(title), "Pong! - A fun interactive demo by Mitch Coyer | frame p50 %.2f ms, p99 %.2f ms, %.2f writes per frame, %llu skipped",
+             frameTimer.percentile(0.50f), frameTimer.percentile(0.99f), double(output.writes) / double(output.shown ? output.shown : 1),
+             (unsigned long long)output.skipped);
+    pipeline.setTitle(title);
+  }
+  void showNetplayStats() {
+    // Put how often rollback has had to fix a guess in the title, along with the time it took
+    const NetplayStats &stats = netplay.getStats();
+    double              frames = stats.frames ? double(stats.frames) : 1;
+    char                title[160];
+    snprintf(title, sizeof(title), "Pong! - A fun interactive demo by Mitch Coyer | rollbacks %llu (%.3f per frame), re-sim %.2f us per frame",
+             (unsigned long long)stats.rollbacks, stats.rollbacks / frames, stats.resimNs / frames / 1000.0);
+    pipeline.setTitle(title);
+  }
+  void closeTerminal() {
+    // Show the last frame and stop the render thread before giving the terminal back, and tell monitors we've gone
+    pipeline.stop();
+    terminal.close();
+    if (stats.isOpen()) {
+      liveStats.running = 0;
+      publishStats();
+      stats.close();
     }
   }
-  void hideCursor() {
-    // Hide Console Cursor
-    CONSOLE_CURSOR_INFO cursor;
-    cursor.dwSize = 10;
-    cursor.bVisible = false;
-    SetConsoleCursorInfo(console, &cursor);
+  uint64_t nowMicroseconds() {
+    return uint64_t(duration_cast<microseconds>(NOW.time_since_epoch()).count());
+  }
+  void sleepFor(int _milliseconds) {
+    PONG_PROFILE(PHASE_SLEEP);
+    this_thread::sleep_for(milliseconds(_milliseconds));
+  }
+  void waitForNextFrame() {
+    // Wait for the next frame, dropping frames rather than rushing to catch up
+    PONG_PROFILE(PHASE_SLEEP);
+    nextFrameTime += duration_cast<steady_clock::duration>(duration<double>(1.0 / renderRate));
+    if (nextFrameTime < NOW) nextFrameTime = NOW;
+    waitUntil(nextFrameTime);
   }
   void setCursorPosition(int _x, int _y) {
-    COORD cursor;
-    cursor.X = _x;
-    cursor.Y = _y;
-    SetConsoleCursorPosition(console, cursor);
+    screen.setCursorPosition(_x, _y);
   }
-  float randomFloat(float a, float b) {
-    float random = ((float)rand()) / (float)RAND_MAX;
-    float diff = b - a;
-    float r = random * diff;
-    return a + r;
+  RenderState captureRenderState() {
+    RenderState state;
+    state.ballX = float(sim.ball.getX());
+    state.ballY = float(sim.ball.getY());
+    state.player1Y = float(sim.player1.getY());
+    state.opponentY = float(getOpponent()->getY());
+    return state;
+  }
+  void presentFrame() {
+    PONG_PROFILE(PHASE_PRESENT);
+    // Hand the frame over to be shown, the game only waits for it to be copied
+    pipeline.publish(screen);
+
+    // The terminal is repainted at once when it's resized, the game grows to fit once this one ends
+    int columns, rows;
+    if (pipeline.takeResize(&columns, &rows)) {
+      resizeWidth = columns;
+      resizeHeight = rows;
+    }
   }
 
  public:  // Data
   //  Game Data
-  int       width, height;                       // The width and height of the console
-  HANDLE    console;                             // The handle to the current console
-  HWND      windowsHandle;                       // The HWND handle to the console window
-  GameMode  gameMode = GameMode::NOT_STARTED;    // Enum to track the game mode
-  GameState gameState = GameState::NOT_STARTED;  // Enum to keep track of the play state
-  TIME      loopStartTime = NOW;                 // A timer stamp to keep track of the execution loop
-
-  // Player Objects
-  Player player1;
-  Player player2;
-  Player cpu;
-
-  // Ball object
-  Ball  ball;
-  float maxXSpeed = 3;    // Maximum ball speed in x direction
-  float minXSpeed = 2;    // Minimum ball speed in x direction
-  float maxYSpeed = 1.5;  // Maximum ball speed in y direction
-  float minYSpeed = 0;    // Maximum ball speed in y direction
+  int    width, height;                      // The width and height of the play area
+  int    resizeWidth = 0, resizeHeight = 0;  // The terminal's new size to take up at the next game, 0 if unchanged
+  Screen screen;                             // The double buffered frame all drawing goes into
+#ifdef _WIN32
+  ConsoleTerminal terminal;  // The console window frames are shown in
+#else
+  PosixTerminal terminal;  // The terminal frames are shown in
+#endif
+  FramePipeline pipeline{terminal};   // Shows the frames drawn into screen, on its own thread unless told not to
+  bool          renderThread = true;  // Whether the next run() shows frames on a render thread
+
+  // Game flow
+  Flow flow = Flow::TITLE;  // The stage of the game being played
+  TIME flowDeadline = NOW;  // When a timed stage moves on
+
+  // Frame pacing
+  TIME        loopStartTime = NOW;  // A timer stamp to keep track of the execution loop
+  TIME        nextFrameTime = NOW;  // When the next frame should be shown
+  double      accumulator = 0;      // Real time in seconds not yet simulated
+  float       physicsRate = 240;    // Physics ticks per second
+  float       renderRate = 60;      // Frames drawn per second
+  FrameTimer  frameTimer;           // Measures the jitter of the frame pacing
+  RenderState previousState;        // Positions before the last physics tick
+  RenderState currentState;         // Positions after the last physics tick
+
+  // Input
+  Keyboard keyboard;  // Reads key events on its own thread
+
+  // Replay
+  ReplayWriter replay;  // Records the match being played
+
+  // Expert
+  SearchPlayer expert;  // Moves the opponent in expert mode, its moves go in the inputs so replays play them back
+
+  // Live stats
+  const char * statsPath = STATS_PATH;  // Where the stats are published, NULL for nowhere
+  StatsSegment stats;                   // The shared segment monitors read the stats from
+  GameStats    liveStats;               // The stats as of the last publish, counted as the game plays
+  int          rallyHits = 0;           // Paddle hits in the rally being played
+  TIME         statsTime = NOW;         // When the rates were last worked out
+  uint64_t     statsEvents = 0;         // Key events replayed as of then
+  uint64_t     statsShown = 0;          // Frames shown as of then
+  uint64_t     statsBytes = 0;          // Bytes written as of then
+
+  // Sound
+#if defined(_WIN32)
+  WaveOutAudioSink audioSink{AUDIO_SAMPLE_RATE};  // The speakers, declared before the engine that writes to them
+#elif defined(PONG_WITH_ALSA)
+  AlsaAudioSink audioSink{AUDIO_SAMPLE_RATE};  // The speakers, declared before the engine that writes to them
+#else
+  NullAudioSink audioSink;  // Silence where there's no sound device to play on
+#endif
+  AudioEngine audio;  // Plays notes on its own thread
+
+  // The players, ball and rules of the game
+  Simulation sim;
+
+  // Network play
+  RollbackSession netplay{sim};  // Plays sim against another peer when hosting or joining
+
+#ifdef PONG_PROFILER
+  // Profiling, on the heap as the rings of recent frames and scopes are too big for the stack
+  std::unique_ptr<Profiler> profiler{new Profiler()};  // Times the phases of every frame on the game's thread
+#endif
 };
 
-int main() {
+int main(int argc, char **argv) {
   // Grid starts in the top left at (0,0) and ends at (79,35)
   // Playable area is 79 x 31 starting at (2,0) and ending at (79, 34)
 
   Game game(79, 35);
-  while (game.runGame()) {
+
+  // pong --host PORT plays player 1 over the network, pong --join HOST PORT plays player 2, --serial shows
+  // frames on the game's thread to compare against the render thread, and --stats PATH or --no-stats moves or
+  // turns off the live stats
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--host") && i + 1 < argc) {
+      if (!game.hostNetplay(uint16_t(atoi(argv[++i])))) return 1;
+    } else if (!strcmp(argv[i], "--join") && i + 2 < argc) {
+      if (!game.joinNetplay(argv[i + 1], uint16_t(atoi(argv[i + 2])))) return 1;
+      i += 2;
+    } else if (!strcmp(argv[i], "--serial")) {
+      game.setRenderThread(false);
+    } else if (!strcmp(argv[i], "--stats") && i + 1 < argc) {
+      game.setStatsPath(argv[++i]);
+    } else if (!strcmp(argv[i], "--no-stats")) {
+      game.setStatsPath(NULL);
+    }
   }
+  game.run();
+#ifdef PONG_PROFILER
+  game.saveProfile();
+#endif
 }
 
 #endif  // __cplusplus
-#endif  //_MSC_VER
\ No newline at end of file
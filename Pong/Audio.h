@@ -0,0 +1,367 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_AUDIO_H
+#define PONG_AUDIO_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Winmm.lib")
+#endif
+#endif
+
+#ifdef PONG_WITH_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+#include "SpscQueue.h"
+
+namespace pong {
+
+  // A single tone, a frequency of 0 is a rest
+  struct Note {
+    uint16_t frequency;  // Pitch in Hz
+    uint16_t duration;   // Length in milliseconds
+  };
+
+  // Where the synthesized 16 bit mono PCM ends up
+  class AudioSink {
+   public:  // Constructor
+    virtual ~AudioSink() {}
+
+   public:  // Output
+    virtual bool write(const int16_t *_samples, size_t _count) = 0;
+  };
+
+  // Throws the audio away, for headless runs and tests
+  class NullAudioSink : public AudioSink {
+   public:  // Output
+    virtual bool write(const int16_t *, size_t _count) override {
+      samplesWritten += _count;
+      return true;
+    }
+
+   public:  // Data
+    uint64_t samplesWritten = 0;  // Total samples handed to the sink
+  };
+
+  // Writes raw samples to a stream, e.g. a pipe into "aplay -f S16_LE -r 22050"
+  class RawAudioSink : public AudioSink {
+   public:  // Constructor
+    RawAudioSink(FILE *_file) : file(_file) {}
+
+   public:  // Output
+    virtual bool write(const int16_t *_samples, size_t _count) override {
+      bool written = fwrite(_samples, sizeof(int16_t), _count, file) == _count;
+      fflush(file);
+      return written;
+    }
+
+   private:  // Data
+    FILE *file;  // The stream the samples go to
+  };
+
+  // Records everything played into a .wav file
+  class WavFileAudioSink : public AudioSink {
+   public:  // Constructor
+    WavFileAudioSink(const char *_path, int _sampleRate) : sampleRate(_sampleRate) {
+      file = fopen(_path, "wb");
+      if (file) writeHeader();
+    }
+    ~WavFileAudioSink() {
+      if (file) {
+        // Fill in the sizes now they are known
+        fseek(file, 0, SEEK_SET);
+        writeHeader();
+        fclose(file);
+      }
+    }
+
+   public:  // Output
+    virtual bool write(const int16_t *_samples, size_t _count) override {
+      if (!file) return false;
+      dataBytes += uint32_t(_count * sizeof(int16_t));
+      return fwrite(_samples, sizeof(int16_t), _count, file) == _count;
+    }
+
+   private:  // Helpers
+    void writeHeader() {
+      // A canonical 44 byte RIFF header for 16 bit mono PCM, fields are little endian
+      uint8_t header[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0};
+      putLittleEndian(header + 4, 36 + dataBytes);
+      putLittleEndian(header + 24, uint32_t(sampleRate));
+      putLittleEndian(header + 28, uint32_t(sampleRate) * 2);
+      header[32] = 2;
+      header[34] = 16;
+      header[36] = 'd', header[37] = 'a', header[38] = 't', header[39] = 'a';
+      putLittleEndian(header + 40, dataBytes);
+      fwrite(header, 1, sizeof(header), file);
+    }
+    static void putLittleEndian(uint8_t *_out, uint32_t _value) {
+      for (int i = 0; i < 4; i++) _out[i] = uint8_t(_value >> (8 * i));
+    }
+
+   private:  // Data
+    FILE *   file = NULL;    // The open .wav file
+    int      sampleRate;     // Samples per second
+    uint32_t dataBytes = 0;  // Bytes of samples written so far
+  };
+
+#ifdef PONG_WITH_ALSA
+  // Plays through the default ALSA device, writes block at the device's pace
+  class AlsaAudioSink : public AudioSink {
+   public:  // Constructor
+    AlsaAudioSink(int _sampleRate) {
+      if (snd_pcm_open(&pcm, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
+        pcm = NULL;
+      } else if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, 1, _sampleRate, 1, 50000) < 0) {
+        snd_pcm_close(pcm);
+        pcm = NULL;
+      }
+    }
+    ~AlsaAudioSink() {
+      if (pcm) {
+        snd_pcm_drain(pcm);
+        snd_pcm_close(pcm);
+      }
+    }
+
+   public:  // Output
+    virtual bool write(const int16_t *_samples, size_t _count) override {
+      while (pcm && _count) {
+        snd_pcm_sframes_t written = snd_pcm_writei(pcm, _samples, _count);
+        if (written < 0) {
+          if (snd_pcm_recover(pcm, int(written), 1) < 0) return false;
+          continue;
+        }
+        _samples += written;
+        _count -= size_t(written);
+      }
+      return pcm != NULL;
+    }
+
+   private:  // Data
+    snd_pcm_t *pcm = NULL;  // The playback device
+  };
+#endif
+
+#ifdef _WIN32
+  // Plays through the Windows wave mapper, writes block once all buffers are queued
+  class WaveOutAudioSink : public AudioSink {
+   public:  // Constants
+    static const int BUFFERS = 4;  // Buffers queued with the device at once
+
+   public:  // Constructor
+    WaveOutAudioSink(int _sampleRate) {
+      WAVEFORMATEX format = {};
+      format.wFormatTag = WAVE_FORMAT_PCM;
+      format.nChannels = 1;
+      format.nSamplesPerSec = DWORD(_sampleRate);
+      format.wBitsPerSample = 16;
+      format.nBlockAlign = 2;
+      format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+      if (waveOutOpen(&device, WAVE_MAPPER, &format, 0, 0, CALLBACK_NULL) != MMSYSERR_NOERROR) device = NULL;
+      for (int i = 0; i < BUFFERS; i++) headers[i].dwFlags = WHDR_DONE;
+    }
+    ~WaveOutAudioSink() {
+      if (device) {
+        waveOutReset(device);
+        for (int i = 0; i < BUFFERS; i++) {
+          if (headers[i].dwFlags & WHDR_PREPARED) waveOutUnprepareHeader(device, &headers[i], sizeof(WAVEHDR));
+        }
+        waveOutClose(device);
+      }
+    }
+
+   public:  // Output
+    virtual bool write(const int16_t *_samples, size_t _count) override {
+      if (!device) return false;
+
+      // Wait for the oldest buffer to finish playing, this paces the audio thread
+      WAVEHDR &header = headers[next];
+      while (!(header.dwFlags & WHDR_DONE)) Sleep(1);
+      if (header.dwFlags & WHDR_PREPARED) waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+
+      // Queue a copy of the samples with the device
+      buffers[next].assign(_samples, _samples + _count);
+      header = WAVEHDR();
+      header.lpData = (LPSTR)buffers[next].data();
+      header.dwBufferLength = DWORD(_count * sizeof(int16_t));
+      waveOutPrepareHeader(device, &header, sizeof(WAVEHDR));
+      waveOutWrite(device, &header, sizeof(WAVEHDR));
+      next = (next + 1) % BUFFERS;
+      return true;
+    }
+
+   private:  // Data
+    HWAVEOUT             device = NULL;     // The open output device
+    WAVEHDR              headers[BUFFERS];  // Headers for the queued buffers
+    std::vector<int16_t> buffers[BUFFERS];  // Sample memory for the queued buffers
+    int                  next = 0;          // The next buffer to fill
+  };
+#endif
+
+  // Renders notes as square waves with short ramps at each end so they don't click
+  class SquareWaveSynth {
+   public:  // Constructor
+    SquareWaveSynth(int _sampleRate = 22050, int16_t _amplitude = 6000) : sampleRate(_sampleRate), amplitude(_amplitude) {}
+
+   public:  // Rendering
+    void render(const Note &_note, std::vector<int16_t> &_out) {
+      size_t count = size_t(sampleRate) * _note.duration / 1000;
+      size_t ramp = size_t(sampleRate) / 500;
+      _out.resize(count);
+      if (!_note.frequency) {
+        std::fill(_out.begin(), _out.end(), int16_t(0));
+        return;
+      }
+
+      // Step the phase in 32 bit fixed point so long notes don't drift
+      uint32_t step = uint32_t((uint64_t(_note.frequency) << 32) / uint32_t(sampleRate));
+      for (size_t i = 0; i < count; i++) {
+        int32_t level = (phase & 0x80000000u) ? -amplitude : amplitude;
+        if (i < ramp) level = level * int32_t(i) / int32_t(ramp);
+        if (count - i < ramp) level = level * int32_t(count - i) / int32_t(ramp);
+        _out[i] = int16_t(level);
+        phase += step;
+      }
+    }
+    int getSampleRate() const {
+      return sampleRate;
+    }
+
+   private:  // Data
+    int      sampleRate;  // Samples per second
+    int16_t  amplitude;   // Peak sample value
+    uint32_t phase = 0;   // Position within the current wave cycle
+  };
+
+  // Plays notes on a dedicated thread so the game only ever enqueues and returns
+  class AudioEngine {
+   public:  // Types
+    typedef std::chrono::steady_clock Clock;
+    struct Command {
+      Note              note;    // The note to play
+      Clock::time_point queued;  // When the game asked for it
+    };
+    struct Stats {
+      uint64_t queued = 0;         // Notes accepted by play()
+      uint64_t dropped = 0;        // Notes refused because the queue was full
+      uint64_t played = 0;         // Notes rendered and sent to the sink
+      uint64_t maxLatencyUs = 0;   // Longest wait between play() and the audio thread picking the note up
+      uint64_t meanLatencyUs = 0;  // Average of the same wait
+    };
+
+   public:  // Constructor
+    AudioEngine() {}
+    ~AudioEngine() {
+      stop();
+    }
+
+   public:  // Control
+    void start(AudioSink *_sink, int _sampleRate = 22050) {
+      stop();
+      sink = _sink;
+      synth = SquareWaveSynth(_sampleRate);
+      running = true;
+      worker = std::thread([this] { run(); });
+    }
+    void stop() {
+      running = false;
+      if (worker.joinable()) worker.join();
+    }
+
+   public:  // Game thread
+    bool play(uint16_t _frequency, uint16_t _duration) {
+      Command command = {{_frequency, _duration}, Clock::now()};
+      if (!queue.push(command)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      queued.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    int playSong(const Note *_notes, size_t _count) {
+      // Queue every note and return how long the song lasts in milliseconds
+      int length = 0;
+      for (size_t i = 0; i < _count; i++) {
+        play(_notes[i].frequency, _notes[i].duration);
+        length += _notes[i].duration;
+      }
+      return length;
+    }
+    Stats getStats() const {
+      Stats stats;
+      stats.queued = queued.load(std::memory_order_relaxed);
+      stats.dropped = dropped.load(std::memory_order_relaxed);
+      stats.played = played.load(std::memory_order_relaxed);
+      stats.maxLatencyUs = maxLatencyUs.load(std::memory_order_relaxed);
+      stats.meanLatencyUs = stats.played ? totalLatencyUs.load(std::memory_order_relaxed) / stats.played : 0;
+      return stats;
+    }
+    bool isIdle() const {
+      return queue.size() == 0 && !busy.load(std::memory_order_acquire);
+    }
+
+   private:  // Audio thread
+    void run() {
+      std::vector<int16_t> samples;
+      Command              command;
+      while (running.load(std::memory_order_relaxed)) {
+        if (!queue.pop(command)) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          continue;
+        }
+        busy.store(true, std::memory_order_release);
+
+        // Measure how long the note sat in the queue
+        uint64_t latency = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - command.queued).count());
+        totalLatencyUs.fetch_add(latency, std::memory_order_relaxed);
+        if (latency > maxLatencyUs.load(std::memory_order_relaxed)) maxLatencyUs.store(latency, std::memory_order_relaxed);
+
+        // Synthesize and hand over to the sink, which may block at the device's pace
+        synth.render(command.note, samples);
+        if (sink) sink->write(samples.data(), samples.size());
+        played.fetch_add(1, std::memory_order_relaxed);
+        busy.store(false, std::memory_order_release);
+      }
+    }
+
+   private:  // Data
+    SpscQueue<Command, 256> queue;              // Notes waiting to be played
+    SquareWaveSynth         synth;              // Turns notes into samples
+    AudioSink *             sink = NULL;        // Where the samples go
+    std::thread             worker;             // The audio thread
+    std::atomic<bool>       running{false};     // Cleared to stop the audio thread
+    std::atomic<bool>       busy{false};        // Set while the audio thread is working on a note
+    std::atomic<uint64_t>   queued{0};          // Notes accepted by play()
+    std::atomic<uint64_t>   dropped{0};         // Notes refused because the queue was full
+    std::atomic<uint64_t>   played{0};          // Notes sent to the sink
+    std::atomic<uint64_t>   totalLatencyUs{0};  // Sum of queue waits
+    std::atomic<uint64_t>   maxLatencyUs{0};    // Longest queue wait
+  };
+
+}  // namespace pong
+
+#endif  // PONG_AUDIO_H
@@ -0,0 +1,470 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_BALL_SWARM_H
+#define PONG_BALL_SWARM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PONG_SWARM_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 inside functions marked for it, MSVC emits whatever intrinsics are used
+#if defined(PONG_SWARM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PONG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PONG_TARGET_AVX2
+#endif
+
+namespace pong {
+
+  // The ways a swarm can be stepped, every kernel gives bit for bit the same result
+  enum class SwarmKernel {
+    SCALAR = 0,
+    SSE = 1,
+    AVX2 = 2
+  };
+
+  // What the balls bounce off during a step
+  struct SwarmField {
+    float width = 79, height = 35;  // The play area, walls at y = 3 and height - 1 and paddles at x = 0 and width - 1
+    float leftPaddleY = 0;          // On screen middle of the left paddle
+    float rightPaddleY = 0;         // On screen middle of the right paddle
+    float paddleHalfHeight = 2;     // Cells either side of the middle that still return the ball
+    float timeScale = 1;            // Reference ticks covered by the step
+  };
+
+  // What happened to the balls during a step
+  struct SwarmStep {
+    uint32_t paddleHits = 0;    // Balls returned by either paddle
+    uint32_t wallBounces = 0;   // Balls that bounced off the top or bottom
+    uint32_t leftMisses = 0;    // Balls that got past the left paddle
+    uint32_t rightMisses = 0;   // Balls that got past the right paddle
+    int32_t  leftTarget = -1;   // The nearest ball coming towards the left paddle, -1 if none
+    int32_t  rightTarget = -1;  // The nearest ball coming towards the right paddle, -1 if none
+  };
+
+  // Many balls stored as separate position and velocity arrays so a step runs over them a vector at a time
+  class BallSwarm {
+   public:  // Constants
+    static const size_t LANES = 8;  // Arrays are padded to the widest kernel
+
+   public:  // Kernel selection
+    static bool isSupported(SwarmKernel _kernel) {
+      switch (_kernel) {
+      case SwarmKernel::SCALAR:
+        return true;
+#ifdef PONG_SWARM_X86
+      case SwarmKernel::SSE:
+        return true;
+      case SwarmKernel::AVX2:
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_cpu_supports("avx2");
+#else
+        int info[4];
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#endif
+#endif
+      default:
+        return false;
+      }
+    }
+    static SwarmKernel bestKernel() {
+      if (isSupported(SwarmKernel::AVX2)) return SwarmKernel::AVX2;
+      if (isSupported(SwarmKernel::SSE)) return SwarmKernel::SSE;
+      return SwarmKernel::SCALAR;
+    }
+    bool setKernel(SwarmKernel _kernel) {
+      if (!isSupported(_kernel)) return false;
+      kernel = _kernel;
+      return true;
+    }
+    SwarmKernel getKernel() const {
+      return kernel;
+    }
+
+   public:  // Balls
+    void resize(size_t _count, float _parkX, float _parkY) {
+      // Pad to whole vectors with balls parked at _parkX, _parkY that never move, it has to be clear of the paddles
+      count = _count;
+      size_t padded = (_count + LANES - 1) / LANES * LANES;
+      x.assign(padded, _parkX);
+      y.assign(padded, _parkY);
+      vx.assign(padded, 0);
+      vy.assign(padded, 0);
+    }
+    size_t size() const {
+      return count;
+    }
+    void set(size_t _index, float _x, float _y, float _vx, float _vy) {
+      x[_index] = _x;
+      y[_index] = _y;
+      vx[_index] = _vx;
+      vy[_index] = _vy;
+    }
+    float getX(size_t _index) const {
+      return x[_index];
+    }
+    float getY(size_t _index) const {
+      return y[_index];
+    }
+    float getXVelocity(size_t _index) const {
+      return vx[_index];
+    }
+    float getYVelocity(size_t _index) const {
+      return vy[_index];
+    }
+
+   public:  // Simulation
+    SwarmStep step(const SwarmField &_field, std::vector<uint32_t> &_missed) {
+      // Move every ball, bounce it off the walls and paddles and list the ones that got past a paddle
+      SwarmStep result;
+      _missed.clear();
+      switch (kernel) {
+#ifdef PONG_SWARM_X86
+      case SwarmKernel::AVX2:
+        stepAvx2(_field, result, _missed);
+        break;
+      case SwarmKernel::SSE:
+        stepSse(_field, result, _missed);
+        break;
+#endif
+      default:
+        stepScalar(_field, result, _missed);
+        break;
+      }
+      return result;
+    }
+
+   public:  // State
+    template <typename Archive>
+    void serialize(Archive &_archive) {
+      // The padded arrays go whole so the parked balls come back too
+      uint64_t balls = count, padded = x.size();
+      _archive.value(balls);
+      _archive.value(padded);
+      if (Archive::READING) {
+        // A damaged file could claim any size, only trust one the data left can hold
+        if (balls > padded || !_archive.has(padded * 4 * sizeof(float))) balls = padded = 0;
+        count = size_t(balls);
+        x.resize(size_t(padded));
+        y.resize(size_t(padded));
+        vx.resize(size_t(padded));
+        vy.resize(size_t(padded));
+      }
+      for (size_t i = 0; i < x.size(); i++) {
+        _archive.value(x[i]);
+        _archive.value(y[i]);
+        _archive.value(vx[i]);
+        _archive.value(vy[i]);
+      }
+    }
+
+   private:  // Kernels
+    void stepScalar(const SwarmField &_field, SwarmStep &_result, std::vector<uint32_t> &_missed) {
+      float bestLeft = 3.4e38f, bestRight = 3.4e38f;
+      for (size_t i = 0; i < count; i++) {
+        // Move
+        float bx = x[i] + vx[i] * _field.timeScale;
+        float by = y[i] + vy[i] * _field.timeScale;
+        float bvx = vx[i], bvy = vy[i];
+
+        // Bounce off the top and bottom walls
+        if (by < 3 && bvy < 0) {
+          by = 3;
+          bvy = -bvy;
+          _result.wallBounces++;
+        } else if (by > _field.height - 1 && bvy > 0) {
+          by = _field.height - 1;
+          bvy = -bvy;
+          _result.wallBounces++;
+        }
+
+        // Return off a paddle or get past it, using the cell the ball is in like the single ball does
+        float cellY = float(int(by));
+        bool  missed = false;
+        if (bx < 1) {
+          float relative = _field.leftPaddleY - cellY;
+          if (relative <= _field.paddleHalfHeight && relative >= -_field.paddleHalfHeight) {
+            bx = 1;
+            if (bvx < 0) {
+              bvx = -bvx;
+              _result.paddleHits++;
+            }
+          } else {
+            _result.leftMisses++;
+            missed = true;
+          }
+        }
+        if (bx > _field.width - 1) {
+          float relative = cellY - _field.rightPaddleY;
+          if (relative <= _field.paddleHalfHeight && relative >= -_field.paddleHalfHeight) {
+            bx = _field.width - 2;
+            if (bvx > 0) {
+              bvx = -bvx;
+              _result.paddleHits++;
+            }
+          } else {
+            _result.rightMisses++;
+            missed = true;
+          }
+        }
+        if (missed) _missed.push_back(uint32_t(i));
+
+        // Keep track of the nearest ball heading for each paddle
+        if (!missed && bvx < 0 && bx < bestLeft) {
+          bestLeft = bx;
+          _result.leftTarget = int32_t(i);
+        }
+        if (!missed && bvx > 0 && _field.width - bx < bestRight) {
+          bestRight = _field.width - bx;
+          _result.rightTarget = int32_t(i);
+        }
+
+        x[i] = bx;
+        y[i] = by;
+        vx[i] = bvx;
+        vy[i] = bvy;
+      }
+    }
+#ifdef PONG_SWARM_X86
+    static int popcount(unsigned _bits) {
+      // Lane masks are at most 8 bits, count them without needing a POPCNT instruction
+      _bits = _bits - ((_bits >> 1) & 0x55);
+      _bits = (_bits & 0x33) + ((_bits >> 2) & 0x33);
+      return int((_bits + (_bits >> 4)) & 0x0f);
+    }
+    static void pickNearest(const float *_distance, const int32_t *_index, size_t _lanes, int32_t &_target) {
+      // Lanes kept their own nearest ball, the nearest of those wins with ties going to the earlier ball
+      float best = 3.4e38f;
+      for (size_t lane = 0; lane < _lanes; lane++) {
+        if (_index[lane] < 0) continue;
+        if (_distance[lane] < best || (_distance[lane] == best && _index[lane] < _target)) {
+          best = _distance[lane];
+          _target = _index[lane];
+        }
+      }
+    }
+    void stepSse(const SwarmField &_field, SwarmStep &_result, std::vector<uint32_t> &_missed) {
+      const __m128 timeScale = _mm_set1_ps(_field.timeScale);
+      const __m128 zero = _mm_setzero_ps();
+      const __m128 signBit = _mm_set1_ps(-0.0f);
+      const __m128 top = _mm_set1_ps(3), bottom = _mm_set1_ps(_field.height - 1);
+      const __m128 one = _mm_set1_ps(1), rightEdge = _mm_set1_ps(_field.width - 1), rightReturn = _mm_set1_ps(_field.width - 2);
+      const __m128 width = _mm_set1_ps(_field.width);
+      const __m128 half = _mm_set1_ps(_field.paddleHalfHeight), minusHalf = _mm_set1_ps(-_field.paddleHalfHeight);
+      const __m128 leftPaddle = _mm_set1_ps(_field.leftPaddleY), rightPaddle = _mm_set1_ps(_field.rightPaddleY);
+      __m128  bestLeft = _mm_set1_ps(3.4e38f), bestRight = _mm_set1_ps(3.4e38f);
+      __m128i leftIndex = _mm_set1_epi32(-1), rightIndex = _mm_set1_epi32(-1);
+      __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+      const __m128i step = _mm_set1_epi32(4);
+
+      // Work on locals so the compiler doesn't go back to memory for them every vector
+      float *   px = x.data(), *py = y.data(), *pvx = vx.data(), *pvy = vy.data();
+      size_t    padded = x.size();
+      uint32_t  wallBounces = 0, paddleHits = 0, leftMisses = 0, rightMisses = 0;
+
+      for (size_t i = 0; i < padded; i += 4) {
+        __m128 bvx = _mm_loadu_ps(&pvx[i]), bvy = _mm_loadu_ps(&pvy[i]);
+        __m128 bx = _mm_add_ps(_mm_loadu_ps(&px[i]), _mm_mul_ps(bvx, timeScale));
+        __m128 by = _mm_add_ps(_mm_loadu_ps(&py[i]), _mm_mul_ps(bvy, timeScale));
+
+        // Walls
+        __m128 hitTop = _mm_and_ps(_mm_cmplt_ps(by, top), _mm_cmplt_ps(bvy, zero));
+        __m128 hitBottom = _mm_andnot_ps(hitTop, _mm_and_ps(_mm_cmpgt_ps(by, bottom), _mm_cmpgt_ps(bvy, zero)));
+        __m128 hitWall = _mm_or_ps(hitTop, hitBottom);
+        by = _mm_or_ps(_mm_andnot_ps(hitWall, by), _mm_or_ps(_mm_and_ps(hitTop, top), _mm_and_ps(hitBottom, bottom)));
+        bvy = _mm_xor_ps(bvy, _mm_and_ps(hitWall, signBit));
+        wallBounces += popcount(_mm_movemask_ps(hitWall));
+
+        // Paddles
+        __m128 cellY = _mm_cvtepi32_ps(_mm_cvttps_epi32(by));
+        __m128 pastLeft = _mm_cmplt_ps(bx, one);
+        __m128 relative = _mm_sub_ps(leftPaddle, cellY);
+        __m128 inReach = _mm_and_ps(_mm_cmple_ps(relative, half), _mm_cmpge_ps(relative, minusHalf));
+        __m128 returnLeft = _mm_and_ps(pastLeft, inReach);
+        __m128 missLeft = _mm_andnot_ps(inReach, pastLeft);
+        __m128 flipLeft = _mm_and_ps(returnLeft, _mm_cmplt_ps(bvx, zero));
+        bx = _mm_or_ps(_mm_andnot_ps(returnLeft, bx), _mm_and_ps(returnLeft, one));
+        bvx = _mm_xor_ps(bvx, _mm_and_ps(flipLeft, signBit));
+
+        __m128 pastRight = _mm_cmpgt_ps(bx, rightEdge);
+        relative = _mm_sub_ps(cellY, rightPaddle);
+        inReach = _mm_and_ps(_mm_cmple_ps(relative, half), _mm_cmpge_ps(relative, minusHalf));
+        __m128 returnRight = _mm_and_ps(pastRight, inReach);
+        __m128 missRight = _mm_andnot_ps(inReach, pastRight);
+        __m128 flipRight = _mm_and_ps(returnRight, _mm_cmpgt_ps(bvx, zero));
+        bx = _mm_or_ps(_mm_andnot_ps(returnRight, bx), _mm_and_ps(returnRight, rightReturn));
+        bvx = _mm_xor_ps(bvx, _mm_and_ps(flipRight, signBit));
+
+        paddleHits += popcount(_mm_movemask_ps(flipLeft)) + popcount(_mm_movemask_ps(flipRight));
+        int leftMask = _mm_movemask_ps(missLeft), rightMask = _mm_movemask_ps(missRight);
+        leftMisses += popcount(leftMask);
+        rightMisses += popcount(rightMask);
+        for (int bits = leftMask | rightMask; bits; bits &= bits - 1) _missed.push_back(uint32_t(i + ctz(bits)));
+
+        // Nearest ball heading for each paddle
+        __m128 missed = _mm_or_ps(missLeft, missRight);
+        __m128 closerLeft = _mm_andnot_ps(missed, _mm_and_ps(_mm_cmplt_ps(bvx, zero), _mm_cmplt_ps(bx, bestLeft)));
+        bestLeft = _mm_or_ps(_mm_andnot_ps(closerLeft, bestLeft), _mm_and_ps(closerLeft, bx));
+        leftIndex = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(closerLeft), leftIndex), _mm_and_si128(_mm_castps_si128(closerLeft), index));
+        __m128 distance = _mm_sub_ps(width, bx);
+        __m128 closerRight = _mm_andnot_ps(missed, _mm_and_ps(_mm_cmpgt_ps(bvx, zero), _mm_cmplt_ps(distance, bestRight)));
+        bestRight = _mm_or_ps(_mm_andnot_ps(closerRight, bestRight), _mm_and_ps(closerRight, distance));
+        rightIndex = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(closerRight), rightIndex), _mm_and_si128(_mm_castps_si128(closerRight), index));
+        index = _mm_add_epi32(index, step);
+
+        _mm_storeu_ps(&px[i], bx);
+        _mm_storeu_ps(&py[i], by);
+        _mm_storeu_ps(&pvx[i], bvx);
+        _mm_storeu_ps(&pvy[i], bvy);
+      }
+      _result.wallBounces = wallBounces;
+      _result.paddleHits = paddleHits;
+      _result.leftMisses = leftMisses;
+      _result.rightMisses = rightMisses;
+
+      alignas(16) float   distances[4];
+      alignas(16) int32_t indices[4];
+      _mm_store_ps(distances, bestLeft);
+      _mm_store_si128((__m128i *)indices, leftIndex);
+      pickNearest(distances, indices, 4, _result.leftTarget);
+      _mm_store_ps(distances, bestRight);
+      _mm_store_si128((__m128i *)indices, rightIndex);
+      pickNearest(distances, indices, 4, _result.rightTarget);
+    }
+    PONG_TARGET_AVX2 void stepAvx2(const SwarmField &_field, SwarmStep &_result, std::vector<uint32_t> &_missed) {
+      const __m256 timeScale = _mm256_set1_ps(_field.timeScale);
+      const __m256 zero = _mm256_setzero_ps();
+      const __m256 signBit = _mm256_set1_ps(-0.0f);
+      const __m256 top = _mm256_set1_ps(3), bottom = _mm256_set1_ps(_field.height - 1);
+      const __m256 one = _mm256_set1_ps(1), rightEdge = _mm256_set1_ps(_field.width - 1), rightReturn = _mm256_set1_ps(_field.width - 2);
+      const __m256 width = _mm256_set1_ps(_field.width);
+      const __m256 half = _mm256_set1_ps(_field.paddleHalfHeight), minusHalf = _mm256_set1_ps(-_field.paddleHalfHeight);
+      const __m256 leftPaddle = _mm256_set1_ps(_field.leftPaddleY), rightPaddle = _mm256_set1_ps(_field.rightPaddleY);
+      __m256  bestLeft = _mm256_set1_ps(3.4e38f), bestRight = _mm256_set1_ps(3.4e38f);
+      __m256i leftIndex = _mm256_set1_epi32(-1), rightIndex = _mm256_set1_epi32(-1);
+      __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+      const __m256i step = _mm256_set1_epi32(8);
+
+      // Work on locals so the compiler doesn't go back to memory for them every vector
+      float *   px = x.data(), *py = y.data(), *pvx = vx.data(), *pvy = vy.data();
+      size_t    padded = x.size();
+      uint32_t  wallBounces = 0, paddleHits = 0, leftMisses = 0, rightMisses = 0;
+
+      for (size_t i = 0; i < padded; i += 8) {
+        __m256 bvx = _mm256_loadu_ps(&pvx[i]), bvy = _mm256_loadu_ps(&pvy[i]);
+        __m256 bx = _mm256_add_ps(_mm256_loadu_ps(&px[i]), _mm256_mul_ps(bvx, timeScale));
+        __m256 by = _mm256_add_ps(_mm256_loadu_ps(&py[i]), _mm256_mul_ps(bvy, timeScale));
+
+        // Walls
+        __m256 hitTop = _mm256_and_ps(_mm256_cmp_ps(by, top, _CMP_LT_OQ), _mm256_cmp_ps(bvy, zero, _CMP_LT_OQ));
+        __m256 hitBottom = _mm256_andnot_ps(hitTop, _mm256_and_ps(_mm256_cmp_ps(by, bottom, _CMP_GT_OQ), _mm256_cmp_ps(bvy, zero, _CMP_GT_OQ)));
+        __m256 hitWall = _mm256_or_ps(hitTop, hitBottom);
+        by = _mm256_blendv_ps(by, _mm256_blendv_ps(bottom, top, hitTop), hitWall);
+        bvy = _mm256_xor_ps(bvy, _mm256_and_ps(hitWall, signBit));
+        wallBounces += popcount(_mm256_movemask_ps(hitWall));
+
+        // Paddles
+        __m256 cellY = _mm256_round_ps(by, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __m256 pastLeft = _mm256_cmp_ps(bx, one, _CMP_LT_OQ);
+        __m256 relative = _mm256_sub_ps(leftPaddle, cellY);
+        __m256 inReach = _mm256_and_ps(_mm256_cmp_ps(relative, half, _CMP_LE_OQ), _mm256_cmp_ps(relative, minusHalf, _CMP_GE_OQ));
+        __m256 returnLeft = _mm256_and_ps(pastLeft, inReach);
+        __m256 missLeft = _mm256_andnot_ps(inReach, pastLeft);
+        __m256 flipLeft = _mm256_and_ps(returnLeft, _mm256_cmp_ps(bvx, zero, _CMP_LT_OQ));
+        bx = _mm256_blendv_ps(bx, one, returnLeft);
+        bvx = _mm256_xor_ps(bvx, _mm256_and_ps(flipLeft, signBit));
+
+        __m256 pastRight = _mm256_cmp_ps(bx, rightEdge, _CMP_GT_OQ);
+        relative = _mm256_sub_ps(cellY, rightPaddle);
+        inReach = _mm256_and_ps(_mm256_cmp_ps(relative, half, _CMP_LE_OQ), _mm256_cmp_ps(relative, minusHalf, _CMP_GE_OQ));
+        __m256 returnRight = _mm256_and_ps(pastRight, inReach);
+        __m256 missRight = _mm256_andnot_ps(inReach, pastRight);
+        __m256 flipRight = _mm256_and_ps(returnRight, _mm256_cmp_ps(bvx, zero, _CMP_GT_OQ));
+        bx = _mm256_blendv_ps(bx, rightReturn, returnRight);
+        bvx = _mm256_xor_ps(bvx, _mm256_and_ps(flipRight, signBit));
+
+        paddleHits += popcount(_mm256_movemask_ps(flipLeft)) + popcount(_mm256_movemask_ps(flipRight));
+        int leftMask = _mm256_movemask_ps(missLeft), rightMask = _mm256_movemask_ps(missRight);
+        leftMisses += popcount(leftMask);
+        rightMisses += popcount(rightMask);
+        for (int bits = leftMask | rightMask; bits; bits &= bits - 1) _missed.push_back(uint32_t(i + ctz(bits)));
+
+        // Nearest ball heading for each paddle
+        __m256 missed = _mm256_or_ps(missLeft, missRight);
+        __m256 closerLeft = _mm256_andnot_ps(missed, _mm256_and_ps(_mm256_cmp_ps(bvx, zero, _CMP_LT_OQ), _mm256_cmp_ps(bx, bestLeft, _CMP_LT_OQ)));
+        bestLeft = _mm256_blendv_ps(bestLeft, bx, closerLeft);
+        leftIndex = _mm256_blendv_epi8(leftIndex, index, _mm256_castps_si256(closerLeft));
+        __m256 distance = _mm256_sub_ps(width, bx);
+        __m256 closerRight = _mm256_andnot_ps(missed, _mm256_and_ps(_mm256_cmp_ps(bvx, zero, _CMP_GT_OQ), _mm256_cmp_ps(distance, bestRight, _CMP_LT_OQ)));
+        bestRight = _mm256_blendv_ps(bestRight, distance, closerRight);
+        rightIndex = _mm256_blendv_epi8(rightIndex, index, _mm256_castps_si256(closerRight));
+        index = _mm256_add_epi32(index, step);
+
+        _mm256_storeu_ps(&px[i], bx);
+        _mm256_storeu_ps(&py[i], by);
+        _mm256_storeu_ps(&pvx[i], bvx);
+        _mm256_storeu_ps(&pvy[i], bvy);
+      }
+      _result.wallBounces = wallBounces;
+      _result.paddleHits = paddleHits;
+      _result.leftMisses = leftMisses;
+      _result.rightMisses = rightMisses;
+
+      alignas(32) float   distances[8];
+      alignas(32) int32_t indices[8];
+      _mm256_store_ps(distances, bestLeft);
+      _mm256_store_si256((__m256i *)indices, leftIndex);
+      pickNearest(distances, indices, 8, _result.leftTarget);
+      _mm256_store_ps(distances, bestRight);
+      _mm256_store_si256((__m256i *)indices, rightIndex);
+      pickNearest(distances, indices, 8, _result.rightTarget);
+    }
+    static int ctz(int _bits) {
+#if defined(__GNUC__) || defined(__clang__)
+      return __builtin_ctz(unsigned(_bits));
+#elif defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward(&index, static_cast<unsigned long>(_bits));
+      return int(index);
+#else
+      int zeros = 0;
+      while (!(_bits & 1)) {
+        _bits >>= 1;
+        zeros++;
+      }
+      return zeros;
+#endif
+    }
+#endif
+
+   private:  // Data
+    std::vector<float> x, y;                          // Ball positions
+    std::vector<float> vx, vy;                        // Ball velocities in cells per reference tick
+    size_t             count = 0;                     // Balls in play, the arrays are padded past this
+    SwarmKernel        kernel = SwarmKernel::SCALAR;  // How step runs
+  };
+
+}  // namespace pong
+
+#endif  // PONG_BALL_SWARM_H
@@ -0,0 +1,204 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_BANNERS_H
+#define PONG_BANNERS_H
+
+namespace pong {
+
+  // The screen width banners are centred for, the game's 79 columns
+  static const int BANNER_WIDTH = 79;
+
+  // Rows of screen cells baked at compile time, '\0' leaves the cell underneath as it is
+  template <int ROWS>
+  struct BannerImage {
+    static const int WIDTH = BANNER_WIDTH;
+    static const int HEIGHT = ROWS;
+
+    char glyphs[ROWS][BANNER_WIDTH];  // Every row of the banner, already at its place across the screen
+  };
+
+  // Centre the art as one block, every row starting in the same column
+  template <int ROWS>
+  constexpr BannerImage<ROWS> bakeBanner(const char *const (&_rows)[ROWS]) {
+    BannerImage<ROWS> image{};
+    int               width = 0;
+    for (int row = 0; row < ROWS; row++) {
+      int length = 0;
+      while (_rows[row][length]) length++;
+      if (length > width) width = length;
+    }
+    int left = (BANNER_WIDTH - width) / 2;
+    for (int row = 0; row < ROWS; row++) {
+      for (int i = 0; _rows[row][i]; i++) {
+        if (left + i >= 0 && left + i < BANNER_WIDTH) image.glyphs[row][left + i] = _rows[row][i];
+      }
+    }
+    return image;
+  }
+
+  // The greeting above the title
+  static constexpr const char *WELCOME_ART[] = {
+      " Welcome to:                             "};
+
+  // The game title
+  static constexpr const char *TITLE_ART[] = {
+      " _______  _______  __    _  _______  __  ",
+      "|       ||       ||  |  | ||       ||  | ",
+      "|    _  ||   _   ||   |_| ||    ___||  | ",
+      "|   |_| ||  | |  ||       ||   | __ |  | ",
+      "|    ___||  |_|  ||  _    ||   ||  ||__| ",
+      "|   |    |       || | |   ||   |_| | __  ",
+      "|___|    |_______||_|  |__||_______||__| "};
+
+  // Game mode banners
+  static constexpr const char *MULTIPLAYER_ART[] = {
+      " _______  __   __  _______  __  ",
+      "|       ||  | |  ||       ||  | ",
+      "|    _  ||  |_|  ||    _  ||  | ",
+      "|   |_| ||       ||   |_| ||  | ",
+      "|    ___||       ||    ___||__| ",
+      "|   |     |     | |   |     __  ",
+      "|___|      |___|  |___|    |__| "};
+
+  static constexpr const char *EASY_ART[] = {
+      " _______  _______  _______  __   __  __  ",
+      "|       ||   _   ||       ||  | |  ||  | ",
+      "|    ___||  |_|  ||  _____||  |_|  ||  | ",
+      "|   |___ |       || |_____ |       ||  | ",
+      "|    ___||       ||_____  ||_     _||__| ",
+      "|   |___ |   _   | _____| |  |   |   __  ",
+      "|_______||__| |__||_______|  |___|  |__| "};
+
+  static constexpr const char *MEDIUM_ART[] = {
+      " __   __  _______  ______   ___   __   __  __   __  __  ",
+      "|  |_|  ||       ||      | |   | |  | |  ||  |_|  ||  | ",
+      "|       ||    ___||  _    ||   | |  | |  ||       ||  | ",
+      "|       ||   |___ | | |   ||   | |  |_|  ||       ||  | ",
+      "|       ||    ___|| |_|   ||   | |       ||       ||__| ",
+      "| ||_|| ||   |___ |       ||   | |       || ||_|| | __  ",
+      "|_|   |_||_______||______| |___| |_______||_|   |_||__| "};
+
+  static constexpr const char *HARD_ART[] = {
+      " __   __  _______  ______    ______   __  ",
+      "|  | |  ||   _   ||    _ |  |      | |  | ",
+      "|  |_|  ||  |_|  ||   | ||  |  _    ||  | ",
+      "|       ||       ||   |_||_ | | |   ||  | ",
+      "|       ||       ||    __  || |_|   ||__| ",
+      "|   _   ||   _   ||   |  | ||       | __  ",
+      "|__| |__||__| |__||___|  |_||______| |__|"};
+
+  static constexpr const char *IMPOSSIBLE_ART[] = {
+      " ______   _______  _______  _______  __   __  __  ",
+      "|      | |       ||   _   ||       ||  | |  ||  | ",
+      "|  _    ||    ___||  |_|  ||_     _||  |_|  ||  | ",
+      "| | |   ||   |___ |       |  |   |  |       ||  | ",
+      "| |_|   ||    ___||       |  |   |  |       ||__| ",
+      "|       ||   |___ |   _   |  |   |  |   _   | __  ",
+      "|______| |_______||__| |__|  |___|  |__| |__||__|"};
+
+  static constexpr const char *MULTIBALL_ART[] = {
+      " __   __  __   __  ___      _______  ___   __  ",
+      "|  |_|  ||  | |  ||   |    |       ||   | |  | ",
+      "|       ||  | |  ||   |    |_     _||   | |  | ",
+      "|       ||  |_|  ||   |      |   |  |   | |  | ",
+      "|       ||       ||   |___   |   |  |   | |__| ",
+      "| ||_|| ||       ||       |  |   |  |   |  __  ",
+      "|_|   |_||_______||_______|  |___|  |___| |__| "};
+
+  static constexpr const char *EXPERT_ART[] = {
+      " _______  __   __  _______  _______  ______    _______  __  ",
+      "|       ||  |_|  ||       ||       ||    _ |  |       ||  | ",
+      "|    ___||       ||    _  ||    ___||   | ||  |_     _||  | ",
+      "|   |___ |       ||   |_| ||   |___ |   |_||_   |   |  |  | ",
+      "|    ___| |     | |    ___||    ___||    __  |  |   |  |__| ",
+      "|   |___ |   _   ||   |    |   |___ |   |  | |  |   |   __  ",
+      "|_______||__| |__||___|    |_______||___|  |_|  |___|  |__| "};
+
+  // Winner screens, the word and then who won. Each word is padded to the width of the name under it so the two
+  // centre together.
+  static constexpr const char *PLAYER_1_WINNER_ART[] = {
+      "     _     _  ___   __    _  __    _  _______  ______    ___         ",
+      "    | | _ | ||   | |  |  | ||  |  | ||       ||    _ |  |   |        ",
+      "    | || || ||   | |   |_| ||   |_| ||    ___||   | ||  |___|        ",
+      "    |       ||   | |       ||       ||   |___ |   |_||_  ___         ",
+      "    |       ||   | |  _    ||  _    ||    ___||    __  ||   |        ",
+      "    |   _   ||   | | | |   || | |   ||   |___ |   |  | ||___|        ",
+      "    |__| |__||___| |_|  |__||_|  |__||_______||___|  |_|             "};
+
+  static constexpr const char *PLAYER_1_ART[] = {
+      " _______  ___      _______  __   __  _______  ______      ____   __  ",
+      "|       ||   |    |   _   ||  | |  ||       ||    _ |    |    | |  | ",
+      "|    _  ||   |    |  |_|  ||  |_|  ||    ___||   | ||     |   | |  | ",
+      "|   |_| ||   |    |       ||       ||   |___ |   |_||_    |   | |  | ",
+      "|    ___||   |___ |       ||_     _||    ___||    __  |   |   | |__| ",
+      "|   |    |       ||   _   |  |   |  |   |___ |   |  | |   |   |  __  ",
+      "|___|    |_______||__| |__|  |___|  |_______||___|  |_|   |___| |__| "};
+
+  static constexpr const char *PLAYER_2_WINNER_ART[] = {
+      "     _     _  ___   __    _  __    _  _______  ______    ___           ",
+      "    | | _ | ||   | |  |  | ||  |  | ||       ||    _ |  |   |          ",
+      "    | || || ||   | |   |_| ||   |_| ||    ___||   | ||  |___|          ",
+      "    |       ||   | |       ||       ||   |___ |   |_||_  ___           ",
+      "    |       ||   | |  _    ||  _    ||    ___||    __  ||   |          ",
+      "    |   _   ||   | | | |   || | |   ||   |___ |   |  | ||___|          ",
+      "    |__| |__||___| |_|  |__||_|  |__||_______||___|  |_|               "};
+
+  static constexpr const char *PLAYER_2_ART[] = {
+      " _______  ___      _______  __   __  _______  ______      _______  __  ",
+      "|       ||   |    |   _   ||  | |  ||       ||    _ |    |       ||  | ",
+      "|    _  ||   |    |  |_|  ||  |_|  ||    ___||   | ||    |____   ||  | ",
+      "|   |_| ||   |    |       ||       ||   |___ |   |_||_    ____|  ||  | ",
+      "|    ___||   |___ |       ||_     _||    ___||    __  |  | ______||__| ",
+      "|   |    |       ||   _   |  |   |  |   |___ |   |  | |  | |_____  __  ",
+      "|___|    |_______||__| |__|  |___|  |_______||___|  |_|  |_______||__| "};
+
+  static constexpr const char *CPU_WINNER_ART[] = {
+      " _     _  ___   __    _  __    _  _______  ______    ___  ",
+      "| | _ | ||   | |  |  | ||  |  | ||       ||    _ |  |   | ",
+      "| || || ||   | |   |_| ||   |_| ||    ___||   | ||  |___| ",
+      "|       ||   | |       ||       ||   |___ |   |_||_  ___  ",
+      "|       ||   | |  _    ||  _    ||    ___||    __  ||   | ",
+      "|   _   ||   | | | |   || | |   ||   |___ |   |  | ||___| ",
+      "|__| |__||___| |_|  |__||_|  |__||_______||___|  |_|      "};
+
+  static constexpr const char *CPU_ART[] = {
+      "           _______  _______  __   __  __                  ",
+      "          |       ||       ||  | |  ||  |                 ",
+      "          |       ||    _  ||  | |  ||  |                 ",
+      "          |       ||   |_| ||  |_|  ||  |                 ",
+      "          |      _||    ___||       ||__|                 ",
+      "          |     |_ |   |    |       | __                  ",
+      "          |_______||___|    |_______||__|                 "};
+
+  // The art as it lands on screen
+  static constexpr auto WELCOME_BANNER = bakeBanner(WELCOME_ART);
+  static constexpr auto TITLE_BANNER = bakeBanner(TITLE_ART);
+  static constexpr auto MULTIPLAYER_BANNER = bakeBanner(MULTIPLAYER_ART);
+  static constexpr auto EASY_BANNER = bakeBanner(EASY_ART);
+  static constexpr auto MEDIUM_BANNER = bakeBanner(MEDIUM_ART);
+  static constexpr auto HARD_BANNER = bakeBanner(HARD_ART);
+  static constexpr auto IMPOSSIBLE_BANNER = bakeBanner(IMPOSSIBLE_ART);
+  static constexpr auto MULTIBALL_BANNER = bakeBanner(MULTIBALL_ART);
+  static constexpr auto EXPERT_BANNER = bakeBanner(EXPERT_ART);
+  static constexpr auto PLAYER_1_WINNER_BANNER = bakeBanner(PLAYER_1_WINNER_ART);
+  static constexpr auto PLAYER_1_BANNER = bakeBanner(PLAYER_1_ART);
+  static constexpr auto PLAYER_2_WINNER_BANNER = bakeBanner(PLAYER_2_WINNER_ART);
+  static constexpr auto PLAYER_2_BANNER = bakeBanner(PLAYER_2_ART);
+  static constexpr auto CPU_WINNER_BANNER = bakeBanner(CPU_WINNER_ART);
+  static constexpr auto CPU_BANNER = bakeBanner(CPU_ART);
+
+}  // namespace pong
+
+#endif  // PONG_BANNERS_H
@@ -0,0 +1,298 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_COMPACT_STATE_H
+#define PONG_COMPACT_STATE_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Simulation.h"
+
+namespace pong {
+
+  // The rules a match is played to, which stay the same from one tick to the next
+  struct StepRules {
+    int  width = 79, height = 35;  // The play area
+    Real timeScale = 1;            // Reference ticks covered by one tick
+    Real maxXSpeed = 3;            // Fastest the ball crosses the field
+    Real minXSpeed = 2;            // Slowest the ball crosses the field
+    Real maxYSpeed = Real(1.5f);   // Fastest the ball climbs or falls
+    int  winningScore = 5;         // Score needed to win outside of survival mode
+    bool autoServe = false;        // Serve and restart play straight after a point
+
+    static StepRules capture(const Simulation &_sim) {
+      StepRules rules;
+      rules.width = _sim.width;
+      rules.height = _sim.height;
+      rules.timeScale = _sim.timeScale;
+      rules.maxXSpeed = _sim.maxXSpeed;
+      rules.minXSpeed = _sim.minXSpeed;
+      rules.maxYSpeed = _sim.maxYSpeed;
+      rules.winningScore = _sim.winningScore;
+      rules.autoServe = _sim.autoServe;
+      return rules;
+    }
+  };
+
+  // Everything a single ball match needs to play on, in under a hundred bytes that copy with a memcpy, so a search
+  // can clone a position and try futures from it. step() plays a tick exactly as Simulation::tick does when both
+  // paddles are moved by the inputs, as in multiplayer and expert. Multi-ball and CPU steered paddles aren't covered.
+  struct CompactState {
+   public:  // Types
+    enum Paddle { PLAYER_1, PLAYER_2, CPU, PADDLE_COUNT };
+    enum Flag : uint8_t {
+      FLAG_PLAYER_1_LOST = 1 << 0,  // Player 1 lost the last point
+      FLAG_PLAYER_2_LOST = 1 << 1,  // Player 2 lost the last point
+      FLAG_CPU_LOST = 1 << 2        // The CPU lost the last point
+    };
+
+   public:  // Data
+    Random    random;                                       // The match's generator, so futures draw the same serves and returns
+    Real      ballX = 0, ballY = 0;                         // Where the ball is
+    Real      ballVX = 0, ballVY = 0;                       // Its velocity per reference tick
+    Real      originX = 0, originY = 0;                     // Where its current path started
+    Real      pathOffset = 0;                               // How far through its tick the path started
+    uint32_t  pathTicks = 0;                                // Tick boundaries crossed since the path started
+    Real      paddleY[PADDLE_COUNT] = {};                   // The middle of each paddle
+    int16_t   score[PADDLE_COUNT] = {};                     // Each paddle's score
+    uint8_t   flags = 0;                                    // Who lost the last point
+    GameMode  gameMode = GameMode::MULTIPLAYER;             // Which paddles play
+    GameState gameState = GameState::PAUSED;                // Whether the ball is in play and who won
+
+   public:  // Conversion
+    static CompactState capture(const Simulation &_sim) {
+      CompactState state;
+      state.random = _sim.random;
+      state.ballX = _sim.ball.x;
+      state.ballY = _sim.ball.y;
+      state.ballVX = _sim.ball.vx;
+      state.ballVY = _sim.ball.vy;
+      state.originX = _sim.ball.originX;
+      state.originY = _sim.ball.originY;
+      state.pathOffset = _sim.ball.pathOffset;
+      state.pathTicks = _sim.ball.pathTicks;
+      const Player *paddles[PADDLE_COUNT] = {&_sim.player1, &_sim.player2, &_sim.cpu};
+      for (int i = 0; i < PADDLE_COUNT; i++) {
+        state.paddleY[i] = paddles[i]->y;
+        state.score[i] = int16_t(paddles[i]->score);
+        if (paddles[i]->lostLastPoint) state.flags |= uint8_t(1 << i);
+      }
+      state.gameMode = _sim.gameMode;
+      state.gameState = _sim.gameState;
+      return state;
+    }
+    Paddle opponent() const {
+      return (gameMode == GameMode::MULTIPLAYER) ? PLAYER_2 : CPU;
+    }
+  };
+  static_assert(std::is_trivially_copyable<CompactState>::value, "CompactState has to clone with a memcpy");
+
+  namespace compact {
+
+    inline void clampPaddle(Real &_y, const StepRules &_rules) {
+      // Keep the paddle between the walls, as the simulation does after every move
+      const int half = 2;
+      int       top = int(_y - half);
+      int       bottom = int(_y + half);
+      if (top < 3) {
+        _y = Real(3 + half);
+      } else if (bottom > _rules.height - 1) {
+        _y = Real(_rules.height - 1 - half);
+      }
+    }
+    inline void movePaddle(Real &_y, int _travel, const StepRules &_rules) {
+      if (_travel < 0) {
+        _y = _y - Real(1) * (_rules.timeScale * -_travel / Inputs::FULL_TICK);
+        clampPaddle(_y, _rules);
+      } else if (_travel > 0) {
+        _y = _y + Real(1) * (_rules.timeScale * _travel / Inputs::FULL_TICK);
+        clampPaddle(_y, _rules);
+      }
+    }
+    inline void clampVelocity(Real &_vx, Real &_vy, const StepRules &_rules) {
+      if (_vx > _rules.maxXSpeed) _vx = _rules.maxXSpeed;
+      if (_vx < -_rules.maxXSpeed) _vx = -_rules.maxXSpeed;
+      if (_vx > -_rules.minXSpeed && _vx < 0) _vx = -_rules.minXSpeed;
+      if (_vx < _rules.minXSpeed && _vx > 0) _vx = _rules.minXSpeed;
+      if (_vy > _rules.maxYSpeed) _vy = _rules.maxYSpeed;
+      if (_vy < -_rules.maxYSpeed) _vy = -_rules.maxYSpeed;
+    }
+    inline void setPath(CompactState &_state, Real _x, Real _y, Real _offset) {
+      _state.ballX = _state.originX = _x;
+      _state.ballY = _state.originY = _y;
+      _state.pathOffset = _offset;
+      _state.pathTicks = 0;
+    }
+    inline Real pathAge(const CompactState &_state, uint32_t _tickBoundary) {
+      return Real(_tickBoundary) - _state.pathOffset;
+    }
+    inline void moveAlongPath(CompactState &_state, Real _age, const StepRules &_rules) {
+      _state.ballX = _state.originX + _state.ballVX * _rules.timeScale * _age;
+      _state.ballY = _state.originY + _state.ballVY * _rules.timeScale * _age;
+    }
+    inline Real nextBallEvent(const CompactState &_state, const StepRules &_rules, int *_surface) {
+      Real stepX = _state.ballVX * _rules.timeScale, stepY = _state.ballVY * _rules.timeScale;
+      Real best = realMax();
+      *_surface = SURFACE_NONE;
+      if (stepY < 0 && (3 - _state.originY) / stepY < best) {
+        best = (3 - _state.originY) / stepY;
+        *_surface = SURFACE_TOP;
+      } else if (stepY > 0 && (Real(_rules.height - 1) - _state.originY) / stepY < best) {
+        best = (Real(_rules.height - 1) - _state.originY) / stepY;
+        *_surface = SURFACE_BOTTOM;
+      }
+      if (stepX < 0 && (1 - _state.originX) / stepX < best) {
+        best = (1 - _state.originX) / stepX;
+        *_surface = SURFACE_LEFT;
+      } else if (stepX > 0 && (Real(_rules.width - 1) - _state.originX) / stepX < best) {
+        best = (Real(_rules.width - 1) - _state.originX) / stepX;
+        *_surface = SURFACE_RIGHT;
+      }
+      return best;
+    }
+    inline bool returnBall(CompactState &_state, int _relativeY, Real _low, Real _high, Real _planeX, Real _tickFraction,
+                           const StepRules &_rules) {
+      // The paddle covers two cells either side of its middle
+      if (_relativeY > 2 || _relativeY < -2) return false;
+      Real newXVelocity = _state.random.nextReal(_low, _high);
+      Real newYVelocity = _state.ballVY + _relativeY / 4 + _state.random.nextReal(Real(-0.5f), Real(0.5f));
+      clampVelocity(newXVelocity, newYVelocity, _rules);
+      _state.ballVX = newXVelocity;
+      _state.ballVY = newYVelocity;
+      setPath(_state, _planeX, _state.ballY, _tickFraction);
+      return true;
+    }
+    inline void setVelocities(CompactState &_state, Real _vx, Real _vy, const StepRules &_rules) {
+      // Drawn as arguments, like Ball::setVelocities, so the two draws come in the order the simulation takes them
+      clampVelocity(_vx, _vy, _rules);
+      _state.ballVX = _vx;
+      _state.ballVY = _vy;
+      setPath(_state, _state.ballX, _state.ballY, 0);
+    }
+    inline void serve(CompactState &_state, const StepRules &_rules) {
+      CompactState::Paddle opponent = _state.opponent();
+      if (_state.gameMode == GameMode::IMPOSSIBLE && _state.score[CompactState::PLAYER_1] > 0) _state.score[CompactState::PLAYER_1] = 0;
+
+      // Paddles back to the middle and the ball served towards whoever won the point
+      _state.paddleY[CompactState::PLAYER_1] = Real(_rules.height / 2);
+      clampPaddle(_state.paddleY[CompactState::PLAYER_1], _rules);
+      _state.paddleY[opponent] = Real(_rules.height / 2);
+      clampPaddle(_state.paddleY[opponent], _rules);
+      setPath(_state, Real(_rules.width / 2), Real(_rules.height / 2), 0);
+      Random &random = _state.random;
+      if (_state.flags & CompactState::FLAG_PLAYER_1_LOST) {
+        setVelocities(_state, random.nextReal(_rules.minXSpeed / 2, _rules.maxXSpeed / 2),
+                      random.nextReal(-_rules.maxYSpeed / 3, _rules.maxYSpeed / 3), _rules);
+        _state.flags &= uint8_t(~CompactState::FLAG_PLAYER_1_LOST);
+      } else if (_state.flags & (1 << opponent)) {
+        setVelocities(_state, random.nextReal(-_rules.maxXSpeed / 2, -_rules.minXSpeed / 2),
+                      random.nextReal(-_rules.maxYSpeed / 3, _rules.maxYSpeed / 3), _rules);
+        _state.flags &= uint8_t(~(1 << opponent));
+      } else {
+        setVelocities(_state, random.nextReal(-_rules.maxXSpeed / 2, _rules.maxXSpeed / 2),
+                      random.nextReal(-_rules.maxYSpeed / 3, _rules.maxYSpeed / 3), _rules);
+      }
+      _state.gameState = GameState::PAUSED;
+    }
+
+  }  // namespace compact
+
+  // Play one tick of _state, the inputs' player2 moves whichever paddle is the opponent. Returns the tick's events.
+  inline uint32_t step(CompactState &_state, const Inputs &_inputs, const StepRules &_rules) {
+    using namespace compact;
+    if (_state.gameState != GameState::IN_PLAY) return EVENT_NONE;
+    uint32_t             events = EVENT_NONE;
+    bool                 pointScored = false;
+    CompactState::Paddle opponent = _state.opponent();
+
+    // Move the paddles, then the ball against where they are now
+    movePaddle(_state.paddleY[CompactState::PLAYER_1], _inputs.player1, _rules);
+    movePaddle(_state.paddleY[opponent], _inputs.player2, _rules);
+    for (int bounce = 0; bounce < Simulation::MAX_BOUNCES_PER_TICK && !pointScored; bounce++) {
+      int  surface;
+      Real eventAge = nextBallEvent(_state, _rules, &surface);
+      Real tickStart = pathAge(_state, _state.pathTicks);
+      if (!(eventAge <= pathAge(_state, _state.pathTicks + 1))) break;
+      moveAlongPath(_state, eventAge, _rules);
+      Real tickFraction = eventAge - tickStart;
+
+      switch (surface) {
+      case SURFACE_TOP:
+      case SURFACE_BOTTOM:
+        _state.ballVY = -_state.ballVY;
+        setPath(_state, _state.ballX, surface == SURFACE_TOP ? Real(3) : Real(_rules.height - 1), tickFraction);
+        events |= EVENT_WALL_BOUNCE;
+        break;
+      case SURFACE_LEFT:
+        if (returnBall(_state, int(_state.paddleY[CompactState::PLAYER_1]) - int(_state.ballY), _rules.minXSpeed, _rules.maxXSpeed,
+                       1, tickFraction, _rules)) {
+          events |= EVENT_PADDLE_HIT;
+          if (_state.gameMode == GameMode::IMPOSSIBLE) {
+            _state.score[CompactState::PLAYER_1]++;
+            events |= EVENT_SURVIVAL_RETURN;
+          }
+        } else {
+          setPath(_state, 0, _state.ballY, tickFraction);
+          _state.flags |= CompactState::FLAG_PLAYER_1_LOST;
+          _state.score[opponent]++;
+          pointScored = true;
+        }
+        break;
+      case SURFACE_RIGHT:
+        if (returnBall(_state, int(_state.ballY) - int(_state.paddleY[opponent]), -_rules.maxXSpeed, -_rules.minXSpeed,
+                       Real(_rules.width - 1), tickFraction, _rules)) {
+          events |= EVENT_PADDLE_HIT;
+        } else {
+          setPath(_state, Real(_rules.width - 1), _state.ballY, tickFraction);
+          _state.flags |= uint8_t(1 << opponent);
+          _state.score[CompactState::PLAYER_1]++;
+          pointScored = true;
+        }
+        break;
+      default:
+        break;
+      }
+    }
+
+    // Carry on along the path to the end of the tick
+    if (!pointScored) {
+      _state.pathTicks++;
+      moveAlongPath(_state, pathAge(_state, _state.pathTicks), _rules);
+    }
+
+    // Hold play for the serve after a point, or call the winner
+    if (pointScored) {
+      events |= EVENT_POINT_SCORED;
+      _state.gameState = GameState::PAUSED;
+    }
+    if (_state.gameMode != GameMode::IMPOSSIBLE) {
+      if (_state.score[CompactState::PLAYER_1] >= _rules.winningScore) {
+        _state.gameState = GameState::PLAYER_1_WINNER;
+      } else if (_state.score[opponent] >= _rules.winningScore) {
+        _state.gameState = (_state.gameMode == GameMode::MULTIPLAYER) ? GameState::PLAYER_2_WINNER : GameState::CPU_WINNER;
+      }
+    }
+    if (_state.gameState > GameState::IN_PLAY) {
+      events |= EVENT_GAME_OVER;
+    } else if (pointScored && _rules.autoServe) {
+      serve(_state, _rules);
+      _state.gameState = GameState::IN_PLAY;
+    }
+    return events;
+  }
+
+}  // namespace pong
+
+#endif  // PONG_COMPACT_STATE_H
@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_CPU_PLAYER_H
+#define PONG_CPU_PLAYER_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "Fixed.h"
+#include "Random.h"
+
+namespace pong {
+
+  // How well a CPU plays, times and speeds are per reference tick like the ball's
+  struct CpuProfile {
+    Real reactionTicks = 0;     // Ticks a new approach goes unnoticed before the CPU predicts it
+    Real noise = 0;             // Furthest the prediction can be off by, in cells either way
+    Real maxSpeed = realMax();  // Fastest the paddle moves, in cells per tick
+  };
+
+  // The walls and the paddle plane a CPU's predictions are made against
+  struct CpuField {
+    Real top = 3;        // The top wall the ball bounces off
+    Real bottom = 34;    // The bottom wall the ball bounces off
+    Real planeX = 78;    // Where the ball meets this CPU's paddle
+    Real restY = 19;     // Where the paddle waits while the ball is heading away
+    Real timeScale = 1;  // Reference ticks covered by one tick
+  };
+
+  // Steers a paddle to where the ball will cross its plane, worked out once per approach
+  class CpuPlayer {
+   public:  // Prediction
+    static Real predictY(Real _x, Real _y, Real _vx, Real _vy, Real _planeX, Real _top, Real _bottom) {
+      // Run the ball straight to the plane, then fold the line back between the walls it would have bounced off
+      Real span = _bottom - _top;
+      if (_vx == 0 || span <= 0) return _y;
+      Real unfolded = _y + _vy * ((_planeX - _x) / _vx) - _top;
+      Real folded = fmod(unfolded, 2 * span);
+      if (folded < 0) folded += 2 * span;
+      if (folded > span) folded = 2 * span - folded;
+      return _top + folded;
+    }
+
+   public:  // Setup
+    void setProfile(const CpuProfile &_profile) {
+      profile = _profile;
+      forget();
+    }
+    const CpuProfile &getProfile() const {
+      return profile;
+    }
+    void setRandom(const Random &_random) {
+      random = _random;
+    }
+    void forget() {
+      // Drop the prediction, the next approach is seen as new
+      tracking = false;
+      predicted = false;
+    }
+
+   public:  // Steering
+    Real steer(Real _paddleY, bool _approaching, uint32_t _target, Real _x, Real _y, Real _vx, Real _vy, const CpuField &_field) {
+      // Returns where the paddle moves to this tick. A prediction holds until the ball being chased changes or stops
+      // approaching, wall bounces don't matter since the prediction already folds them in.
+      if (!_approaching) {
+        forget();
+        return moveTowards(_paddleY, _field.restY, _field.timeScale);
+      }
+      if (!tracking || _target != target) {
+        tracking = true;
+        predicted = false;
+        target = _target;
+        reactionLeft = profile.reactionTicks;
+      }
+
+      // Wait out the reaction time, then predict once for the rest of the approach
+      if (!predicted) {
+        if (reactionLeft > 0) {
+          reactionLeft -= _field.timeScale;
+          return _paddleY;
+        }
+        aimY = predictY(_x, _y, _vx, _vy, _field.planeX, _field.top, _field.bottom) + random.nextReal(-profile.noise, profile.noise);
+        predicted = true;
+      }
+      return moveTowards(_paddleY, aimY, _field.timeScale);
+    }
+
+   public:  // State
+    template <typename Archive>
+    void serialize(Archive &_archive) {
+      _archive.value(profile);
+      _archive.value(random);
+      _archive.value(tracking);
+      _archive.value(predicted);
+      _archive.value(target);
+      _archive.value(reactionLeft);
+      _archive.value(aimY);
+    }
+
+   private:  // Helpers
+    Real moveTowards(Real _from, Real _to, Real _timeScale) const {
+      Real step = profile.maxSpeed * _timeScale;
+      if (_to > _from + step) return _from + step;
+      if (_to < _from - step) return _from - step;
+      return _to;
+    }
+
+   private:  // Data
+    CpuProfile profile;            // How well this CPU plays
+    Random     random;             // Its own generator so the CPU's mistakes don't change how the ball plays
+    bool       tracking = false;   // A ball is approaching and being watched
+    bool       predicted = false;  // The intercept for the tracked ball has been worked out
+    uint32_t   target = 0;         // Which ball is being tracked, always 0 outside of multi-ball
+    Real       reactionLeft = 0;   // Reference ticks until the CPU notices the tracked ball
+    Real       aimY = 0;           // Where the paddle is heading for the tracked ball
+  };
+
+}  // namespace pong
+
+#endif  // PONG_CPU_PLAYER_H
@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_FIXED_H
+#define PONG_FIXED_H
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace pong {
+
+  // A Q16.16 fixed point number. Every operation is integer math written to mean the same on every compiler and CPU,
+  // so a game played with it ticks to the same bits everywhere. Results saturate at the ends of the range rather than
+  // wrap, which also lets the largest value stand in for infinity.
+  class Fixed {
+   public:  // Constants
+    static const int     FRACTION_BITS = 16;
+    static const int32_t ONE = int32_t(1) << FRACTION_BITS;
+
+   public:  // Constructors
+    constexpr Fixed() : bits(0) {}
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    constexpr Fixed(T _value) : bits(fromInteger(_value)) {}
+    explicit Fixed(float _value) : bits(fromFloat(_value)) {}
+    static constexpr Fixed fromRaw(int32_t _bits) {
+      return Fixed(_bits, RAW);
+    }
+    static constexpr Fixed max() {
+      return fromRaw(INT32_MAX);
+    }
+    static constexpr Fixed min() {
+      return fromRaw(-INT32_MAX);
+    }
+
+   public:  // Conversions
+    constexpr int32_t raw() const {
+      return bits;
+    }
+    explicit operator int() const {
+      // Towards zero, the same as converting a float
+      return int((bits < 0) ? -(-int64_t(bits) / ONE) : bits / ONE);
+    }
+    explicit operator float() const {
+      return float(bits) * (1.0f / float(ONE));
+    }
+    explicit operator double() const {
+      return double(bits) / double(ONE);
+    }
+
+   public:  // Arithmetic
+    friend Fixed operator+(Fixed _a, Fixed _b) {
+      return fromRaw(saturate(int64_t(_a.bits) + _b.bits));
+    }
+    friend Fixed operator-(Fixed _a, Fixed _b) {
+      return fromRaw(saturate(int64_t(_a.bits) - _b.bits));
+    }
+    friend Fixed operator*(Fixed _a, Fixed _b) {
+      // Round the 32.32 product to the nearest 16.16
+      return fromRaw(saturate(floorShift(int64_t(_a.bits) * _b.bits + ONE / 2)));
+    }
+    friend Fixed operator/(Fixed _a, Fixed _b) {
+      // Integer division truncates towards zero on every compiler since C++11, dividing by zero gives the end of the
+      // range on the side of the dividend
+      if (_b.bits == 0) return (_a.bits < 0) ? min() : (_a.bits > 0) ? max() : Fixed();
+      return fromRaw(saturate(int64_t(_a.bits) * ONE / _b.bits));
+    }
+    Fixed operator-() const {
+      return fromRaw(-bits);
+    }
+    Fixed &operator+=(Fixed _b) {
+      return *this = *this + _b;
+    }
+    Fixed &operator-=(Fixed _b) {
+      return *this = *this - _b;
+    }
+    Fixed &operator*=(Fixed _b) {
+      return *this = *this * _b;
+    }
+    Fixed &operator/=(Fixed _b) {
+      return *this = *this / _b;
+    }
+
+   public:  // Comparisons
+    friend bool operator==(Fixed _a, Fixed _b) {
+      return _a.bits == _b.bits;
+    }
+    friend bool operator!=(Fixed _a, Fixed _b) {
+      return _a.bits != _b.bits;
+    }
+    friend bool operator<(Fixed _a, Fixed _b) {
+      return _a.bits < _b.bits;
+    }
+    friend bool operator<=(Fixed _a, Fixed _b) {
+      return _a.bits <= _b.bits;
+    }
+    friend bool operator>(Fixed _a, Fixed _b) {
+      return _a.bits > _b.bits;
+    }
+    friend bool operator>=(Fixed _a, Fixed _b) {
+      return _a.bits >= _b.bits;
+    }
+
+   public:  // Maths
+    friend Fixed floor(Fixed _value) {
+      return fromRaw(saturate(floorShift(_value.bits) * ONE));
+    }
+    friend Fixed fmod(Fixed _value, Fixed _divisor) {
+      // The remainder takes the sign of the value, like std::fmod
+      if (_divisor.bits == 0) return Fixed();
+      return fromRaw(int32_t(int64_t(_value.bits) % _divisor.bits));
+    }
+
+   private:  // Helpers
+    enum RawTag { RAW };
+    constexpr Fixed(int32_t _bits, RawTag) : bits(_bits) {}
+
+    static constexpr int32_t saturate(int64_t _value) {
+      // -INT32_MAX rather than INT32_MIN keeps negation from overflowing
+      return (_value > INT32_MAX) ? INT32_MAX : (_value < -INT32_MAX) ? -INT32_MAX : int32_t(_value);
+    }
+    template <typename T>
+    static constexpr int32_t fromInteger(T _value) {
+      // Compare before converting so no integer type can overflow on the way in
+      return (std::is_signed<T>::value && int64_t(_value) < -32767) ? -INT32_MAX
+             : (!std::is_signed<T>::value && uint64_t(_value) > 32767) || (std::is_signed<T>::value && int64_t(_value) > 32767)
+                 ? INT32_MAX
+                 : int32_t(_value) * ONE;
+    }
+    static int64_t floorShift(int64_t _value) {
+      // Divide by ONE rounding down, without shifting a negative number right which C++17 leaves to the compiler
+      return (_value >= 0) ? _value / ONE : -((-_value + ONE - 1) / ONE);
+    }
+    static int32_t fromFloat(float _value) {
+      // Round to the nearest step, only ever used on constants and settings
+      double scaled = double(_value) * ONE;
+      if (!(scaled < double(INT32_MAX))) return (scaled != scaled) ? 0 : INT32_MAX;
+      if (scaled < -double(INT32_MAX)) return -INT32_MAX;
+      return int32_t(std::floor(scaled + 0.5));
+    }
+
+   private:  // Data
+    int32_t bits;  // The value times 2^16
+  };
+
+  // The number type of positions, velocities and times in the simulation. Building with PONG_FIXED_POINT plays the
+  // game in Fixed so replays and lockstep sessions agree across compilers and CPUs, floats are the default.
+#ifdef PONG_FIXED_POINT
+  typedef Fixed Real;
+#else
+  typedef float Real;
+#endif
+
+  // Floor and remainder that take either kind of Real
+  inline float floor(float _value) {
+    return std::floor(_value);
+  }
+  inline float fmod(float _value, float _divisor) {
+    return std::fmod(_value, _divisor);
+  }
+
+  // The largest Real, infinity for floats
+  inline Real realMax() {
+#ifdef PONG_FIXED_POINT
+    return Fixed::max();
+#else
+    return INFINITY;
+#endif
+  }
+
+}  // namespace pong
+
+#endif  // PONG_FIXED_H
@@ -0,0 +1,223 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_FRAME_PIPELINE_H
+#define PONG_FRAME_PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameTimer.h"
+#include "Screen.h"
+#include "Terminal.h"
+#include "TripleBuffer.h"
+
+namespace pong {
+
+  // Everything the render thread needs to show one frame, copied out of the game's Screen so the game can carry on
+  // drawing the next one
+  struct FrameSnapshot {
+    uint64_t          number = 0;             // Counts up from 1 with every frame published
+    int               width = 0, height = 0;  // The size of the frame in cells
+    std::vector<Cell> cells;                  // The frame, row by row
+    uint32_t          titleVersion = 0;       // Changes whenever the title does
+    char              title[200] = {};        // The terminal title to show with the frame
+  };
+
+  // Moves the slow half of showing a frame, turning it into VT sequences and writing them to the terminal, off the
+  // game's thread. The game publishes a snapshot of every frame it draws and goes straight back to simulating, the
+  // render thread shows the newest snapshot whenever the terminal is ready for it. A terminal that can't keep up
+  // drops frames instead of holding back the physics. Without start() every frame is shown on the game's thread as
+  // it's published, the same as before there was a pipeline.
+  class FramePipeline {
+   public:  // Types
+    struct Stats {
+      uint64_t published = 0;     // Frames handed over by the game
+      uint64_t skipped = 0;       // Frames replaced by a newer one before they were shown
+      uint64_t shown = 0;         // Frames sent to the terminal
+      uint64_t writes = 0;        // Output calls the terminal made for them
+      uint64_t bytes = 0;         // Bytes the terminal wrote for them
+      uint64_t maxPublishNs = 0;  // Longest the game's thread spent handing a frame over
+      uint64_t maxShowNs = 0;     // Longest it took to encode and write a frame
+    };
+
+   public:  // Constructor
+    explicit FramePipeline(Terminal &_terminal) : terminal(_terminal) {}
+    ~FramePipeline() {
+      stop();
+    }
+
+   public:  // Control
+    void start() {
+      // Show frames on a render thread from now on
+      stop();
+      running = true;
+      worker = std::thread([this] { run(); });
+    }
+    void stop() {
+      // Finish the render thread and show whatever it hadn't got to, so the terminal can be closed after
+      if (!worker.joinable()) return;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+      }
+      wake.notify_one();
+      worker.join();
+      showNewest();
+    }
+    bool isThreaded() const {
+      return worker.joinable();
+    }
+    uint64_t getShowingNumber() const {
+      // The number of the frame being written, for a Terminal to tell which frame its output belongs to
+      return showingNumber;
+    }
+
+   public:  // Game thread
+    void setTitle(const char *_title) {
+      // Shown along with the next frame published
+      snprintf(title, sizeof(title), "%s", _title);
+      titleVersion++;
+    }
+    void publish(const Screen &_screen) {
+      Clock::time_point startTime = Clock::now();
+
+      // Copy the frame into the writer's buffer, which keeps its storage from one frame to the next
+      FrameSnapshot &frame = frames.back();
+      frame.number = published + 1;
+      frame.width = _screen.getWidth();
+      frame.height = _screen.getHeight();
+      frame.cells.assign(_screen.getCells().begin(), _screen.getCells().end());
+      if (frame.titleVersion != titleVersion) {
+        frame.titleVersion = titleVersion;
+        memcpy(frame.title, title, sizeof(title));
+      }
+      if (frames.publish()) skipped++;
+      published++;
+
+      // Show it here and now when there's no render thread
+      if (isThreaded()) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          pending = true;
+        }
+        wake.notify_one();
+      } else {
+        showNewest();
+      }
+      maxPublishNs = std::max(maxPublishNs, elapsedNs(startTime));
+    }
+    bool takeResize(int *_columns, int *_rows) {
+      // True once after the render thread saw the terminal change size, with the new size
+      uint32_t size = resizedTo.exchange(0, std::memory_order_acquire);
+      if (!size) return false;
+      *_columns = int(size >> 16);
+      *_rows = int(size & 0xffff);
+      return true;
+    }
+    Stats getStats() const {
+      Stats stats;
+      stats.published = published;
+      stats.skipped = skipped;
+      stats.shown = shown.load(std::memory_order_relaxed);
+      stats.writes = writes.load(std::memory_order_relaxed);
+      stats.bytes = bytes.load(std::memory_order_relaxed);
+      stats.maxPublishNs = maxPublishNs;
+      stats.maxShowNs = maxShowNs.load(std::memory_order_relaxed);
+      return stats;
+    }
+
+   private:  // Render thread
+    void run() {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        wake.wait(lock, [this] { return pending || !running; });
+        if (!running) break;
+        pending = false;
+
+        // The game can publish again while this frame is being written
+        lock.unlock();
+        showNewest();
+        lock.lock();
+      }
+    }
+    void showNewest() {
+      if (!frames.update()) return;
+      Clock::time_point    startTime = Clock::now();
+      const FrameSnapshot &frame = frames.front();
+
+      // A resized terminal has lost what was drawn, so send the whole frame again and tell the game its new size
+      if (frame.width != screen.getWidth() || frame.height != screen.getHeight()) screen.resize(frame.width, frame.height);
+      int columns, rows;
+      if (terminal.takeResize(&columns, &rows)) {
+        screen.invalidate();
+        resizedTo.store(uint32_t(columns) << 16 | uint32_t(rows & 0xffff), std::memory_order_release);
+      }
+      if (frame.titleVersion != titleShown) {
+        terminal.setTitle(frame.title);
+        titleShown = frame.titleVersion;
+      }
+
+      // Send every changed cell of the frame to the terminal in a single write
+      screen.assign(frame.cells.data());
+      showingNumber = frame.number;
+      terminal.present(screen.present());
+      shown.store(shown.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      writes.store(terminal.getStats().syscalls, std::memory_order_relaxed);
+      bytes.store(terminal.getStats().bytes, std::memory_order_relaxed);
+      maxShowNs.store(std::max(maxShowNs.load(std::memory_order_relaxed), elapsedNs(startTime)), std::memory_order_relaxed);
+    }
+    static uint64_t elapsedNs(Clock::time_point _since) {
+      return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _since).count());
+    }
+
+   private:  // Data
+    // Shared between the threads
+    TripleBuffer<FrameSnapshot> frames;           // The newest frame on its way to the render thread
+    std::thread                 worker;           // The render thread
+    std::mutex                  mutex;            // Guards the wake up flags
+    std::condition_variable     wake;             // Signalled when a frame is published or it's time to stop
+    bool                        pending = false;  // A frame was published since the render thread last looked
+    bool                        running = false;  // Cleared to stop the render thread
+    std::atomic<uint32_t>       resizedTo{0};     // The terminal's new columns and rows, 0 if unchanged
+    std::atomic<uint64_t>       shown{0};         // Frames sent to the terminal
+    std::atomic<uint64_t>       writes{0};        // Output calls the terminal has made
+    std::atomic<uint64_t>       bytes{0};         // Bytes the terminal has written
+    std::atomic<uint64_t>       maxShowNs{0};     // Longest time to show a frame
+
+    // Only touched by the game's thread
+    char     title[200] = {};   // The title the game last set
+    uint32_t titleVersion = 0;  // Counts changes to the title
+    uint64_t published = 0;     // Frames handed over
+    uint64_t skipped = 0;       // Frames replaced before they were shown
+    uint64_t maxPublishNs = 0;  // Longest hand over
+
+    // Only touched by whichever thread shows frames
+    Terminal &terminal;           // Where frames are written
+    Screen    screen;             // What the terminal is showing, for working out what changed
+    uint32_t  titleShown = 0;     // The version of the title the terminal is showing
+    uint64_t  showingNumber = 0;  // The number of the frame last sent to the terminal
+  };
+
+}  // namespace pong
+
+#endif  // PONG_FRAME_PIPELINE_H
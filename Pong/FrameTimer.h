@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_FRAME_TIMER_H
+#define PONG_FRAME_TIMER_H
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace pong {
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Sleep until shortly before the deadline, then spin for the last stretch the OS sleep can't hit
+  inline void waitUntil(Clock::time_point _deadline, Clock::duration _spinWindow = std::chrono::microseconds(2000)) {
+    Clock::duration remaining = _deadline - Clock::now();
+    if (remaining > _spinWindow) {
+      std::this_thread::sleep_for(remaining - _spinWindow);
+    }
+    while (Clock::now() < _deadline) {
+      std::this_thread::yield();
+    }
+  }
+
+  // Keeps the most recent frame intervals so the pacing jitter can be measured
+  class FrameTimer {
+   public:  // Constants
+    static const int SAMPLES = 512;  // Number of frame intervals kept
+
+   public:  // Recording
+    void mark() {
+      // Record the time since the previous mark
+      Clock::time_point now = Clock::now();
+      if (hasLastMark) {
+        samples[next] = std::chrono::duration<float, std::milli>(now - lastMark).count();
+        next = (next + 1) % SAMPLES;
+        if (count < SAMPLES) count++;
+      }
+      lastMark = now;
+      hasLastMark = true;
+    }
+    void restart() {
+      // Forget the last mark so a pause is not recorded as a long frame
+      hasLastMark = false;
+    }
+
+   public:  // Statistics
+    int getCount() const {
+      return count;
+    }
+    float percentile(float _fraction) const {
+      // Frame time in milliseconds that the given fraction of recent frames were within
+      if (!count) return 0;
+      float sorted[SAMPLES];
+      std::copy(samples, samples + count, sorted);
+      int index = std::min(count - 1, int(_fraction * count));
+      std::nth_element(sorted, sorted + index, sorted + count);
+      return sorted[index];
+    }
+
+   private:  // Data
+    float             samples[SAMPLES] = {};  // Frame intervals in milliseconds
+    int               next = 0;               // Where the next sample will be written
+    int               count = 0;              // Number of valid samples
+    bool              hasLastMark = false;    // If lastMark holds a time to measure from
+    Clock::time_point lastMark;               // Time of the previous mark
+  };
+
+}  // namespace pong
+
+#endif  // PONG_FRAME_TIMER_H
@@ -0,0 +1,396 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_INPUT_H
+#define PONG_INPUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/input.h>
+#endif
+#endif
+
+#include "SpscQueue.h"
+
+namespace pong {
+
+  // The keys the game listens to
+  enum class Key : uint8_t {
+    NONE = 0,
+    W,
+    S,
+    UP,
+    DOWN,
+    SPACE,
+    ESCAPE,
+    P,
+    NUM_1,
+    NUM_2,
+    NUM_3,
+    NUM_4,
+    NUM_5,
+    NUM_6,
+    COUNT
+  };
+  static const size_t KEY_COUNT = size_t(Key::COUNT);
+
+  // A key going down or up, stamped when the reader thread saw it
+  struct InputEvent {
+    typedef std::chrono::steady_clock Clock;
+
+    Key               key;      // Which key changed
+    bool              pressed;  // True when it went down, false when it came up
+    Clock::time_point time;     // When it happened
+  };
+
+  // Reads the keyboard on its own thread and replays the events on the game thread tick by tick
+  class Keyboard {
+   public:  // Types
+    typedef std::chrono::steady_clock Clock;
+
+   public:  // Constants
+    static constexpr int TERMINAL_FIRST_RELEASE_MS = 500;  // Terminals only send presses, a key held past the usual auto repeat delay is still down
+    static constexpr int TERMINAL_RELEASE_MS = 100;        // Once it repeats, a key counts as up this long after its last repeat
+    static constexpr int ESCAPE_TIMEOUT_MS = 50;           // A lone ESC is the Escape key once nothing has followed it for this long
+
+   public:  // Constructor
+    Keyboard() {}
+    ~Keyboard() {
+      stop();
+    }
+
+   public:  // Reader thread control
+    void start() {
+      stop();
+      running = true;
+      reader = std::thread([this] { readKeys(); });
+    }
+    void stop() {
+      running = false;
+      if (reader.joinable()) reader.join();
+    }
+    bool push(const InputEvent &_event) {
+      // Called by the reader thread, or by a single test producer when the reader is not running
+      if (events.push(_event)) return true;
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    uint64_t getDropped() const {
+      return dropped.load(std::memory_order_relaxed);
+    }
+
+   public:  // Game thread
+    void advance(Clock::time_point _until) {
+      // Replay every event up to _until, measuring how long each key was held since the last advance
+      Clock::time_point windowStart = windowEnd < _until ? windowEnd : _until;
+      for (size_t key = 0; key < KEY_COUNT; key++) {
+        held[key] = Clock::duration::zero();
+        heldFrom[key] = windowStart;
+      }
+
+      InputEvent event;
+      while (events.peek(event) && event.time <= _until) {
+        events.pop(event);
+        replayed++;
+        Clock::time_point when = event.time < windowStart ? windowStart : event.time;
+        size_t            key = size_t(event.key);
+        if (down[key]) held[key] += when - heldFrom[key];
+        if (event.pressed && !down[key]) {
+          pressed[key] = true;
+          pressedAt[key] = event.time;
+        }
+        down[key] = event.pressed;
+        heldFrom[key] = when;
+      }
+
+      // Keys still down were held to the end of the window
+      for (size_t key = 0; key < KEY_COUNT; key++) {
+        if (down[key]) held[key] += _until - heldFrom[key];
+      }
+      windowLength = _until - windowStart;
+      windowEnd = _until;
+    }
+    void restart(Clock::time_point _now) {
+      // Start measuring from now, forgetting anything queued before it
+      advance(_now);
+      for (size_t key = 0; key < KEY_COUNT; key++) pressed[key] = false;
+    }
+    float heldFraction(Key _key) const {
+      // How much of the last advance window the key was down for, from 0 to 1
+      if (windowLength <= Clock::duration::zero()) return down[size_t(_key)] ? 1.0f : 0.0f;
+      return std::chrono::duration<float>(held[size_t(_key)]).count() / std::chrono::duration<float>(windowLength).count();
+    }
+    bool isDown(Key _key) const {
+      return down[size_t(_key)];
+    }
+    uint64_t getEventCount() const {
+      // Key events replayed so far
+      return replayed;
+    }
+    Clock::time_point getPressTime(Key _key) const {
+      // When the reader thread saw the key last go down
+      return pressedAt[size_t(_key)];
+    }
+    bool takePress(Key _key) {
+      // True once for every time the key went down
+      bool wasPressed = pressed[size_t(_key)];
+      pressed[size_t(_key)] = false;
+      return wasPressed;
+    }
+
+   private:  // Reader thread
+#ifdef _WIN32
+    static Key translate(WORD _virtualKey) {
+      switch (_virtualKey) {
+      case 0x57: return Key::W;
+      case 0x53: return Key::S;
+      case VK_UP: return Key::UP;
+      case VK_DOWN: return Key::DOWN;
+      case VK_SPACE: return Key::SPACE;
+      case VK_ESCAPE: return Key::ESCAPE;
+      case 0x50: return Key::P;
+      case 0x31: return Key::NUM_1;
+      case 0x32: return Key::NUM_2;
+      case 0x33: return Key::NUM_3;
+      case 0x34: return Key::NUM_4;
+      case 0x35: return Key::NUM_5;
+      case 0x36: return Key::NUM_6;
+      default: return Key::NONE;
+      }
+    }
+    void readKeys() {
+      // Console input records carry real key down and key up events
+      HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+      bool   keyDown[KEY_COUNT] = {};
+      while (running.load(std::memory_order_relaxed)) {
+        if (WaitForSingleObject(input, 50) != WAIT_OBJECT_0) continue;
+
+        INPUT_RECORD records[32];
+        DWORD        count = 0;
+        if (!ReadConsoleInputA(input, records, 32, &count)) continue;
+        Clock::time_point now = Clock::now();
+        for (DWORD i = 0; i < count; i++) {
+          if (records[i].EventType != KEY_EVENT) continue;
+          Key  key = translate(records[i].Event.KeyEvent.wVirtualKeyCode);
+          bool isDown = records[i].Event.KeyEvent.bKeyDown != 0;
+
+          // Skip the console's auto repeat, only changes are interesting
+          if (key == Key::NONE || keyDown[size_t(key)] == isDown) continue;
+          keyDown[size_t(key)] = isDown;
+          push(InputEvent{key, isDown, now});
+        }
+      }
+    }
+#else
+    static Key translate(char _character) {
+      switch (_character) {
+      case 'w': case 'W': return Key::W;
+      case 's': case 'S': return Key::S;
+      case ' ': return Key::SPACE;
+      case 'p': case 'P': return Key::P;
+      case '1': return Key::NUM_1;
+      case '2': return Key::NUM_2;
+      case '3': return Key::NUM_3;
+      case '4': return Key::NUM_4;
+      case '5': return Key::NUM_5;
+      case '6': return Key::NUM_6;
+      default: return Key::NONE;
+      }
+    }
+    void readKeys() {
+#ifdef __linux__
+      // An evdev device gives real key releases, point PONG_EVDEV at it when it's readable
+      const char *device = getenv("PONG_EVDEV");
+      if (device) {
+        int fd = open(device, O_RDONLY | O_NONBLOCK);
+        if (fd >= 0) {
+          readEvdev(fd);
+          close(fd);
+          return;
+        }
+      }
+#endif
+      readTerminal();
+    }
+    // Splits the bytes a terminal sends into keys. Arrows arrive as CSI (ESC [ A) or, in application cursor mode,
+    // SS3 (ESC O A) sequences, and a sequence can be split over two reads, so a partial one is kept until the rest
+    // arrives. Sequences for other keys are dropped, only an ESC nothing follows is the Escape key.
+    class TerminalParser {
+     public:  // Parsing
+      Key feed(char _byte, Clock::time_point _now) {
+        switch (state) {
+        case State::ESCAPE:
+          if (_byte == '[') {
+            state = State::CSI;
+            return Key::NONE;
+          }
+          if (_byte == 'O') {
+            state = State::SS3;
+            return Key::NONE;
+          }
+
+          // Alt with a key, or Escape pressed twice
+          state = State::TEXT;
+          if (_byte == 0x1b) {
+            escapeTime = _now;
+            state = State::ESCAPE;
+            return Key::ESCAPE;
+          }
+          return Key::NONE;
+        case State::CSI:
+          // Parameter and intermediate bytes up to a final byte between @ and ~
+          if (_byte >= 0x20 && _byte <= 0x3f) return Key::NONE;
+          state = State::TEXT;
+          return arrow(_byte);
+        case State::SS3:
+          state = State::TEXT;
+          return arrow(_byte);
+        default:
+          if (_byte == 0x1b) {
+            escapeTime = _now;
+            state = State::ESCAPE;
+            return Key::NONE;
+          }
+          return translate(_byte);
+        }
+      }
+      Key expire(Clock::time_point _now) {
+        // Escape once an ESC has waited long enough on its own, and drop a sequence that never finished
+        if (state == State::TEXT || _now - escapeTime < std::chrono::milliseconds(ESCAPE_TIMEOUT_MS)) return Key::NONE;
+        bool lone = (state == State::ESCAPE);
+        state = State::TEXT;
+        return lone ? Key::ESCAPE : Key::NONE;
+      }
+      Clock::time_point getEscapeTime() const {
+        return escapeTime;
+      }
+
+     private:  // Helpers
+      static Key arrow(char _final) {
+        return (_final == 'A') ? Key::UP : (_final == 'B') ? Key::DOWN : Key::NONE;
+      }
+
+     private:  // Types
+      enum class State { TEXT, ESCAPE, CSI, SS3 };
+
+     private:  // Data
+      State             state = State::TEXT;  // Where in a sequence the last byte left off
+      Clock::time_point escapeTime;           // When the ESC that started it arrived
+    };
+    void readTerminal() {
+      // Only polls and reads stdin, the PosixTerminal puts it in raw mode and is the only thing that restores it,
+      // so open the terminal before starting the reader
+      TerminalParser    parser;
+      Clock::time_point lastSeen[KEY_COUNT];
+      bool              keyDown[KEY_COUNT] = {};
+      bool              repeating[KEY_COUNT] = {};
+      auto              press = [&](Key _key, Clock::time_point _time) {
+        if (_key == Key::NONE) return;
+        if (!keyDown[size_t(_key)]) push(InputEvent{_key, true, _time});
+        repeating[size_t(_key)] = keyDown[size_t(_key)];
+        keyDown[size_t(_key)] = true;
+        lastSeen[size_t(_key)] = _time;
+      };
+      while (running.load(std::memory_order_relaxed)) {
+        struct pollfd     poller = {STDIN_FILENO, POLLIN, 0};
+        int               ready = poll(&poller, 1, 10);
+        Clock::time_point now = Clock::now();
+
+        // Turn the bytes into key presses, Escape is only known once nothing has followed the ESC
+        char    bytes[64];
+        ssize_t count = ready > 0 ? read(STDIN_FILENO, bytes, sizeof(bytes)) : 0;
+        for (ssize_t i = 0; i < count; i++) press(parser.feed(bytes[i], now), now);
+        Key escape = parser.expire(now);
+        if (escape != Key::NONE) press(escape, parser.getEscapeTime());
+
+        // Release keys whose repeats have stopped, or that never started repeating. The first repeat comes a
+        // 250 to 600 ms delay after the press, waiting less would let go of every held key until then
+        for (size_t key = 0; key < KEY_COUNT; key++) {
+          std::chrono::milliseconds timeout(repeating[key] ? TERMINAL_RELEASE_MS : TERMINAL_FIRST_RELEASE_MS);
+          if (keyDown[key] && now - lastSeen[key] > timeout) {
+            keyDown[key] = false;
+            repeating[key] = false;
+            push(InputEvent{Key(key), false, lastSeen[key] + timeout});
+          }
+        }
+      }
+    }
+#ifdef __linux__
+    static Key translateEvdev(int _code) {
+      switch (_code) {
+      case KEY_W: return Key::W;
+      case KEY_S: return Key::S;
+      case KEY_UP: return Key::UP;
+      case KEY_DOWN: return Key::DOWN;
+      case KEY_SPACE: return Key::SPACE;
+      case KEY_ESC: return Key::ESCAPE;
+      case KEY_P: return Key::P;
+      case KEY_1: return Key::NUM_1;
+      case KEY_2: return Key::NUM_2;
+      case KEY_3: return Key::NUM_3;
+      case KEY_4: return Key::NUM_4;
+      case KEY_5: return Key::NUM_5;
+      case KEY_6: return Key::NUM_6;
+      default: return Key::NONE;
+      }
+    }
+    void readEvdev(int _fd) {
+      while (running.load(std::memory_order_relaxed)) {
+        struct pollfd poller = {_fd, POLLIN, 0};
+        if (poll(&poller, 1, 50) <= 0) continue;
+
+        struct input_event records[32];
+        ssize_t            bytes = read(_fd, records, sizeof(records));
+        Clock::time_point  now = Clock::now();
+        for (ssize_t i = 0; i < bytes / ssize_t(sizeof(struct input_event)); i++) {
+          // Value 1 is a press and 0 a release, 2 is auto repeat which is ignored
+          if (records[i].type != EV_KEY || records[i].value == 2) continue;
+          Key key = translateEvdev(records[i].code);
+          if (key != Key::NONE) push(InputEvent{key, records[i].value == 1, now});
+        }
+      }
+    }
+#endif
+#endif
+
+   private:  // Data
+    SpscQueue<InputEvent, 1024> events;                   // Events from the reader thread waiting for the game
+    std::thread                 reader;                   // The reader thread
+    std::atomic<bool>           running{false};           // Cleared to stop the reader thread
+    std::atomic<uint64_t>       dropped{0};               // Events lost because the queue was full
+    bool                        down[KEY_COUNT] = {};     // Key state as of the end of the last advance
+    bool                        pressed[KEY_COUNT] = {};  // Presses not yet taken by the game
+    Clock::duration             held[KEY_COUNT] = {};     // Time each key was down in the last advance
+    Clock::time_point           heldFrom[KEY_COUNT];      // Where the held time for each key is counted from
+    Clock::time_point           pressedAt[KEY_COUNT];     // When each key last went down
+    Clock::time_point           windowEnd;                // The end of the last advance
+    Clock::duration             windowLength = {};        // The length of the last advance
+    uint64_t                    replayed = 0;             // Events replayed by advance so far
+  };
+
+}  // namespace pong
+
+#endif  // PONG_INPUT_H
@@ -0,0 +1,494 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_NETPLAY_H
+#define PONG_NETPLAY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "Random.h"
+#include "Simulation.h"
+
+// Two player Pong over UDP with rollback. Each peer plays its own paddle straight away and guesses the other's input
+// is whatever it last was. When the real input arrives and the guess was wrong, the peer restores the state saved
+// before that frame and plays the frames since again with the real inputs. Packets are:
+//
+//   NET_HELLO   uint8(type) uint8(version) uint64(seed)                             joining, and the host's answer
+//   NET_INPUTS  uint8(type) uint32(first) uint32(ack) uint8(count) int8[count]     inputs from frame first onwards
+//
+// Every number is little endian. Inputs are resent until the other peer acks them, so lost packets cost nothing but
+// a longer guess.
+
+namespace pong {
+
+  // A non-blocking UDP socket talking to one peer
+  class UdpSocket {
+   public:  // Constructor
+    UdpSocket() {}
+    ~UdpSocket() {
+      close();
+    }
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket &operator=(const UdpSocket &) = delete;
+
+   public:  // Connection
+    bool open(uint16_t _port) {
+      // Listen on _port on every interface, 0 picks any free port
+      close();
+      if (!startNetworking()) return false;
+      handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+      if (handle == INVALID_HANDLE) return false;
+
+      sockaddr_in address;
+      memset(&address, 0, sizeof(address));
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_ANY);
+      address.sin_port = htons(_port);
+      if (bind(handle, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) return close(), false;
+#ifdef _WIN32
+      u_long nonBlocking = 1;
+      if (ioctlsocket(handle, FIONBIO, &nonBlocking) != 0) return close(), false;
+#else
+      if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) != 0) return close(), false;
+#endif
+      return true;
+    }
+    bool setPeer(const char *_host, uint16_t _port) {
+      // Send to _host from now on, without a peer the first one to send something becomes it
+      addrinfo hints, *found = NULL;
+      memset(&hints, 0, sizeof(hints));
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_DGRAM;
+      if (getaddrinfo(_host, NULL, &hints, &found) != 0 || !found) return false;
+      memcpy(&peer, found->ai_addr, sizeof(peer));
+      peer.sin_port = htons(_port);
+      freeaddrinfo(found);
+      peerKnown = true;
+      return true;
+    }
+    void close() {
+      if (handle != INVALID_HANDLE) {
+#ifdef _WIN32
+        closesocket(handle);
+#else
+        ::close(handle);
+#endif
+      }
+      handle = INVALID_HANDLE;
+      peerKnown = false;
+    }
+    bool isOpen() const {
+      return handle != INVALID_HANDLE;
+    }
+    bool hasPeer() const {
+      return peerKnown;
+    }
+    uint16_t getPort() const {
+      sockaddr_in address;
+      socklen_t   length = sizeof(address);
+      if (handle == INVALID_HANDLE || getsockname(handle, reinterpret_cast<sockaddr *>(&address), &length) != 0) return 0;
+      return ntohs(address.sin_port);
+    }
+
+   public:  // Packets
+    bool send(const uint8_t *_data, size_t _size) {
+      if (!peerKnown) return false;
+      return sendto(handle, reinterpret_cast<const char *>(_data), int(_size), 0, reinterpret_cast<const sockaddr *>(&peer), sizeof(peer)) == int(_size);
+    }
+    int receive(uint8_t *_data, size_t _capacity) {
+      // Returns the size of the next packet from the peer, or -1 when there is nothing waiting
+      for (;;) {
+        sockaddr_in from;
+        socklen_t   length = sizeof(from);
+        int         size = int(recvfrom(handle, reinterpret_cast<char *>(_data), int(_capacity), 0, reinterpret_cast<sockaddr *>(&from),
+                                        &length));
+        if (size < 0) return -1;
+        if (!peerKnown) {
+          peer = from;
+          peerKnown = true;
+        }
+        if (from.sin_addr.s_addr == peer.sin_addr.s_addr && from.sin_port == peer.sin_port) return size;
+      }
+    }
+
+   private:  // Platform
+#ifdef _WIN32
+    typedef SOCKET NativeSocket;
+    static const NativeSocket INVALID_HANDLE = INVALID_SOCKET;
+    static bool startNetworking() {
+      // Winsock needs starting once per process
+      static WSADATA data;
+      static bool    started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+      return started;
+    }
+#else
+    typedef int NativeSocket;
+    static const NativeSocket INVALID_HANDLE = -1;
+    static bool startNetworking() {
+      return true;
+    }
+#endif
+
+   private:  // Data
+    NativeSocket handle = INVALID_HANDLE;  // The socket
+    sockaddr_in  peer;                     // Where packets go
+    bool         peerKnown = false;        // Whether peer has been set or learnt
+  };
+
+  // Network trouble added on the way out, for trying rollback over loopback
+  struct LinkConditions {
+    uint32_t latencyUs = 0;  // Delay added to every packet
+    uint32_t jitterUs = 0;   // Further delay of up to this much, enough of it reorders packets
+    float    loss = 0;       // Fraction of packets dropped
+  };
+
+  // How rollback has gone so far
+  struct NetplayStats {
+    uint64_t frames = 0;             // Frames played for the first time
+    uint64_t stalls = 0;             // Frames held back waiting for the other peer's inputs
+    uint64_t rollbacks = 0;          // Times a late input proved a guess wrong
+    uint64_t resimulatedFrames = 0;  // Frames played again by rollbacks
+    uint32_t maxRollbackFrames = 0;  // Most frames played again by one rollback
+    uint64_t resimNs = 0;            // Time spent restoring states and playing frames again
+    uint64_t packetsSent = 0;        // Packets handed to the link
+    uint64_t packetsReceived = 0;    // Packets read from the peer
+    uint64_t packetsDropped = 0;     // Packets the link conditions threw away
+  };
+
+  enum class NetplayState {
+    IDLE = 0,         // Neither hosting nor joining
+    CONNECTING = 1,   // Waiting for the other peer
+    RUNNING = 2,      // Playing
+    DISCONNECTED = 3  // Nothing heard from the other peer for too long
+  };
+
+  // One peer of a two player match played over the network with rollback
+  class RollbackSession {
+   public:  // Constants
+    static const uint32_t MAX_ROLLBACK_FRAMES = 8;     // Furthest ahead of the other peer's inputs a peer will guess
+    static const uint32_t STATE_SLOTS = 16;            // Saved states, more than the frames that can be rolled back
+    static const uint32_t INPUT_SLOTS = 256;           // Inputs kept for each side
+    static const uint32_t MAX_PACKET_INPUTS = 128;     // Inputs sent in one packet
+    static const uint64_t HELLO_INTERVAL_US = 100000;  // Time between hellos while connecting
+    static const uint64_t TIMEOUT_US = 5000000;        // Silence after which the other peer is gone
+    static const uint8_t  PROTOCOL_VERSION = 1;
+
+   public:  // Constructor
+    explicit RollbackSession(Simulation &_sim) : sim(_sim), states(STATE_SLOTS) {}
+
+   public:  // Connection
+    bool host(uint16_t _port, uint64_t _seed) {
+      // Play as player 1 and choose the seed, the match starts when someone joins
+      reset();
+      if (!socket.open(_port)) return false;
+      localPlayer = 0;
+      seed = _seed;
+      state = NetplayState::CONNECTING;
+      return true;
+    }
+    bool join(const char *_host, uint16_t _port) {
+      // Play as player 2 with the host's seed
+      reset();
+      if (!socket.open(0) || !socket.setPeer(_host, _port)) return socket.close(), false;
+      localPlayer = 1;
+      state = NetplayState::CONNECTING;
+      return true;
+    }
+    void close() {
+      socket.close();
+      state = NetplayState::IDLE;
+    }
+    void setConditions(const LinkConditions &_conditions, uint64_t _seed = 1) {
+      conditions = _conditions;
+      linkRandom.seed(_seed);
+    }
+
+   public:  // Playing
+    bool poll(uint64_t _nowUs) {
+      // Send and receive without playing a frame, and fix up any wrong guesses. Returns whether the match is on.
+      if (state == NetplayState::IDLE || state == NetplayState::DISCONNECTED) return false;
+      flushLink(_nowUs);
+      receive(_nowUs);
+      if (state == NetplayState::CONNECTING) {
+        if (localPlayer == 1 && _nowUs >= nextHelloUs) {
+          sendHello(_nowUs);
+          nextHelloUs = _nowUs + HELLO_INTERVAL_US;
+        }
+        return false;
+      }
+      if (_nowUs - lastReceiveUs > TIMEOUT_US) {
+        state = NetplayState::DISCONNECTED;
+        return false;
+      }
+      rollback();
+      return true;
+    }
+    bool advance(int8_t _localInput, uint64_t _nowUs, uint32_t *_events = NULL) {
+      // Play the next frame with the local input and a guess at the other's. Returns false without playing when the
+      // other peer is too far behind to guess any further.
+      if (_events) *_events = EVENT_NONE;
+      if (!poll(_nowUs)) return false;
+      if (frame >= remoteConfirmed + MAX_ROLLBACK_FRAMES || frame >= remoteAck + INPUT_SLOTS) {
+        stats.stalls++;
+        sendInputs(_nowUs);
+        return false;
+      }
+      localInputs[frame % INPUT_SLOTS] = _localInput;
+      uint32_t events = playFrame(frame);
+      frame++;
+      stats.frames++;
+      sendInputs(_nowUs);
+      if (_events) *_events = events;
+      return true;
+    }
+
+   public:  // Accessors
+    NetplayState getState() const {
+      return state;
+    }
+    bool isRunning() const {
+      return state == NetplayState::RUNNING;
+    }
+    bool isSynchronized() const {
+      // Every frame played so far used the other peer's real inputs
+      return state == NetplayState::RUNNING && remoteConfirmed >= frame && rollbackFrom == NO_ROLLBACK;
+    }
+    int getLocalPlayer() const {
+      return localPlayer;
+    }
+    uint32_t getFrame() const {
+      return frame;
+    }
+    uint16_t getPort() const {
+      return socket.getPort();
+    }
+    const NetplayStats &getStats() const {
+      return stats;
+    }
+
+   private:  // Frames
+    static const uint32_t NO_ROLLBACK = UINT32_MAX;
+
+    void startMatch() {
+      // Both peers set up the same match from the host's seed
+      sim.seed(seed);
+      sim.resetGame();
+      sim.setMode(GameMode::MULTIPLAYER);
+      sim.autoServe = true;
+      sim.serve();
+      sim.start();
+      state = NetplayState::RUNNING;
+    }
+    uint32_t playFrame(uint32_t _frame) {
+      // Save the state before the frame so it can be played again, then play it with the best inputs known
+      states[_frame % STATE_SLOTS] = sim;
+      int8_t remote = (_frame < remoteConfirmed) ? remoteInputs[_frame % INPUT_SLOTS] : guessRemote();
+      guesses[_frame % INPUT_SLOTS] = remote;
+
+      Inputs inputs;
+      inputs.player1 = (localPlayer == 0) ? localInputs[_frame % INPUT_SLOTS] : remote;
+      inputs.player2 = (localPlayer == 0) ? remote : localInputs[_frame % INPUT_SLOTS];
+      return sim.tick(inputs);
+    }
+    int8_t guessRemote() const {
+      // People hold keys, so the last real input is the best guess
+      return remoteConfirmed ? remoteInputs[(remoteConfirmed - 1) % INPUT_SLOTS] : 0;
+    }
+    void rollback() {
+      // Go back to the first frame that was guessed wrong and play up to now again
+      if (rollbackFrom >= frame) {
+        rollbackFrom = NO_ROLLBACK;
+        return;
+      }
+      auto     startTime = std::chrono::steady_clock::now();
+      uint32_t frames = frame - rollbackFrom;
+      sim = states[rollbackFrom % STATE_SLOTS];
+      for (uint32_t f = rollbackFrom; f < frame; f++) playFrame(f);
+      rollbackFrom = NO_ROLLBACK;
+
+      stats.rollbacks++;
+      stats.resimulatedFrames += frames;
+      if (frames > stats.maxRollbackFrames) stats.maxRollbackFrames = frames;
+      stats.resimNs += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+    }
+
+   private:  // Packets
+    enum PacketType : uint8_t {
+      NET_HELLO = 1,
+      NET_INPUTS = 2
+    };
+
+    void receive(uint64_t _nowUs) {
+      uint8_t packet[512];
+      int     size;
+      while ((size = socket.receive(packet, sizeof(packet))) > 0) {
+        stats.packetsReceived++;
+        lastReceiveUs = _nowUs;
+        if (packet[0] == NET_HELLO && size == 10 && packet[1] == PROTOCOL_VERSION) {
+          receiveHello(packet, _nowUs);
+        } else if (packet[0] == NET_INPUTS && size >= 10 && state == NetplayState::RUNNING) {
+          receiveInputs(packet, size_t(size));
+        }
+      }
+    }
+    void receiveHello(const uint8_t *_packet, uint64_t _nowUs) {
+      // The host answers every hello in case its answer was lost, the joiner starts on the first answer
+      if (localPlayer == 0) {
+        if (state == NetplayState::CONNECTING) startMatch();
+        sendHello(_nowUs);
+      } else if (state == NetplayState::CONNECTING) {
+        seed = getU64(_packet + 2);
+        startMatch();
+      }
+    }
+    void receiveInputs(const uint8_t *_packet, size_t _size) {
+      uint32_t first = getU32(_packet + 1);
+      uint32_t ack = getU32(_packet + 5);
+      uint32_t count = _packet[9];
+      if (_size < 10 + count || first > remoteConfirmed) return;
+      if (ack > remoteAck && ack <= frame) remoteAck = ack;
+
+      // Take the inputs past the ones already known, noting the first that differs from what was guessed
+      for (uint32_t f = remoteConfirmed; f < first + count; f++) {
+        int8_t input = int8_t(_packet[10 + (f - first)]);
+        remoteInputs[f % INPUT_SLOTS] = input;
+        if (f < frame && input != guesses[f % INPUT_SLOTS] && f < rollbackFrom) rollbackFrom = f;
+        remoteConfirmed = f + 1;
+      }
+    }
+    void sendHello(uint64_t _nowUs) {
+      uint8_t packet[10];
+      packet[0] = NET_HELLO;
+      packet[1] = PROTOCOL_VERSION;
+      putU64(packet + 2, seed);
+      sendPacket(packet, sizeof(packet), _nowUs);
+    }
+    void sendInputs(uint64_t _nowUs) {
+      // Everything the other peer hasn't acked yet, oldest first
+      uint32_t count = frame - remoteAck;
+      if (count > MAX_PACKET_INPUTS) count = MAX_PACKET_INPUTS;
+      uint8_t packet[10 + MAX_PACKET_INPUTS];
+      packet[0] = NET_INPUTS;
+      putU32(packet + 1, remoteAck);
+      putU32(packet + 5, remoteConfirmed);
+      packet[9] = uint8_t(count);
+      for (uint32_t i = 0; i < count; i++) packet[10 + i] = uint8_t(localInputs[(remoteAck + i) % INPUT_SLOTS]);
+      sendPacket(packet, 10 + count, _nowUs);
+    }
+
+   private:  // Link
+    struct DelayedPacket {
+      uint64_t             sendUs;  // When the packet goes out
+      std::vector<uint8_t> bytes;   // The packet
+    };
+
+    void sendPacket(const uint8_t *_data, size_t _size, uint64_t _nowUs) {
+      // Drop or hold back the packet as the link conditions say, otherwise send it now
+      stats.packetsSent++;
+      if (conditions.loss > 0 && linkRandom.nextFloat() < conditions.loss) {
+        stats.packetsDropped++;
+        return;
+      }
+      if (conditions.latencyUs == 0 && conditions.jitterUs == 0) {
+        socket.send(_data, _size);
+        return;
+      }
+      uint64_t      jitter = conditions.jitterUs ? linkRandom.next() % (uint64_t(conditions.jitterUs) + 1) : 0;
+      DelayedPacket delayed;
+      delayed.sendUs = _nowUs + conditions.latencyUs + jitter;
+      delayed.bytes.assign(_data, _data + _size);
+      delayedPackets.push_back(std::move(delayed));
+    }
+    void flushLink(uint64_t _nowUs) {
+      for (size_t i = 0; i < delayedPackets.size();) {
+        if (delayedPackets[i].sendUs <= _nowUs) {
+          socket.send(delayedPackets[i].bytes.data(), delayedPackets[i].bytes.size());
+          delayedPackets[i] = std::move(delayedPackets.back());
+          delayedPackets.pop_back();
+        } else {
+          i++;
+        }
+      }
+    }
+
+   private:  // Helpers
+    void reset() {
+      close();
+      frame = remoteConfirmed = remoteAck = 0;
+      rollbackFrom = NO_ROLLBACK;
+      lastReceiveUs = nextHelloUs = 0;
+      stats = NetplayStats();
+      delayedPackets.clear();
+    }
+    static void putU32(uint8_t *_out, uint32_t _value) {
+      for (int i = 0; i < 4; i++) _out[i] = uint8_t(_value >> (8 * i));
+    }
+    static void putU64(uint8_t *_out, uint64_t _value) {
+      for (int i = 0; i < 8; i++) _out[i] = uint8_t(_value >> (8 * i));
+    }
+    static uint32_t getU32(const uint8_t *_in) {
+      uint32_t value = 0;
+      for (int i = 0; i < 4; i++) value |= uint32_t(_in[i]) << (8 * i);
+      return value;
+    }
+    static uint64_t getU64(const uint8_t *_in) {
+      uint64_t value = 0;
+      for (int i = 0; i < 8; i++) value |= uint64_t(_in[i]) << (8 * i);
+      return value;
+    }
+
+   private:  // Data
+    Simulation &               sim;                             // The match, always at the start of the next frame
+    std::vector<Simulation>    states;                          // The state before each of the last frames
+    UdpSocket                  socket;                          // The other peer
+    NetplayState               state = NetplayState::IDLE;      // Where the session is up to
+    int                        localPlayer = 0;                 // 0 when playing player 1, 1 when playing player 2
+    uint64_t                   seed = 1;                        // Seed of the match, chosen by the host
+    uint32_t                   frame = 0;                       // The next frame to play
+    uint32_t                   remoteConfirmed = 0;             // The other peer's inputs are known for frames before this
+    uint32_t                   remoteAck = 0;                   // The other peer has every local input before this
+    uint32_t                   rollbackFrom = NO_ROLLBACK;      // First frame played with a wrong guess
+    int8_t                     localInputs[INPUT_SLOTS] = {};   // This peer's inputs
+    int8_t                     remoteInputs[INPUT_SLOTS] = {};  // The other peer's inputs, as they arrive
+    int8_t                     guesses[INPUT_SLOTS] = {};       // The other peer's input each frame was played with
+    uint64_t                   lastReceiveUs = 0;               // When the other peer was last heard from
+    uint64_t                   nextHelloUs = 0;                 // When to say hello again while joining
+    LinkConditions             conditions;                      // Trouble added to outgoing packets
+    Random                     linkRandom;                      // Decides which packets are lost and how late
+    std::vector<DelayedPacket> delayedPackets;                  // Packets held back by the link conditions
+    NetplayStats               stats;                           // How rollback has gone
+  };
+
+}  // namespace pong
+
+#endif  // PONG_NETPLAY_H
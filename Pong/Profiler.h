@@ -0,0 +1,309 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_PROFILER_H
+#define PONG_PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Scoped timers are only compiled in with -DPONG_PROFILER, otherwise they're nothing at all
+#ifdef PONG_PROFILER
+#define PONG_PROFILE_JOIN2(a, b) a##b
+#define PONG_PROFILE_JOIN(a, b) PONG_PROFILE_JOIN2(a, b)
+#define PONG_PROFILE(phase) pong::ProfileScope PONG_PROFILE_JOIN(profileScope, __LINE__)(phase)
+#define PONG_PROFILE_FRAME() pong::Profiler::frame()
+#else
+#define PONG_PROFILE(phase)
+#define PONG_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace pong {
+
+  // The parts of a frame that are timed
+  enum ProfilePhase {
+    PHASE_INPUT,            // Replaying the key events for a tick
+    PHASE_CPU,              // The CPU players predicting where to go
+    PHASE_BALL,             // Moving the ball, or every multi-ball ball, and bouncing it
+    PHASE_SCORE,            // Checking for points and the end of the game
+    PHASE_DRAW_BORDER,      // Drawing the borders
+    PHASE_DRAW_SCORE,       // Drawing the score line
+    PHASE_DRAW_PLAY_FIELD,  // Drawing the paddles and balls
+    PHASE_DRAW_SCREEN,      // Drawing a whole screen such as the title, pause or winner screen
+    PHASE_PRESENT,          // Turning the frame into output and writing it to the terminal
+    PHASE_SLEEP,            // Waiting for the next frame or for a song to finish
+    PHASE_COUNT
+  };
+
+  inline const char *profilePhaseName(int _phase) {
+    static const char *const NAMES[PHASE_COUNT] = {"input",         "cpu",        "ball",    "score", "drawBorder", "drawScore",
+                                                   "drawPlayField", "drawScreen", "present", "sleep"};
+    return (_phase >= 0 && _phase < PHASE_COUNT) ? NAMES[_phase] : "unknown";
+  }
+
+  // Counts nanosecond durations in log linear buckets, exact below 64 ns and within 1/32 of the value above that,
+  // so percentiles stay accurate from a few nanoseconds up to hours without keeping every sample
+  class HdrHistogram {
+   public:  // Constants
+    static const int SUB_BITS = 5;                                     // Buckets per power of two are 2^SUB_BITS
+    static const int SUB_COUNT = 1 << SUB_BITS;                        // Buckets in each power of two
+    static const int MAX_SHIFT = 64 - SUB_BITS - 1;                    // Power of two of the largest values
+    static const int BUCKETS = 2 * SUB_COUNT + MAX_SHIFT * SUB_COUNT;  // Every bucket from 0 to 2^64
+
+   public:  // Recording
+    void record(uint64_t _ns) {
+      counts[bucketOf(_ns)]++;
+      count++;
+      total += _ns;
+      if (_ns > maximum) maximum = _ns;
+    }
+    void reset() {
+      *this = HdrHistogram();
+    }
+
+   public:  // Statistics
+    uint64_t getCount() const {
+      return count;
+    }
+    uint64_t getMax() const {
+      return maximum;
+    }
+    double getMean() const {
+      return count ? double(total) / double(count) : 0.0;
+    }
+    uint64_t percentile(double _fraction) const {
+      // The highest value that could be in the bucket holding the given fraction of the samples
+      if (!count) return 0;
+      uint64_t rank = uint64_t(_fraction * double(count));
+      if (rank >= count) rank = count - 1;
+      uint64_t seen = 0;
+      for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += counts[bucket];
+        if (seen > rank) return std::min(highestIn(bucket), maximum);
+      }
+      return maximum;
+    }
+
+   public:  // Buckets
+    static int bucketOf(uint64_t _ns) {
+      if (_ns < uint64_t(2 * SUB_COUNT)) return int(_ns);
+      int shift = highestBit(_ns) - SUB_BITS;
+      return 2 * SUB_COUNT + (shift - 1) * SUB_COUNT + int((_ns >> shift) - SUB_COUNT);
+    }
+    static uint64_t highestIn(int _bucket) {
+      if (_bucket < 2 * SUB_COUNT) return uint64_t(_bucket);
+      int      shift = (_bucket - 2 * SUB_COUNT) / SUB_COUNT + 1;
+      uint64_t sub = uint64_t((_bucket - 2 * SUB_COUNT) % SUB_COUNT + SUB_COUNT);
+      return ((sub + 1) << shift) - 1;
+    }
+
+   private:  // Helpers
+    static int highestBit(uint64_t _value) {
+#if defined(__GNUC__) || defined(__clang__)
+      return 63 - __builtin_clzll(_value);
+#else
+      int bit = 0;
+      while (_value >>= 1) bit++;
+      return bit;
+#endif
+    }
+
+   private:  // Data
+    uint64_t counts[BUCKETS] = {};  // Samples in each bucket
+    uint64_t count = 0;             // Samples recorded
+    uint64_t total = 0;             // Sum of the samples in nanoseconds
+    uint64_t maximum = 0;           // Largest sample in nanoseconds
+  };
+
+  // One timed scope
+  struct ProfileEvent {
+    uint64_t startNs;     // Start since the profiler was made
+    uint32_t durationNs;  // How long the scope took, capped at about 4 seconds
+    uint16_t phase;       // What was timed
+    uint16_t depth;       // Scopes it was inside
+  };
+
+  // The time each phase took in one frame, inclusive of any phases nested inside it
+  struct ProfileFrame {
+    uint64_t number = 0;                 // Frames since the profiler was made
+    uint64_t startNs = 0;                // Start since the profiler was made
+    uint64_t durationNs = 0;             // Time until the next frame started
+    uint64_t phaseNs[PHASE_COUNT] = {};  // Time spent in each phase
+  };
+
+  // Times the phases of the game loop into a histogram per phase, a ring of recent frames and a ring of recent scopes
+  // for a trace. A thread records into the profiler it has installed and scopes on other threads cost a null check.
+  class Profiler {
+   public:  // Constants
+    static const int EVENTS = 1 << 15;  // Recent scopes kept for the trace
+    static const int FRAMES = 512;      // Recent frames kept
+
+   public:  // Constructor
+    Profiler() : epoch(std::chrono::steady_clock::now()) {}
+    ~Profiler() {
+      if (current() == this) current() = nullptr;
+    }
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+   public:  // Installing
+    void install() {
+      // Record this thread's scopes here from now on
+      current() = this;
+    }
+    static Profiler *&current() {
+      static thread_local Profiler *profiler = nullptr;
+      return profiler;
+    }
+
+   public:  // Recording
+    uint64_t now() const {
+      return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+    }
+    void begin() {
+      depth++;
+    }
+    void end(int _phase, uint64_t _startNs, uint64_t _endNs) {
+      depth--;
+      uint64_t duration = _endNs - _startNs;
+      histograms[_phase].record(duration);
+      frames[frameCount % FRAMES].phaseNs[_phase] += duration;
+
+      ProfileEvent &event = events[eventCount % EVENTS];
+      event.startNs = _startNs;
+      event.durationNs = duration > UINT32_MAX ? UINT32_MAX : uint32_t(duration);
+      event.phase = uint16_t(_phase);
+      event.depth = uint16_t(depth);
+      eventCount++;
+    }
+    void markFrame() {
+      // Close the current frame and start the next one
+      uint64_t      time = now();
+      ProfileFrame &closing = frames[frameCount % FRAMES];
+      closing.durationNs = time - closing.startNs;
+      frameCount++;
+      ProfileFrame &opening = frames[frameCount % FRAMES];
+      opening = ProfileFrame();
+      opening.number = frameCount;
+      opening.startNs = time;
+    }
+    static void frame() {
+      if (Profiler *profiler = current()) profiler->markFrame();
+    }
+    void reset() {
+      for (HdrHistogram &histogram : histograms) histogram.reset();
+      eventCount = 0;
+      frameCount = 0;
+      frames[0] = ProfileFrame();
+      frames[0].startNs = now();
+    }
+
+   public:  // Results
+    const HdrHistogram &getHistogram(int _phase) const {
+      return histograms[_phase];
+    }
+    uint64_t getFrameCount() const {
+      return frameCount;
+    }
+    uint64_t getEventCount() const {
+      return eventCount;
+    }
+
+   public:  // Export
+    bool writeTrace(const char *_path) const {
+      // Chrome trace event JSON of the scopes still in the ring, open it in chrome://tracing or Perfetto
+      FILE *file = fopen(_path, "w");
+      if (!file) return false;
+      fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+      fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"game loop\"}}");
+      uint64_t first = eventCount > EVENTS ? eventCount - EVENTS : 0;
+      for (uint64_t i = first; i < eventCount; i++) {
+        const ProfileEvent &event = events[i % EVENTS];
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"pong\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                profilePhaseName(event.phase), double(event.startNs) / 1000.0, double(event.durationNs) / 1000.0);
+      }
+
+      // Frame starts as instant events so frames line up in the viewer
+      uint64_t firstFrame = frameCount >= FRAMES ? frameCount - FRAMES + 1 : 0;
+      uint64_t oldest = eventCount > first ? events[first % EVENTS].startNs : 0;
+      for (uint64_t i = firstFrame; i < frameCount; i++) {
+        const ProfileFrame &frame = frames[i % FRAMES];
+        if (frame.startNs < oldest) continue;
+        fprintf(file, ",\n{\"name\":\"frame %llu\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":%.3f}",
+                (unsigned long long)frame.number, double(frame.startNs) / 1000.0);
+      }
+      fprintf(file, "\n]}\n");
+      return fclose(file) == 0;
+    }
+    bool writeCsv(const char *_path) const {
+      // Each phase's percentiles over the whole run, then each recent frame's time per phase, all in microseconds
+      FILE *file = fopen(_path, "w");
+      if (!file) return false;
+      fprintf(file, "phase,count,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n");
+      for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        const HdrHistogram &histogram = histograms[phase];
+        fprintf(file, "%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", profilePhaseName(phase), (unsigned long long)histogram.getCount(),
+                histogram.getMean() / 1000.0, histogram.percentile(0.50) / 1000.0, histogram.percentile(0.90) / 1000.0,
+                histogram.percentile(0.99) / 1000.0, histogram.percentile(0.999) / 1000.0, histogram.getMax() / 1000.0);
+      }
+
+      fprintf(file, "\nframe,start_us,duration_us");
+      for (int phase = 0; phase < PHASE_COUNT; phase++) fprintf(file, ",%s_us", profilePhaseName(phase));
+      fprintf(file, "\n");
+      uint64_t firstFrame = frameCount >= FRAMES ? frameCount - FRAMES + 1 : 0;
+      for (uint64_t i = firstFrame; i < frameCount; i++) {
+        const ProfileFrame &frame = frames[i % FRAMES];
+        fprintf(file, "%llu,%.3f,%.3f", (unsigned long long)frame.number, double(frame.startNs) / 1000.0, double(frame.durationNs) / 1000.0);
+        for (int phase = 0; phase < PHASE_COUNT; phase++) fprintf(file, ",%.3f", double(frame.phaseNs[phase]) / 1000.0);
+        fprintf(file, "\n");
+      }
+      return fclose(file) == 0;
+    }
+
+   private:  // Data
+    std::chrono::steady_clock::time_point epoch;                    // Time zero for every timestamp
+    HdrHistogram                          histograms[PHASE_COUNT];  // Every duration of each phase
+    ProfileEvent                          events[EVENTS];           // Ring of recent scopes
+    ProfileFrame                          frames[FRAMES];           // Ring of recent frames, the newest still open
+    uint64_t                              eventCount = 0;           // Scopes recorded
+    uint64_t                              frameCount = 0;           // Frames finished
+    int                                   depth = 0;                // Scopes open right now
+  };
+
+  // Times the rest of the enclosing block as one phase
+  class ProfileScope {
+   public:  // Constructor
+    explicit ProfileScope(int _phase) : profiler(Profiler::current()), phase(_phase) {
+      if (profiler) {
+        profiler->begin();
+        startNs = profiler->now();
+      }
+    }
+    ~ProfileScope() {
+      if (profiler) profiler->end(phase, startNs, profiler->now());
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+   private:  // Data
+    Profiler *profiler;     // Where the time goes, null when this thread isn't profiled
+    int       phase;        // What's being timed
+    uint64_t  startNs = 0;  // When the scope opened
+  };
+
+}  // namespace pong
+
+#endif  // PONG_PROFILER_H
@@ -0,0 +1,102 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_RANDOM_H
+#define PONG_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Fixed.h"
+
+namespace pong {
+
+  // xoshiro256** with its state inside the object, so every game or environment owns its own numbers and needs no
+  // locks. Seeding runs the seed through splitmix64 as the xoshiro authors recommend.
+  class Random {
+   public:  // Constructor
+    explicit Random(uint64_t _seed = 1) {
+      seed(_seed);
+    }
+
+   public:  // Seeding
+    void seed(uint64_t _seed) {
+      for (int i = 0; i < 4; i++) {
+        _seed += 0x9e3779b97f4a7c15ull;
+        uint64_t z = _seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        state[i] = z ^ (z >> 31);
+      }
+    }
+    void jump() {
+      // Move 2^128 numbers ahead, streams that start a jump apart never overlap
+      static const uint64_t JUMP[] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+      uint64_t              jumped[4] = {0, 0, 0, 0};
+      for (uint64_t word : JUMP) {
+        for (int bit = 0; bit < 64; bit++) {
+          if (word & (uint64_t(1) << bit)) {
+            for (int i = 0; i < 4; i++) jumped[i] ^= state[i];
+          }
+          next();
+        }
+      }
+      for (int i = 0; i < 4; i++) state[i] = jumped[i];
+    }
+
+   public:  // Numbers
+    uint64_t next() {
+      uint64_t result = rotate(state[1] * 5, 7) * 9;
+      uint64_t t = state[1] << 17;
+      state[2] ^= state[0];
+      state[3] ^= state[1];
+      state[1] ^= state[2];
+      state[0] ^= state[3];
+      state[2] ^= t;
+      state[3] = rotate(state[3], 45);
+      return result;
+    }
+    float nextFloat() {
+      // The top 24 bits fill a float's mantissa exactly, giving every multiple of 2^-24 in [0, 1) with no branches
+      return float(next() >> 40) * (1.0f / 16777216.0f);
+    }
+    float nextFloat(float _low, float _high) {
+      return _low + nextFloat() * (_high - _low);
+    }
+    Real nextReal(Real _low, Real _high) {
+      // A number of whichever type the simulation runs in, in fixed point the fraction comes straight from the bits
+#ifdef PONG_FIXED_POINT
+      return _low + (_high - _low) * Fixed::fromRaw(int32_t(next() >> (64 - Fixed::FRACTION_BITS)));
+#else
+      return nextFloat(_low, _high);
+#endif
+    }
+    void fill(float *_out, size_t _count, float _low, float _high) {
+      // Many numbers at once, for serving a swarm of balls or starting a batch of environments
+      float range = _high - _low;
+      for (size_t i = 0; i < _count; i++) _out[i] = _low + float(next() >> 40) * (1.0f / 16777216.0f) * range;
+    }
+
+   private:  // Helpers
+    static uint64_t rotate(uint64_t _value, int _bits) {
+      return (_value << _bits) | (_value >> (64 - _bits));
+    }
+
+   private:  // Data
+    uint64_t state[4];  // The generator's 256 bits of state
+  };
+
+}  // namespace pong
+
+#endif  // PONG_RANDOM_H
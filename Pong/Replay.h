@@ -0,0 +1,530 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_REPLAY_H
+#define PONG_REPLAY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Simulation.h"
+
+// A replay file, every fixed size number is in the byte order of the machine that wrote it, which the header records:
+//
+//   ReplayHeader
+//   records     REPLAY_RUN varint(ticks) int8(player1) int8(player2)   ticks played with the same inputs
+//               REPLAY_SERVE                                           Simulation::serve()
+//               REPLAY_START                                           Simulation::start()
+//               REPLAY_KEYFRAME varint(tick) varint(size) state        the whole state before that tick
+//               REPLAY_END
+//   ReplayKeyframe[keyframes]                                          where each keyframe record starts
+//   ReplayFooter
+//
+// The first keyframe is the state the recording began from, so a replay never depends on anything outside the file.
+
+namespace pong {
+
+  static const uint32_t REPLAY_VERSION = 2;              // Format version, 2 widened the seed and added the byte order
+  static const uint32_t REPLAY_BYTE_ORDER = 0x01020304;  // Reads back as 0x04030201 on a machine of the other byte order
+
+  // Which kind of build wrote a replay, see ReplayHeader::fixedPoint
+#ifdef PONG_FIXED_POINT
+  static const uint32_t REPLAY_FIXED_POINT = 1;
+#else
+  static const uint32_t REPLAY_FIXED_POINT = 0;
+#endif
+
+  enum ReplayRecord : uint8_t {
+    REPLAY_RUN = 1,
+    REPLAY_SERVE = 2,
+    REPLAY_START = 3,
+    REPLAY_KEYFRAME = 4,
+    REPLAY_END = 5
+  };
+
+  struct ReplayHeader {
+    char     magic[8];          // "PONGRPL1"
+    uint32_t version;           // Format version, REPLAY_VERSION
+    uint32_t byteOrder;         // REPLAY_BYTE_ORDER as the writer stored it, the file only reads on a machine of the same order
+    uint64_t seed;              // The seed the match was started with
+    uint32_t keyframeInterval;  // Ticks between keyframes
+    uint32_t fixedPoint;        // 1 when recorded with PONG_FIXED_POINT, the state only loads into the same kind of build
+  };
+
+  struct ReplayKeyframe {
+    uint64_t tick;    // Ticks played before the keyframe
+    uint64_t offset;  // Where its record starts in the file
+  };
+
+  struct ReplayFooter {
+    uint64_t indexOffset;    // Where the keyframe index starts
+    uint64_t keyframes;      // Entries in the index
+    uint64_t ticks;          // Ticks played in the whole replay
+    int32_t  player1Score;   // Final score of player 1
+    int32_t  opponentScore;  // Final score of player 2 or the CPU
+    uint64_t stateHash;      // hashState() of the final state
+    char     magic[8];       // "PONGEND1"
+  };
+
+  // Saves a state field by field into bytes
+  class StateWriter {
+   public:  // Constants
+    static const bool READING = false;
+
+   public:  // Constructor
+    explicit StateWriter(std::vector<uint8_t> &_bytes) : bytes(_bytes) {}
+
+   public:  // Archive
+    template <typename T>
+    void value(const T &_value) {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be saved");
+      const uint8_t *raw = reinterpret_cast<const uint8_t *>(&_value);
+      bytes.insert(bytes.end(), raw, raw + sizeof(T));
+    }
+    bool has(uint64_t) const {
+      return true;
+    }
+
+   private:  // Data
+    std::vector<uint8_t> &bytes;  // Where the state goes
+  };
+
+  // Restores a state saved by StateWriter, failing rather than reading past the end
+  class StateReader {
+   public:  // Constants
+    static const bool READING = true;
+
+   public:  // Constructor
+    StateReader(const uint8_t *_bytes, size_t _size) : cursor(_bytes), end(_bytes + _size) {}
+
+   public:  // Archive
+    template <typename T>
+    void value(T &_value) {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be restored");
+      if (!has(sizeof(T))) {
+        failed = true;
+        return;
+      }
+      memcpy(&_value, cursor, sizeof(T));
+      cursor += sizeof(T);
+    }
+    void value(bool &_value) {
+      // Any byte other than zero is true, so a damaged file can't make an invalid bool
+      uint8_t byte = 0;
+      value(byte);
+      _value = byte != 0;
+    }
+    bool has(uint64_t _bytes) const {
+      return _bytes <= uint64_t(end - cursor);
+    }
+    bool ok() const {
+      return !failed && cursor == end;
+    }
+
+   private:  // Data
+    const uint8_t *cursor;          // The next byte to read
+    const uint8_t *end;             // One past the last byte
+    bool           failed = false;  // Set when a read ran out of bytes
+  };
+
+  inline void saveState(const Simulation &_sim, std::vector<uint8_t> &_bytes) {
+    // serialize() hands fields to the archive by reference, saving only reads them
+    StateWriter writer(_bytes);
+    const_cast<Simulation &>(_sim).serialize(writer);
+  }
+  inline bool loadState(Simulation &_sim, const uint8_t *_bytes, size_t _size) {
+    StateReader reader(_bytes, _size);
+    _sim.serialize(reader);
+    return reader.ok();
+  }
+  inline uint64_t hashState(const Simulation &_sim) {
+    // FNV-1a over the saved state, equal hashes mean the games are bit for bit the same
+    std::vector<uint8_t> bytes;
+    saveState(_sim, bytes);
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t byte : bytes) hash = (hash ^ byte) * 1099511628211ull;
+    return hash;
+  }
+
+  // Records a match as it's played. Call tick() with the inputs just before each Simulation::tick() and serve() or
+  // start() just after the simulation's own, the writer only looks at the simulation to take keyframes.
+  class ReplayWriter {
+   public:  // Constants
+    static const uint32_t DEFAULT_KEYFRAME_INTERVAL = 1024;  // About 4 seconds of play at 240 ticks per second
+    static const size_t   FLUSH_SIZE = 64 * 1024;            // Bytes buffered before they're written out
+
+   public:  // Constructor
+    ReplayWriter() {}
+    ~ReplayWriter() {
+      finish();
+    }
+    ReplayWriter(const ReplayWriter &) = delete;
+    ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+   public:  // Recording
+    bool begin(const char *_path, const Simulation &_sim, uint64_t _seed, uint32_t _keyframeInterval = DEFAULT_KEYFRAME_INTERVAL) {
+      finish();
+      file = fopen(_path, "wb");
+      if (!file) return false;
+      sim = &_sim;
+      keyframeInterval = _keyframeInterval ? _keyframeInterval : DEFAULT_KEYFRAME_INTERVAL;
+      ticksToKeyframe = keyframeInterval;
+      ticks = 0;
+      written = 0;
+      runInputs = Inputs();
+      runTicks = 0;
+      buffer.clear();
+      index.clear();
+
+      ReplayHeader header = {{'P', 'O', 'N', 'G', 'R', 'P', 'L', '1'}, REPLAY_VERSION, REPLAY_BYTE_ORDER, _seed, keyframeInterval, REPLAY_FIXED_POINT};
+      put(&header, sizeof(header));
+      keyframe();
+      return true;
+    }
+    void tick(const Inputs &_inputs) {
+      // Most ticks repeat the last inputs and only lengthen the current run
+      if (_inputs.player1 == runInputs.player1 && _inputs.player2 == runInputs.player2 && ticksToKeyframe > 0) {
+        runTicks++;
+        ticksToKeyframe--;
+        return;
+      }
+      if (!file) return;
+      flushRun();
+      if (ticksToKeyframe == 0) {
+        keyframe();
+        ticksToKeyframe = keyframeInterval;
+      }
+      runInputs = _inputs;
+      runTicks = 1;
+      ticksToKeyframe--;
+    }
+    void serve() {
+      if (!file) return;
+      flushRun();
+      buffer.push_back(REPLAY_SERVE);
+    }
+    void start() {
+      if (!file) return;
+      flushRun();
+      buffer.push_back(REPLAY_START);
+    }
+    bool finish() {
+      // Close the stream with the keyframe index and the final result
+      if (!file) return false;
+      flushRun();
+      buffer.push_back(REPLAY_END);
+
+      ReplayFooter footer;
+      footer.keyframes = index.size();
+      footer.ticks = ticks;
+      footer.player1Score = sim->player1.getScore();
+      footer.opponentScore = sim->getOpponent()->getScore();
+      footer.stateHash = hashState(*sim);
+      memcpy(footer.magic, "PONGEND1", 8);
+
+      // Align the index so it can be read in place once the file is mapped
+      while (offset() % alignof(ReplayKeyframe)) buffer.push_back(0);
+      footer.indexOffset = offset();
+      if (!index.empty()) put(index.data(), index.size() * sizeof(ReplayKeyframe));
+      put(&footer, sizeof(footer));
+
+      bool ok = flush();
+      ok = (fclose(file) == 0) && ok;
+      file = NULL;
+      ticksToKeyframe = 0;
+      return ok;
+    }
+
+   public:  // Accessors
+    bool isRecording() const {
+      return file != NULL;
+    }
+    uint64_t getTicks() const {
+      return ticks + runTicks;
+    }
+    uint64_t getBytes() const {
+      return offset();
+    }
+
+   private:  // Encoding
+    uint64_t offset() const {
+      return written + buffer.size();
+    }
+    void put(const void *_bytes, size_t _size) {
+      const uint8_t *raw = static_cast<const uint8_t *>(_bytes);
+      buffer.insert(buffer.end(), raw, raw + _size);
+    }
+    void putVarint(uint64_t _value) {
+      // Seven bits a byte, low bits first, the top bit says another byte follows
+      while (_value >= 0x80) {
+        buffer.push_back(uint8_t(_value | 0x80));
+        _value >>= 7;
+      }
+      buffer.push_back(uint8_t(_value));
+    }
+    void flushRun() {
+      if (runTicks == 0) return;
+      ticks += runTicks;
+      buffer.push_back(REPLAY_RUN);
+      putVarint(runTicks);
+      buffer.push_back(uint8_t(runInputs.player1));
+      buffer.push_back(uint8_t(runInputs.player2));
+      runTicks = 0;
+      if (buffer.size() >= FLUSH_SIZE) flush();
+    }
+    void keyframe() {
+      index.push_back(ReplayKeyframe{ticks, offset()});
+      state.clear();
+      saveState(*sim, state);
+      buffer.push_back(REPLAY_KEYFRAME);
+      putVarint(ticks);
+      putVarint(state.size());
+      put(state.data(), state.size());
+    }
+    bool flush() {
+      bool ok = buffer.empty() || fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+      written += buffer.size();
+      buffer.clear();
+      return ok;
+    }
+
+   private:  // Data
+    FILE *                      file = NULL;           // The replay being written
+    const Simulation *          sim = NULL;            // The match being recorded
+    uint32_t                    keyframeInterval = 0;  // Ticks between keyframes
+    uint32_t                    ticksToKeyframe = 0;   // Ticks left before the next keyframe is due
+    uint64_t                    ticks = 0;             // Ticks recorded before the current run
+    uint64_t                    written = 0;           // Bytes already handed to the file
+    Inputs                      runInputs;             // Inputs of the run being counted
+    uint64_t                    runTicks = 0;          // Ticks in the run being counted
+    std::vector<uint8_t>        buffer;                // Encoded bytes not yet written
+    std::vector<uint8_t>        state;                 // Scratch space for keyframes
+    std::vector<ReplayKeyframe> index;                 // Every keyframe written so far
+  };
+
+  // A replay mapped into memory, any tick can be reached from the nearest keyframe before it
+  class ReplayFile {
+   public:  // Constructor
+    ReplayFile() {}
+    ~ReplayFile() {
+      close();
+    }
+    ReplayFile(const ReplayFile &) = delete;
+    ReplayFile &operator=(const ReplayFile &) = delete;
+
+   public:  // Opening
+    bool open(const char *_path) {
+      close();
+      if (!map(_path)) return false;
+
+      // Check the header, footer and index all fit before trusting any of them
+      const ReplayHeader *header = reinterpret_cast<const ReplayHeader *>(data);
+      if (size < sizeof(ReplayHeader) + sizeof(ReplayFooter) || memcmp(header->magic, "PONGRPL1", 8) != 0) return close(), false;
+      if (header->version != REPLAY_VERSION || header->byteOrder != REPLAY_BYTE_ORDER || header->fixedPoint != REPLAY_FIXED_POINT) return close(), false;
+      memcpy(&footer, data + size - sizeof(ReplayFooter), sizeof(ReplayFooter));
+      uint64_t indexEnd = size - sizeof(ReplayFooter);
+      if (memcmp(footer.magic, "PONGEND1", 8) != 0 || footer.keyframes == 0 || footer.indexOffset > indexEnd || footer.indexOffset % alignof(ReplayKeyframe) ||
+          footer.keyframes > (indexEnd - footer.indexOffset) / sizeof(ReplayKeyframe))
+        return close(), false;
+      seed = header->seed;
+      keyframes = reinterpret_cast<const ReplayKeyframe *>(data + footer.indexOffset);
+      return true;
+    }
+    void close() {
+      unmap();
+      keyframes = NULL;
+      footer = ReplayFooter();
+    }
+
+   public:  // Accessors
+    uint64_t getTicks() const {
+      return footer.ticks;
+    }
+    uint64_t getKeyframeCount() const {
+      return footer.keyframes;
+    }
+    uint64_t getSize() const {
+      return size;
+    }
+    uint64_t getSeed() const {
+      return seed;
+    }
+    const ReplayFooter &getFooter() const {
+      return footer;
+    }
+
+   public:  // Playback
+    bool seek(Simulation &_sim, uint64_t _tick) {
+      // Restore the last keyframe at or before _tick, then play on to just before tick _tick + 1. The binary search
+      // makes finding the keyframe O(log n) and at most one keyframe interval of ticks is replayed.
+      if (!keyframes) return false;
+      ReplayKeyframe        key = {_tick, UINT64_MAX};
+      const ReplayKeyframe *found = std::upper_bound(keyframes, keyframes + footer.keyframes, key, [](const ReplayKeyframe &_a, const ReplayKeyframe &_b) {
+        return _a.tick < _b.tick;
+      });
+      if (found == keyframes) return false;
+      --found;
+
+      uint64_t cursor = found->offset, tick = 0;
+      if (!loadKeyframe(_sim, cursor, tick)) return false;
+      return playTo(_sim, cursor, tick, _tick, false);
+    }
+    bool verify(Simulation &_sim) {
+      // Play the whole replay from the first keyframe, checking the state against every keyframe on the way
+      if (!keyframes) return false;
+      uint64_t cursor = keyframes[0].offset, tick = 0;
+      if (!loadKeyframe(_sim, cursor, tick)) return false;
+      return playTo(_sim, cursor, tick, footer.ticks, true);
+    }
+
+   private:  // Decoding
+    bool readVarint(uint64_t &_cursor, uint64_t &_value) const {
+      _value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        if (_cursor >= footer.indexOffset) return false;
+        uint8_t byte = data[_cursor++];
+        _value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+      }
+      return false;
+    }
+    bool loadKeyframe(Simulation &_sim, uint64_t &_cursor, uint64_t &_tick) {
+      uint64_t stateSize;
+      if (_cursor >= footer.indexOffset || data[_cursor++] != REPLAY_KEYFRAME) return false;
+      if (!readVarint(_cursor, _tick) || !readVarint(_cursor, stateSize)) return false;
+      if (stateSize > footer.indexOffset - _cursor) return false;
+      if (!loadState(_sim, data + _cursor, size_t(stateSize))) return false;
+      _cursor += stateSize;
+      return true;
+    }
+    bool playTo(Simulation &_sim, uint64_t _cursor, uint64_t _tick, uint64_t _target, bool _checkKeyframes) {
+      while (_cursor < footer.indexOffset) {
+        switch (data[_cursor++]) {
+        case REPLAY_RUN: {
+          // Stop in the middle of a run that goes past the target
+          uint64_t count;
+          if (!readVarint(_cursor, count) || _cursor + 2 > footer.indexOffset) return false;
+          Inputs inputs;
+          inputs.player1 = int8_t(data[_cursor++]);
+          inputs.player2 = int8_t(data[_cursor++]);
+          uint64_t play = std::min(count, _target - _tick);
+          for (uint64_t i = 0; i < play; i++) _sim.tick(inputs);
+          _tick += play;
+          if (play < count) return true;
+          break;
+        }
+        case REPLAY_SERVE:
+          _sim.serve();
+          break;
+        case REPLAY_START:
+          _sim.start();
+          break;
+        case REPLAY_KEYFRAME: {
+          // Already at this state, skip over it or make sure it really is the same
+          uint64_t tick, stateSize;
+          if (!readVarint(_cursor, tick) || !readVarint(_cursor, stateSize) || stateSize > footer.indexOffset - _cursor) return false;
+          if (tick > _target) return true;
+          if (_checkKeyframes) {
+            scratch.clear();
+            saveState(_sim, scratch);
+            if (tick != _tick || scratch.size() != stateSize || memcmp(scratch.data(), data + _cursor, scratch.size()) != 0) return false;
+          }
+          _cursor += stateSize;
+          break;
+        }
+        case REPLAY_END:
+          return true;
+        default:
+          return false;
+        }
+      }
+      return false;
+    }
+
+   private:  // Mapping
+#ifdef _WIN32
+    bool map(const char *_path) {
+      fileHandle = CreateFileA(_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+      if (fileHandle == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) return unmap(), false;
+      mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (!mapping) return unmap(), false;
+      data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      if (!data) return unmap(), false;
+      size = uint64_t(fileSize.QuadPart);
+      return true;
+    }
+    void unmap() {
+      if (data) UnmapViewOfFile(data);
+      if (mapping) CloseHandle(mapping);
+      if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+      data = NULL;
+      mapping = NULL;
+      fileHandle = INVALID_HANDLE_VALUE;
+      size = 0;
+    }
+#else
+    bool map(const char *_path) {
+      int fd = ::open(_path, O_RDONLY);
+      if (fd < 0) return false;
+      struct stat info;
+      if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+      }
+      void *mapped = mmap(NULL, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (mapped == MAP_FAILED) return false;
+      data = static_cast<const uint8_t *>(mapped);
+      size = uint64_t(info.st_size);
+      return true;
+    }
+    void unmap() {
+      if (data) munmap(const_cast<uint8_t *>(data), size_t(size));
+      data = NULL;
+      size = 0;
+    }
+#endif
+
+   private:  // Data
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;  // The open replay
+    HANDLE mapping = NULL;                     // Its file mapping
+#endif
+    const uint8_t *       data = NULL;       // The mapped file
+    uint64_t              size = 0;          // Bytes in the file
+    uint64_t              seed = 0;          // Seed from the header
+    ReplayFooter          footer = {};       // The footer, copied out since the file end needn't be aligned
+    const ReplayKeyframe *keyframes = NULL;  // The keyframe index in the mapped file
+    std::vector<uint8_t>  scratch;           // The replayed state while checking keyframes
+  };
+
+}  // namespace pong
+
+#endif  // PONG_REPLAY_H
@@ -0,0 +1,242 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_SCREEN_H
+#define PONG_SCREEN_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pong {
+
+  // Console text colours, numerically identical to the Win32 FOREGROUND_* combinations
+  enum Colour : uint8_t {
+    COLOUR_BLUE = 9,
+    COLOUR_GREEN = 10,
+    COLOUR_AQUA = 11,
+    COLOUR_RED = 12,
+    COLOUR_MAGENTA = 13,
+    COLOUR_YELLOW = 14,
+    COLOUR_WHITE = 15
+  };
+
+  // A single character cell on screen, colour uses the console attribute bits
+  struct Cell {
+    char    glyph;
+    uint8_t colour;
+
+    bool operator==(const Cell &_other) const {
+      return glyph == _other.glyph && colour == _other.colour;
+    }
+    bool operator!=(const Cell &_other) const {
+      return !(*this == _other);
+    }
+  };
+
+  // Counters describing what the last call to present() produced
+  struct FrameStats {
+    uint64_t frames = 0;          // Number of frames presented
+    uint64_t bytesTotal = 0;      // Bytes emitted over all frames
+    size_t   bytesLastFrame = 0;  // Bytes emitted by the last frame
+    size_t   cellsLastFrame = 0;  // Cells that changed in the last frame
+    size_t   runsLastFrame = 0;   // Cursor moves needed by the last frame
+  };
+
+  class Screen {
+   public:  // Constants
+    static const uint8_t DEFAULT_COLOUR = COLOUR_WHITE;  // The console default used by the game
+    static const int     MAX_RUN_GAP = 4;                // Unchanged cells cheaper to rewrite than to jump over
+
+   public:  // Constructor
+    Screen() {}
+    Screen(int _width, int _height) {
+      resize(_width, _height);
+    }
+
+   public:  // Accessors
+    void resize(int _width, int _height) {
+      width = _width;
+      height = _height;
+      back.assign(size_t(width) * height, Cell{' ', DEFAULT_COLOUR});
+      front.assign(back.size(), Cell{0, 0});
+      outputColour = 0;
+      cursorX = cursorY = 0;
+    }
+    int getWidth() const {
+      return width;
+    }
+    int getHeight() const {
+      return height;
+    }
+    const Cell &at(int _x, int _y) const {
+      return back[size_t(_y) * width + _x];
+    }
+    const FrameStats &getStats() const {
+      return stats;
+    }
+    const std::vector<Cell> &getCells() const {
+      // The frame being drawn, row by row
+      return back;
+    }
+
+   public:  // Console style drawing
+    void setCursorPosition(int _x, int _y) {
+      cursorX = _x;
+      cursorY = _y;
+    }
+    void setColour(uint8_t _colour) {
+      colour = _colour;
+    }
+    void print(char _glyph) {
+      // Mirror the console: newlines and the right edge move to the next row
+      if (_glyph == '\n') {
+        cursorX = 0;
+        cursorY++;
+        return;
+      }
+      if (cursorX >= width) {
+        cursorX = 0;
+        cursorY++;
+      }
+      put(cursorX, cursorY, _glyph, colour);
+      cursorX++;
+    }
+    void print(const char *_text) {
+      while (*_text) print(*_text++);
+    }
+    void fill(char _glyph, int _count) {
+      for (int i = 0; i < _count; i++) print(_glyph);
+    }
+    void put(int _x, int _y, char _glyph, uint8_t _colour) {
+      if (_x >= 0 && _x < width && _y >= 0 && _y < height)
+        back[size_t(_y) * width + _x] = Cell{_glyph, _colour};
+    }
+    void blit(int _x, int _y, const char *_glyphs, int _width, int _height, uint8_t _colour) {
+      // Copy a block of glyphs into the frame in one go, '\0' leaves a cell as it is
+      for (int row = 0; row < _height; row++) {
+        int y = _y + row;
+        if (y < 0 || y >= height) continue;
+        const char *source = _glyphs + size_t(row) * _width;
+        Cell *      target = &back[size_t(y) * width];
+        for (int i = 0; i < _width; i++) {
+          int x = _x + i;
+          if (source[i] && x >= 0 && x < width) target[x] = Cell{source[i], _colour};
+        }
+      }
+    }
+    void assign(const Cell *_cells) {
+      // Replace the whole frame with one drawn elsewhere at the same size
+      std::copy(_cells, _cells + back.size(), back.begin());
+    }
+    void invalidate() {
+      // Force the next frame to repaint every cell
+      for (Cell &cell : front) cell = Cell{0, 0};
+      outputColour = 0;
+    }
+
+   public:  // Frame output
+    const std::string &present() {
+      output.clear();
+      stats.cellsLastFrame = 0;
+      stats.runsLastFrame = 0;
+
+      // The terminal cursor position after the last emitted glyph, -1 when unknown
+      int terminalX = -1, terminalY = -1;
+
+      for (int y = 0; y < height; y++) {
+        const Cell *backRow = &back[size_t(y) * width];
+        Cell *      frontRow = &front[size_t(y) * width];
+
+        int x = 0;
+        while (x < width) {
+          if (backRow[x] == frontRow[x]) {
+            x++;
+            continue;
+          }
+
+          // Grow the run over short gaps of unchanged cells
+          int runEnd = x + 1;
+          for (int i = runEnd; i < width && i - runEnd < MAX_RUN_GAP; i++) {
+            if (backRow[i] != frontRow[i]) runEnd = i + 1;
+          }
+
+          // Move the terminal cursor only if it is not already there
+          if (terminalX != x || terminalY != y) {
+            appendCursorMove(x, y);
+            stats.runsLastFrame++;
+          }
+
+          // Emit the run, only switching colour when it actually changes
+          for (int i = x; i < runEnd; i++) {
+            if (backRow[i].colour != outputColour) appendColour(backRow[i].colour);
+            output += backRow[i].glyph ? backRow[i].glyph : ' ';
+            if (backRow[i] != frontRow[i]) stats.cellsLastFrame++;
+            frontRow[i] = backRow[i];
+          }
+
+          // Writing the last column leaves the cursor in a pending wrap state
+          terminalX = (runEnd < width) ? runEnd : -1;
+          terminalY = y;
+          x = runEnd;
+        }
+      }
+
+      stats.frames++;
+      stats.bytesLastFrame = output.size();
+      stats.bytesTotal += output.size();
+      return output;
+    }
+
+   private:  // VT sequence helpers
+    void appendNumber(int _value) {
+      char digits[12];
+      int  count = 0;
+      do {
+        digits[count++] = char('0' + _value % 10);
+        _value /= 10;
+      } while (_value);
+      while (count) output += digits[--count];
+    }
+    void appendCursorMove(int _x, int _y) {
+      output += "\x1b[";
+      appendNumber(_y + 1);
+      output += ';';
+      appendNumber(_x + 1);
+      output += 'H';
+    }
+    void appendColour(uint8_t _colour) {
+      // Console attributes order the bits BGR while ANSI orders them RGB
+      int ansi = ((_colour & 4) ? 1 : 0) | ((_colour & 2) ? 2 : 0) | ((_colour & 1) ? 4 : 0);
+      output += "\x1b[";
+      appendNumber(((_colour & 8) ? 90 : 30) + ansi);
+      output += 'm';
+      outputColour = _colour;
+    }
+
+   private:  // Data
+    int               width = 0, height = 0;     // The size of the screen in cells
+    int               cursorX = 0, cursorY = 0;  // Where the next printed glyph will go
+    uint8_t           colour = DEFAULT_COLOUR;   // Colour of the next printed glyph
+    uint8_t           outputColour = 0;          // The colour the terminal is currently set to
+    std::vector<Cell> back;                      // The frame being drawn
+    std::vector<Cell> front;                     // What the terminal is currently showing
+    std::string       output;                    // The VT bytes produced by the last present
+    FrameStats        stats;                     // Counters for the last and all frames
+  };
+
+}  // namespace pong
+
+#endif  // PONG_SCREEN_H
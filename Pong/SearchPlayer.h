@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_SEARCH_PLAYER_H
+#define PONG_SEARCH_PLAYER_H
+
+#include <cstdint>
+
+#include "CompactState.h"
+#include "CpuPlayer.h"
+#include "FrameTimer.h"
+
+namespace pong {
+
+  // How much searching an expert does for each tick it moves
+  struct SearchBudget {
+    int      microseconds = 500;  // Time spent on one decision before taking the best move so far
+    uint32_t maxNodes = 200000;   // Ticks stepped for one decision, whatever the time
+    int      horizonTicks = 480;  // Longest a rollout plays on before it's scored where it stands
+  };
+
+  // The expert CPU. Each tick it clones the game, plays it forward a few hundred ticks for each of the three ways
+  // the paddle can move, and moves the way that lost the fewest points. The paddle only moves as fast as a player's,
+  // every tick of look ahead is what makes it better than the predicting CPUs.
+  class SearchPlayer {
+   public:  // Types
+    struct Stats {
+      uint64_t decisions = 0;  // Ticks a move was chosen for
+      uint64_t nodes = 0;      // Ticks stepped while searching
+      uint64_t rollouts = 0;   // Futures played out
+      uint64_t clones = 0;     // Copies of the game taken to play them from
+      uint64_t searchNs = 0;   // Time spent searching
+    };
+
+   public:  // Setup
+    void setBudget(const SearchBudget &_budget) {
+      budget = _budget;
+    }
+    const SearchBudget &getBudget() const {
+      return budget;
+    }
+    void setRandom(const Random &_random) {
+      random = _random;
+    }
+    const Stats &getStats() const {
+      return stats;
+    }
+
+   public:  // Searching
+    int8_t choose(const Simulation &_sim) {
+      // The opponent's travel for the next tick, to go in the inputs' player2
+      return choose(CompactState::capture(_sim), StepRules::capture(_sim));
+    }
+    int8_t choose(const CompactState &_state, const StepRules &_rules) {
+      if (_state.gameState != GameState::IN_PLAY) return 0;
+      Clock::time_point start = Clock::now();
+      Clock::time_point deadline = start + std::chrono::microseconds(budget.microseconds);
+      const int8_t      moves[MOVE_COUNT] = {-Inputs::FULL_TICK, 0, Inputs::FULL_TICK};
+
+      // Hold each first move for a reference tick so the moves end up far enough apart to tell between
+      int holdTicks = int(Real(1) / _rules.timeScale + Real(0.5f));
+      if (holdTicks < 1) holdTicks = 1;
+      Real     totals[MOVE_COUNT] = {};
+      uint64_t nodesBefore = stats.nodes;
+      do {
+        // Every move is tried against the same future, so the only difference between them is the move
+        Rollout rollout;
+        rollout.aim = random.nextReal(-2, 2);
+        rollout.player1Aim = random.nextReal(-3, 3);
+        for (int move = 0; move < MOVE_COUNT; move++) totals[move] += play(_state, _rules, rollout, moves[move], holdTicks);
+      } while (stats.nodes - nodesBefore < budget.maxNodes && Clock::now() < deadline);
+
+      // Take the best move, ties go to the way the paddle was heading anyway
+      int8_t tracked = trackMove(_state, _rules, _state.opponent(), 0);
+      int    best = (tracked < 0) ? 0 : (tracked > 0) ? 2 : 1;
+      for (int move = 0; move < MOVE_COUNT; move++) {
+        if (totals[move] > totals[best]) best = move;
+      }
+      stats.decisions++;
+      stats.searchNs += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+      return moves[best];
+    }
+
+   private:  // Types
+    enum { MOVE_COUNT = 3 };
+    struct Rollout {
+      Real aim = 0;         // Where on its paddle the expert meets the ball in the rest of this future
+      Real player1Aim = 0;  // How far off player 1 is in reaching the ball
+    };
+
+   private:  // Rollouts
+    Real play(const CompactState &_state, const StepRules &_rules, const Rollout &_rollout, int8_t _move, int _holdTicks) {
+      // Clone the game and play on until a point is won or the horizon is reached
+      CompactState         state = _state;
+      CompactState::Paddle opponent = state.opponent();
+      stats.clones++;
+      stats.rollouts++;
+      for (int ticks = 0; ticks < budget.horizonTicks; ticks++) {
+        Inputs inputs;
+        inputs.player1 = trackMove(state, _rules, CompactState::PLAYER_1, _rollout.player1Aim);
+        inputs.player2 = (ticks < _holdTicks) ? _move : trackMove(state, _rules, opponent, _rollout.aim);
+        int16_t  opponentScore = state.score[opponent];
+        uint32_t events = step(state, inputs, _rules);
+        stats.nodes++;
+        if (events & EVENT_POINT_SCORED) return (state.score[opponent] > opponentScore) ? Real(1) : Real(-1);
+        if (state.gameState != GameState::IN_PLAY) break;
+      }
+
+      // Scored on how far the paddle is from where the ball will reach it, never as much as a point
+      if (state.ballVX <= 0) return 0;
+      Real meet = CpuPlayer::predictY(state.ballX, state.ballY, state.ballVX, state.ballVY, Real(_rules.width - 1), 3,
+                                      Real(_rules.height - 1));
+      Real miss = meet - state.paddleY[opponent];
+      if (miss < 0) miss = -miss;
+      return -miss / Real(_rules.height);
+    }
+    static int8_t trackMove(const CompactState &_state, const StepRules &_rules, CompactState::Paddle _paddle, Real _aim) {
+      // The travel that takes the paddle towards where the ball will cross its plane, or back to the middle
+      bool left = (_paddle == CompactState::PLAYER_1);
+      Real target = Real(_rules.height / 2);
+      if (left ? _state.ballVX < 0 : _state.ballVX > 0) {
+        Real planeX = left ? Real(1) : Real(_rules.width - 1);
+        target = CpuPlayer::predictY(_state.ballX, _state.ballY, _state.ballVX, _state.ballVY, planeX, 3,
+                                     Real(_rules.height - 1)) + _aim;
+      }
+      Real need = (target - _state.paddleY[_paddle]) / _rules.timeScale;
+      if (need >= 1) return Inputs::FULL_TICK;
+      if (need <= -1) return -Inputs::FULL_TICK;
+      return int8_t(int(need * Inputs::FULL_TICK));
+    }
+
+   private:  // Data
+    SearchBudget budget;  // How long each decision may take
+    Random       random;  // Draws the futures each decision is tried against
+    Stats        stats;   // Work done searching so far
+  };
+
+}  // namespace pong
+
+#endif  // PONG_SEARCH_PLAYER_H
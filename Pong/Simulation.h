@@ -0,0 +1,865 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_SIMULATION_H
+#define PONG_SIMULATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "BallSwarm.h"
+#include "CpuPlayer.h"
+#include "Fixed.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "Screen.h"
+
+namespace pong {
+
+  class Simulation;
+  struct CompactState;
+
+  enum class GameMode {
+    NOT_STARTED = -1,
+    MULTIPLAYER = 0,
+    EASY = 1,
+    MEDIUM = 2,
+    HARD = 3,
+    IMPOSSIBLE = 4,
+    MULTIBALL = 5,
+    EXPERT = 6  // The opponent is moved by the inputs, which a SearchPlayer fills in
+  };
+  enum class GameState {
+    NOT_STARTED = -1,
+    PAUSED = 0,
+    IN_PLAY = 1,
+    PLAYER_1_WINNER = 2,
+    PLAYER_2_WINNER = 3,
+    CPU_WINNER = 4
+  };
+
+  // Things that happened during a tick, so a front end can play sounds and redraw
+  enum Event : uint32_t {
+    EVENT_NONE = 0,
+    EVENT_PADDLE_HIT = 1 << 0,       // The ball was returned by a paddle
+    EVENT_WALL_BOUNCE = 1 << 1,      // The ball bounced off the top or bottom wall
+    EVENT_POINT_SCORED = 1 << 2,     // The ball got past a paddle and the play needs a serve
+    EVENT_SURVIVAL_RETURN = 1 << 3,  // Player 1 scored by returning the ball in survival mode
+    EVENT_GAME_OVER = 1 << 4,        // A player reached the winning score
+    EVENT_SCORE_CHANGED = 1 << 5     // A multi-ball ball got past a paddle and was served again straight away
+  };
+
+  // What the ball reaches next along its path
+  enum Surface {
+    SURFACE_NONE = 0,
+    SURFACE_TOP,     // The wall at y = 3
+    SURFACE_BOTTOM,  // The wall at y = height - 1
+    SURFACE_LEFT,    // Player 1's paddle plane at x = 1
+    SURFACE_RIGHT    // The opponent's paddle plane at x = width - 1
+  };
+
+  // Paddle travel for one tick in 127ths of a full tick's movement, negative is up and positive is down
+  struct Inputs {
+    static const int8_t FULL_TICK = 127;  // Travel of a key held for the whole tick
+
+    int8_t player1 = 0;
+    int8_t player2 = 0;
+  };
+
+  // An on screen cell position
+  struct Position {
+    int X = 0;
+    int Y = 0;
+  };
+
+  // Shape event handlers that do nothing, used when a setter is called without an owner to tell
+  struct NoShapeEvents {
+    template <typename S>
+    void beforePositionChange(S &) {}
+    template <typename S>
+    void afterPositionChange(S &) {}
+    template <typename S>
+    void beforeVelocityChange(S &) {}
+    template <typename S>
+    void afterVelocityChange(S &) {}
+  };
+
+  // The common position and velocity of the players and ball. The setters take the handler to tell about the change
+  // as a template argument, so the calls are resolved at compile time and the shapes carry no callbacks.
+  template <typename Derived>
+  class Shape {
+   public:  // Constructor
+    Shape(int _width, int _height) : width(_width), height(_height) {}
+
+   public:  // Accessors
+    void setVisibility(bool _visibility = true) {
+      visible = _visibility;
+    }
+    template <typename Events = NoShapeEvents>
+    void setXPosition(Real _xPosition, Events &&_events = Events()) {
+      _events.beforePositionChange(self());
+      x = _xPosition;
+      _events.afterPositionChange(self());
+    }
+    template <typename Events = NoShapeEvents>
+    void setYPosition(Real _yPosition, Events &&_events = Events()) {
+      _events.beforePositionChange(self());
+      y = _yPosition;
+      _events.afterPositionChange(self());
+    }
+    template <typename Events = NoShapeEvents>
+    void setAbsPosition(int _xPosition, int _yPosition, Events &&_events = Events()) {
+      _events.beforePositionChange(self());
+
+      x = Real(_xPosition);
+      position.X = _xPosition;
+      y = Real(_yPosition);
+      position.Y = _yPosition;
+
+      _events.afterPositionChange(self());
+    }
+    template <typename Events = NoShapeEvents>
+    void setXVelocity(Real _vx, Events &&_events = Events()) {
+      _events.beforeVelocityChange(self());
+      vx = _vx;
+      _events.afterVelocityChange(self());
+    }
+    template <typename Events = NoShapeEvents>
+    void setYVelocity(Real _vy, Events &&_events = Events()) {
+      _events.beforeVelocityChange(self());
+      vy = _vy;
+      _events.afterVelocityChange(self());
+    }
+    template <typename Events = NoShapeEvents>
+    void setVelocities(Real _vx, Real _vy, Events &&_events = Events()) {
+      _events.beforeVelocityChange(self());
+      vx = _vx;
+      vy = _vy;
+      _events.afterVelocityChange(self());
+    }
+    bool isVisible() const {
+      return visible;
+    }
+    Real getX() const {
+      return x;
+    }
+    Real getY() const {
+      return y;
+    }
+    Real getXVelocity() const {
+      return vx;
+    }
+    Real getYVelocity() const {
+      return vy;
+    }
+
+   public:  // State
+    template <typename Archive>
+    void serialize(Archive &_archive) {
+      // Hand every field to the archive, which either saves or restores them
+      _archive.value(visible);
+      _archive.value(width);
+      _archive.value(height);
+      _archive.value(x);
+      _archive.value(y);
+      _archive.value(vx);
+      _archive.value(vy);
+      _archive.value(position.X);
+      _archive.value(position.Y);
+    }
+
+   protected:  // Helpers
+    Derived &self() {
+      return static_cast<Derived &>(*this);
+    }
+
+   protected:  // Data
+    bool     visible = false;
+    int      width = 0, height = 0;  // The width and height of the object
+    Real     x = 0, y = 0;           // The coordinates of the player used for calculating position
+    Real     vx = 0, vy = 0;         // Velocity of the shape in space
+    Position position;               // the onscreen position of the middle of the player
+  };
+
+  class Player : public Shape<Player> {
+   public:  // Friends
+    friend Simulation;
+    friend CompactState;
+
+   public:  // Constructor
+    Player() : Shape(1, 5) {}
+
+   public:  // Player Movement Handles
+    template <typename Events = NoShapeEvents>
+    void moveUp(Real _timeScale = 1, Events &&_events = Events()) {
+      setYPosition(y - vy * _timeScale, _events);
+    }
+    template <typename Events = NoShapeEvents>
+    void moveDown(Real _timeScale = 1, Events &&_events = Events()) {
+      setYPosition(y + vy * _timeScale, _events);
+    }
+
+   public:  // Accessors
+    int getScore() const {
+      return score;
+    }
+    bool hasLostLastPoint() const {
+      return lostLastPoint;
+    }
+
+   public:  // State
+    template <typename Archive>
+    void serialize(Archive &_archive) {
+      Shape<Player>::serialize(_archive);
+      _archive.value(score);
+      _archive.value(lostLastPoint);
+    }
+
+   public:  // Drawing
+    void draw(Screen *_screen) {
+      drawAt(_screen, float(y));
+    }
+    void drawAt(Screen *_screen, float _y) {
+      if (visible) {
+        // Work out the top of the player from the requested y value
+        Position drawPosition = position;
+        drawPosition.Y = int(_y) - 2;
+
+        // Write the player into the frame in its colour
+        for (int i = 0; i < height; i++) {
+          _screen->put(drawPosition.X, drawPosition.Y, 'I', COLOUR_AQUA);
+          drawPosition.Y += 1;
+        }
+      }
+    }
+    void clear(Screen *_screen) {
+      // Update Player Position
+      Position drawPosition = position;
+      drawPosition.Y -= 2;
+      for (int i = 0; i < height; i++) {
+        _screen->put(drawPosition.X, drawPosition.Y, ' ', COLOUR_WHITE);
+        drawPosition.Y += 1;
+      }
+    }
+
+   private:                      // Private Data
+    int  score = 0;              // The current score of the player
+    bool lostLastPoint = false;  // Keep track of if the player lost their last point
+  };
+
+  class Ball : public Shape<Ball> {
+   public:  // Friends
+    friend Simulation;
+    friend CompactState;
+
+   public:  // Constructors
+    Ball() : Shape(1, 1) {}
+
+   private:  // Path
+    void setPath(Real _x, Real _y, Real _offset) {
+      // Start a straight line path from here, _offset through the current tick
+      x = originX = _x;
+      y = originY = _y;
+      pathOffset = _offset;
+      pathTicks = 0;
+    }
+    Real pathAge(uint32_t _tickBoundary) const {
+      // Reference ticks travelled along the path at a tick boundary, the same sum whichever way the ball got there
+      return Real(_tickBoundary) - pathOffset;
+    }
+    void moveAlongPath(Real _age, Real _timeScale) {
+      x = originX + vx * _timeScale * _age;
+      y = originY + vy * _timeScale * _age;
+    }
+
+   public:  // Drawing
+    void draw(Screen *_screen) {
+      drawAt(_screen, float(x), float(y));
+    }
+    void drawAt(Screen *_screen, float _x, float _y) {
+      // Update the position
+      position.X = int(_x);
+      position.Y = int(_y);
+
+      // Draw into the frame
+      _screen->put(position.X, position.Y, 'O', COLOUR_GREEN);
+    }
+    void clear(Screen *_screen) {
+      _screen->put(position.X, position.Y, ' ', COLOUR_WHITE);
+    }
+
+   public:  // State
+    template <typename Archive>
+    void serialize(Archive &_archive) {
+      Shape<Ball>::serialize(_archive);
+      _archive.value(originX);
+      _archive.value(originY);
+      _archive.value(pathOffset);
+      _archive.value(pathTicks);
+    }
+
+   private:  // Path Data
+    Real     originX = 0, originY = 0;  // Where the current path started
+    Real     pathOffset = 0;            // How far through its tick the path started
+    uint32_t pathTicks = 0;             // Tick boundaries crossed since the path started
+  };
+
+  // The rules of Pong stepped one tick at a time with no console, sound or sleeping
+  class Simulation {
+   public:  // Constants
+    static constexpr float REFERENCE_TICK_RATE = 1000.0f / 30.0f;  // Ticks per second the speeds are tuned for
+    static const int       MAX_BOUNCES_PER_TICK = 8;               // Guard against a ball wedged in a corner
+
+   public:  // Constructor
+    Simulation(int _width = 79, int _height = 35, uint64_t _seed = 1) : width(_width), height(_height) {
+      seed(_seed);
+
+      // Init the players, the CPU's paddle moves at the same speed when the inputs steer it
+      player1.setYVelocity(1);
+      player2.setYVelocity(1);
+      cpu.setYVelocity(1);
+
+      // Step the multi-ball swarm with the widest vectors the CPU has
+      swarm.setKernel(BallSwarm::bestKernel());
+    }
+
+   public:  // Setup
+    void seed(uint64_t _seed) {
+      // The CPUs get their own streams jumped far past the simulation's so they never overlap it
+      seedValue = _seed;
+      random.seed(_seed);
+      Random stream = random;
+      stream.jump();
+      leftCpu.setRandom(stream);
+      stream.jump();
+      rightCpu.setRandom(stream);
+    }
+    uint64_t getSeed() const {
+      return seedValue;
+    }
+    void setTickRate(float _ticksPerSecond) {
+      // Speeds stay per reference tick, each tick covers a fraction of one
+      timeScale = Real(REFERENCE_TICK_RATE) / Real(_ticksPerSecond);
+    }
+    static CpuProfile cpuProfile(GameMode _difficulty) {
+      // The default CPU for each difficulty, replace a CPU's profile after setting the mode to tune it
+      CpuProfile profile;
+      switch (_difficulty) {
+      case GameMode::EASY:
+        profile.reactionTicks = 6;
+        profile.noise = Real(4.5f);
+        profile.maxSpeed = Real(0.8f);
+        break;
+      case GameMode::MEDIUM:
+        profile.reactionTicks = 4;
+        profile.noise = Real(3.5f);
+        profile.maxSpeed = Real(1.1f);
+        break;
+      case GameMode::HARD:
+        profile.reactionTicks = 3;
+        profile.noise = Real(2.8f);
+        profile.maxSpeed = Real(1.4f);
+        break;
+      default:
+        // Impossible sees every ball at once and gets there straight away
+        break;
+      }
+      return profile;
+    }
+    void setMode(GameMode _gameMode) {
+      gameMode = _gameMode;
+      rightCpu.setProfile(cpuProfile(gameMode == GameMode::MULTIBALL ? multiBallCpu : gameMode));
+
+      // Show the correct players
+      switch (gameMode) {
+      case GameMode::NOT_STARTED:
+        player1.visible = false;
+        player2.visible = false;
+        cpu.visible = false;
+        break;
+      case GameMode::MULTIPLAYER:
+        player1.visible = true;
+        player2.visible = true;
+        cpu.visible = false;
+        break;
+      default:
+        player1.visible = true;
+        player2.visible = false;
+        cpu.visible = true;
+        break;
+      }
+    }
+    void setPlayer1Cpu(GameMode _difficulty) {
+      // NOT_STARTED leaves player 1 to the inputs, anything else lets the CPU steer it
+      player1Cpu = _difficulty;
+      leftCpu.setProfile(cpuProfile(player1Cpu));
+    }
+    void resetGame() {
+      // Reset the scores
+      player1.score = 0;
+      player2.score = 0;
+      cpu.score = 0;
+      player1.lostLastPoint = false;
+      player2.lostLastPoint = false;
+      cpu.lostLastPoint = false;
+
+      // Reset the states
+      setMode(GameMode::NOT_STARTED);
+      gameState = GameState::NOT_STARTED;
+    }
+    void serve() {
+      // Get the opponent
+      Player *opponent = getOpponent();
+
+      // If the game mode was impossible reset player 1 score
+      if (gameMode == GameMode::IMPOSSIBLE && player1.score > 0) {
+        player1.score = 0;
+      }
+
+      // Reset the game to start conditions
+      leftCpu.forget();
+      rightCpu.forget();
+      player1.setAbsPosition(0, height / 2, *this);
+      opponent->setAbsPosition(width - 1, height / 2, *this);
+      ball.setAbsPosition(width / 2, height / 2, *this);
+
+      // Serve the ball towards the winner
+      if (player1.lostLastPoint) {
+        ball.setVelocities(randomReal(minXSpeed / 2, maxXSpeed / 2), randomReal(-maxYSpeed / 3, maxYSpeed / 3), *this);
+        player1.lostLastPoint = false;
+      } else if (opponent->lostLastPoint) {
+        ball.setVelocities(randomReal(-maxXSpeed / 2, -minXSpeed / 2), randomReal(-maxYSpeed / 3, maxYSpeed / 3), *this);
+        opponent->lostLastPoint = false;
+      } else {
+        ball.setVelocities(randomReal(-maxXSpeed / 2, maxXSpeed / 2), randomReal(-maxYSpeed / 3, maxYSpeed / 3), *this);
+      }
+
+      // Multi-ball serves the whole swarm from the middle
+      if (gameMode == GameMode::MULTIBALL) {
+        size_t count = size_t(multiBallCount);
+        swarm.resize(count, float(width / 2), float(height / 2));
+        swarmServe.resize(count * 2);
+        random.fill(swarmServe.data(), count, -float(maxXSpeed) / 2, float(maxXSpeed) / 2);
+        random.fill(swarmServe.data() + count, count, -float(maxYSpeed) / 3, float(maxYSpeed) / 3);
+        for (size_t i = 0; i < count; i++) {
+          float vx = swarmServe[i], vy = swarmServe[count + i];
+          clampBallVelocity(vx, vy);
+          swarm.set(i, float(width / 2), float(height / 2), vx, vy);
+        }
+        swarmStep = SwarmStep();
+      }
+
+      // Wait for the play to be started
+      gameState = GameState::PAUSED;
+    }
+    void start() {
+      gameState = GameState::IN_PLAY;
+    }
+
+   public:  // Simulation
+    uint32_t tick(const Inputs &_inputs) {
+      if (gameState != GameState::IN_PLAY) return EVENT_NONE;
+      events = EVENT_NONE;
+      playNeedsReset = false;
+
+      // Move the players, then the balls against where the players are now
+      movePlayers(_inputs);
+      if (gameMode == GameMode::MULTIBALL) {
+        stepSwarm();
+      } else {
+        sweepBall();
+      }
+      finishTick();
+      return events;
+    }
+    uint32_t advanceToNextEvent(uint64_t _maxTicks, uint64_t *_ticks) {
+      // Skip over the ticks before the ball next reaches a wall or paddle plane, then play the tick it does.
+      // Only CPU players can be skipped over, with a human, an expert or in multi-ball this is one tick.
+      *_ticks = 0;
+      if (gameState != GameState::IN_PLAY || _maxTicks == 0) return EVENT_NONE;
+      if (player1Cpu != GameMode::NOT_STARTED && gameMode != GameMode::MULTIPLAYER && gameMode != GameMode::MULTIBALL &&
+          gameMode != GameMode::EXPERT) {
+        // Stop a tick early on the skipped side of the event, the tick that plays it finds the exact time anyway
+        int      surface;
+        Real     eventAge = nextBallEvent(&surface);
+        Real     quietTicks = floor(eventAge + ball.pathOffset) - Real(ball.pathTicks) - 2;
+        uint64_t quiet = (quietTicks > 0) ? uint64_t(int(std::min(quietTicks, Real(1e9f)))) : 0;
+        if (quiet > _maxTicks - 1) quiet = _maxTicks - 1;
+
+        // In a quiet tick only the paddles and the ball's place along its path change
+        Inputs noInputs;
+        for (uint64_t i = 0; i < quiet; i++) {
+          movePlayers(noInputs);
+          ball.pathTicks++;
+          ball.moveAlongPath(ball.pathAge(ball.pathTicks), timeScale);
+        }
+        *_ticks = quiet;
+      }
+      (*_ticks)++;
+      return tick(Inputs());
+    }
+    Player *getOpponent() {
+      Player *opponent;
+      if (gameMode == GameMode::MULTIPLAYER) {
+        opponent = &player2;
+      } else {
+        opponent = &cpu;
+      }
+      return opponent;
+    }
+    const Player *getOpponent() const {
+      return (gameMode == GameMode::MULTIPLAYER) ? &player2 : &cpu;
+    }
+
+   public:  // State
+    template <typename Archive>
+    void serialize(Archive &_archive) {
+      // Everything that decides how the game plays on, the swarm kernel is left out since they all agree
+      _archive.value(width);
+      _archive.value(height);
+      _archive.value(gameMode);
+      _archive.value(gameState);
+      _archive.value(player1Cpu);
+      _archive.value(autoServe);
+      _archive.value(winningScore);
+      _archive.value(seedValue);
+      _archive.value(random);
+      _archive.value(timeScale);
+      player1.serialize(_archive);
+      player2.serialize(_archive);
+      cpu.serialize(_archive);
+      leftCpu.serialize(_archive);
+      rightCpu.serialize(_archive);
+      ball.serialize(_archive);
+      _archive.value(maxXSpeed);
+      _archive.value(minXSpeed);
+      _archive.value(maxYSpeed);
+      _archive.value(minYSpeed);
+      swarm.serialize(_archive);
+      _archive.value(swarmStep);
+      _archive.value(multiBallCount);
+      _archive.value(multiBallWinningScore);
+      _archive.value(multiBallCpu);
+    }
+
+   public:  // Shape events, called by the setters the simulation passes itself to
+    template <typename S>
+    void beforePositionChange(S &) {}
+    template <typename S>
+    void beforeVelocityChange(S &) {}
+    template <typename S>
+    void afterVelocityChange(S &) {}
+    void afterPositionChange(Player &_player) {
+      // Check if there are collisions with the wall
+      int playerHalfHeight = int(_player.height / 2);
+      int playerTop = int(_player.y - playerHalfHeight);
+      int playerBottom = int(_player.y + playerHalfHeight);
+      if (playerTop < 3) {
+        _player.setYPosition(Real(3 + playerHalfHeight));
+      } else if (playerBottom > height - 1) {
+        _player.setYPosition(Real(height - 1 - playerHalfHeight));
+      }
+
+      // Keep the onscreen position used for collisions up to date
+      _player.position.Y = int(_player.y);
+    }
+    void afterPositionChange(Ball &_ball) {
+      // Moving the ball by hand starts a new path from the start of the next tick
+      _ball.setPath(_ball.x, _ball.y, 0);
+    }
+    void afterVelocityChange(Ball &_ball) {
+      clampBallVelocity(_ball.vx, _ball.vy);
+      _ball.setPath(_ball.x, _ball.y, 0);
+    }
+
+   private:  // Game Logic Methods
+    void movePlayers(const Inputs &_inputs) {
+      // Work out which ball each CPU should chase, in multi-ball the nearest one heading its way as of the last tick
+      uint32_t leftTarget = 0, rightTarget = 0;
+      bool     leftApproaching = ball.vx < 0, rightApproaching = ball.vx > 0;
+      if (gameMode == GameMode::MULTIBALL) {
+        leftApproaching = swarmStep.leftTarget >= 0;
+        rightApproaching = swarmStep.rightTarget >= 0;
+        if (leftApproaching) leftTarget = uint32_t(swarmStep.leftTarget);
+        if (rightApproaching) rightTarget = uint32_t(swarmStep.rightTarget);
+      }
+
+      // Move the players, either from the inputs or the CPU
+      if (player1Cpu == GameMode::NOT_STARTED) {
+        movePlayer(player1, _inputs.player1);
+      } else {
+        steerCpu(leftCpu, player1, leftApproaching, leftTarget, 1);
+      }
+      if (gameMode == GameMode::MULTIPLAYER) {
+        movePlayer(player2, _inputs.player2);
+      } else if (gameMode == GameMode::EXPERT) {
+        movePlayer(cpu, _inputs.player2);
+      } else {
+        steerCpu(rightCpu, cpu, rightApproaching, rightTarget, Real(width - 1));
+      }
+    }
+    Real nextBallEvent(int *_surface) const {
+      // Age along the ball's path at which it next reaches a wall or a paddle plane
+      Real stepX = ball.vx * timeScale, stepY = ball.vy * timeScale;
+      Real best = realMax();
+      *_surface = SURFACE_NONE;
+      if (stepY < 0 && (3 - ball.originY) / stepY < best) {
+        best = (3 - ball.originY) / stepY;
+        *_surface = SURFACE_TOP;
+      } else if (stepY > 0 && (Real(height - 1) - ball.originY) / stepY < best) {
+        best = (Real(height - 1) - ball.originY) / stepY;
+        *_surface = SURFACE_BOTTOM;
+      }
+      if (stepX < 0 && (1 - ball.originX) / stepX < best) {
+        best = (1 - ball.originX) / stepX;
+        *_surface = SURFACE_LEFT;
+      } else if (stepX > 0 && (Real(width - 1) - ball.originX) / stepX < best) {
+        best = (Real(width - 1) - ball.originX) / stepX;
+        *_surface = SURFACE_RIGHT;
+      }
+      return best;
+    }
+    void sweepBall() {
+      PONG_PROFILE(PHASE_BALL);
+      // Play out every collision the ball reaches this tick in order, each at the moment it happens
+      for (int bounce = 0; bounce < MAX_BOUNCES_PER_TICK; bounce++) {
+        int  surface;
+        Real eventAge = nextBallEvent(&surface);
+        Real tickStart = ball.pathAge(ball.pathTicks);
+        if (!(eventAge <= ball.pathAge(ball.pathTicks + 1))) break;
+
+        // Move to the point of impact and start the new path from there
+        ball.moveAlongPath(eventAge, timeScale);
+        resolveBallEvent(surface, eventAge - tickStart);
+        if (playNeedsReset) return;
+      }
+
+      // Carry on along the path to the end of the tick
+      ball.pathTicks++;
+      ball.moveAlongPath(ball.pathAge(ball.pathTicks), timeScale);
+    }
+    void resolveBallEvent(int _surface, Real _tickFraction) {
+      switch (_surface) {
+      case SURFACE_TOP:
+      case SURFACE_BOTTOM:
+        // Reflect off the wall
+        ball.vy = -ball.vy;
+        ball.setPath(ball.x, _surface == SURFACE_TOP ? Real(3) : Real(height - 1), _tickFraction);
+        events |= EVENT_WALL_BOUNCE;
+        break;
+      case SURFACE_LEFT: {
+        // Get position relative to player1
+        int ballRelPos = player1.position.Y - int(ball.y);
+        int playerHalfHeight = player1.height / 2;
+
+        if (ballRelPos <= playerHalfHeight && ballRelPos >= -playerHalfHeight) {
+          // Return the ball from the paddle plane
+          Real newXVelocity = randomReal(minXSpeed, maxXSpeed);
+          Real newYVelocity = ball.vy + ballRelPos / 4 + randomReal(Real(-0.5f), Real(0.5f));
+          clampBallVelocity(newXVelocity, newYVelocity);
+          ball.vx = newXVelocity;
+          ball.vy = newYVelocity;
+          ball.setPath(1, ball.y, _tickFraction);
+          events |= EVENT_PADDLE_HIT;
+
+          // If in impossible mode add to score each hit
+          if (gameMode == GameMode::IMPOSSIBLE) {
+            player1.score += 1;
+            events |= EVENT_SURVIVAL_RETURN;
+          }
+        } else {
+          // add score to CPU or player 2
+          ball.setPath(0, ball.y, _tickFraction);
+          player1.lostLastPoint = true;
+          getOpponent()->score += 1;
+          playNeedsReset = true;
+        }
+        break;
+      }
+      case SURFACE_RIGHT: {
+        // Get position relative to opponent
+        Player *opponent = getOpponent();
+        int     ballRelPos = int(ball.y) - opponent->position.Y;
+        int     playerHalfHeight = opponent->height / 2;
+
+        if (ballRelPos <= playerHalfHeight && ballRelPos >= -playerHalfHeight) {
+          // Return the ball from the paddle plane
+          Real newXVelocity = randomReal(-maxXSpeed, -minXSpeed);
+          Real newYVelocity = ball.vy + ballRelPos / 4 + randomReal(Real(-0.5f), Real(0.5f));
+          clampBallVelocity(newXVelocity, newYVelocity);
+          ball.vx = newXVelocity;
+          ball.vy = newYVelocity;
+          ball.setPath(Real(width - 1), ball.y, _tickFraction);
+          events |= EVENT_PADDLE_HIT;
+        } else {
+          // add score to CPU or player 2
+          ball.setPath(Real(width - 1), ball.y, _tickFraction);
+          opponent->lostLastPoint = true;
+          player1.score += 1;
+          playNeedsReset = true;
+        }
+        break;
+      }
+      default:
+        break;
+      }
+    }
+    void finishTick() {
+      PONG_PROFILE(PHASE_SCORE);
+      // Hold play until the next serve when a point was scored
+      if (playNeedsReset) {
+        events |= EVENT_POINT_SCORED;
+        gameState = GameState::PAUSED;
+      }
+
+      // Check the score
+      checkScore();
+      if (gameState > GameState::IN_PLAY) {
+        events |= EVENT_GAME_OVER;
+      } else if (playNeedsReset && autoServe) {
+        serve();
+        start();
+      }
+    }
+    template <typename T>
+    void clampBallVelocity(T &_vx, T &_vy) const {
+      // Check if the velocities have breached their maximums or minimums, for the ball or a multi-ball float
+      T maxX = T(maxXSpeed), minX = T(minXSpeed), maxY = T(maxYSpeed);
+      if (_vx > maxX) _vx = maxX;
+      if (_vx < -maxX) _vx = -maxX;
+      if (_vx > -minX && _vx < 0) _vx = -minX;
+      if (_vx < minX && _vx > 0) _vx = minX;
+      if (_vy > maxY) _vy = maxY;
+      if (_vy < -maxY) _vy = -maxY;
+    }
+    void serveSwarmBall(uint32_t _index) {
+      // Send a multi-ball ball from the middle in a random direction
+      float vx = random.nextFloat(-float(maxXSpeed) / 2, float(maxXSpeed) / 2);
+      float vy = random.nextFloat(-float(maxYSpeed) / 3, float(maxYSpeed) / 3);
+      clampBallVelocity(vx, vy);
+      swarm.set(_index, float(width / 2), float(height / 2), vx, vy);
+    }
+    void stepSwarm() {
+      PONG_PROFILE(PHASE_BALL);
+      // Move all the balls at once against the current paddle positions
+      Player *   opponent = getOpponent();
+      SwarmField field;
+      field.width = float(width);
+      field.height = float(height);
+      field.leftPaddleY = float(player1.position.Y);
+      field.rightPaddleY = float(opponent->position.Y);
+      field.paddleHalfHeight = float(player1.height / 2);
+      field.timeScale = float(timeScale);
+      swarmStep = swarm.step(field, swarmMissed);
+
+      // Score the balls that got past and serve them again without stopping play
+      if (swarmStep.paddleHits) events |= EVENT_PADDLE_HIT;
+      if (swarmStep.wallBounces) events |= EVENT_WALL_BOUNCE;
+      if (!swarmMissed.empty()) {
+        opponent->score += int(swarmStep.leftMisses);
+        player1.score += int(swarmStep.rightMisses);
+        events |= EVENT_SCORE_CHANGED;
+        for (uint32_t index : swarmMissed) serveSwarmBall(index);
+      }
+    }
+    void movePlayer(Player &_player, int _travel) {
+      // A key held for part of the tick only moves the paddle that part of the way
+      if (_travel < 0)
+        _player.moveUp(timeScale * -_travel / Inputs::FULL_TICK, *this);
+      else if (_travel > 0)
+        _player.moveDown(timeScale * _travel / Inputs::FULL_TICK, *this);
+    }
+    void steerCpu(CpuPlayer &_cpu, Player &_paddle, bool _approaching, uint32_t _target, Real _planeX) {
+      PONG_PROFILE(PHASE_CPU);
+      // Let the CPU predict where its ball will cross the paddle plane and move the paddle towards it
+      CpuField field;
+      field.top = 3;
+      field.bottom = Real(height - 1);
+      field.planeX = _planeX;
+      field.restY = Real(height / 2);
+      field.timeScale = timeScale;
+      Real x = ball.x, y = ball.y, vx = ball.vx, vy = ball.vy;
+      if (gameMode == GameMode::MULTIBALL && _approaching) {
+        x = Real(swarm.getX(_target));
+        y = Real(swarm.getY(_target));
+        vx = Real(swarm.getXVelocity(_target));
+        vy = Real(swarm.getYVelocity(_target));
+      }
+      Real newY = _cpu.steer(_paddle.y, _approaching, _target, x, y, vx, vy, field);
+      if (newY != _paddle.y) _paddle.setYPosition(newY, *this);
+    }
+    void checkScore() {
+      if (gameMode != GameMode::IMPOSSIBLE) {
+        Player *opponent = getOpponent();
+        int     target = (gameMode == GameMode::MULTIBALL) ? multiBallWinningScore : winningScore;
+        if (player1.score >= target) {
+          gameState = GameState::PLAYER_1_WINNER;
+        } else if (opponent->score >= target) {
+          if (gameMode == GameMode::MULTIPLAYER)
+            gameState = GameState::PLAYER_2_WINNER;
+          else
+            gameState = GameState::CPU_WINNER;
+        }
+      }
+    }
+    Real randomReal(Real a, Real b) {
+      // Owned by this simulation so runs can be seeded and games in one process don't share a generator
+      return random.nextReal(a, b);
+    }
+
+   public:  // Data
+    //  Game Data
+    int       width, height;                       // The width and height of the play area
+    GameMode  gameMode = GameMode::NOT_STARTED;    // Enum to track the game mode
+    GameState gameState = GameState::NOT_STARTED;  // Enum to keep track of the play state
+    GameMode  player1Cpu = GameMode::NOT_STARTED;  // Difficulty of the CPU steering player 1, NOT_STARTED for inputs
+    bool      autoServe = false;                   // Serve and restart play straight after a point
+    int       winningScore = 5;                    // Score needed to win outside of survival mode
+    uint64_t  seedValue = 1;                       // The seed the generator was last started from
+    Random    random;                              // The simulation's random number generator
+    Real      timeScale = 1;                       // Reference ticks covered by one tick
+    uint32_t  events = EVENT_NONE;                 // Events raised during the current tick
+    bool      playNeedsReset = false;              // Set when a point was scored this tick
+
+    // Player Objects
+    Player player1;
+    Player player2;
+    Player cpu;
+
+    // CPU Players
+    CpuPlayer leftCpu;   // Steers player 1 when it isn't left to the inputs
+    CpuPlayer rightCpu;  // Steers the opponent outside of multiplayer
+
+    // Ball object
+    Ball ball;
+    Real maxXSpeed = 3;           // Maximum ball speed in x direction
+    Real minXSpeed = 2;           // Minimum ball speed in x direction
+    Real maxYSpeed = Real(1.5f);  // Maximum ball speed in y direction
+    Real minYSpeed = 0;           // Maximum ball speed in y direction
+
+    // Multi-ball
+    BallSwarm             swarm;                          // Every ball in play in multi-ball mode
+    SwarmStep             swarmStep;                      // What the swarm did on the last tick
+    std::vector<uint32_t> swarmMissed;                    // Balls that got past a paddle on the last tick
+    std::vector<float>    swarmServe;                     // Serve velocities drawn for the whole swarm at once
+    int                   multiBallCount = 8;             // Balls served in multi-ball mode
+    int                   multiBallWinningScore = 20;     // Score needed to win multi-ball
+    GameMode              multiBallCpu = GameMode::HARD;  // Difficulty of the CPU in multi-ball
+  };
+
+}  // namespace pong
+
+#endif  // PONG_SIMULATION_H
@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_SONGS_H
+#define PONG_SONGS_H
+
+#include "Audio.h"
+
+namespace pong {
+
+  // The paddle hit
+  static const Note HIT_SOUND[] = {{300, 50}};
+
+  // Played on the title screen
+  static const Note THEME_SONG[] = {{220, 300}, {294, 300}, {294, 300}, {370, 300}, {494, 300}, {370, 300}, {440, 800}};
+
+  // Played with each game mode banner
+  static const Note MULTIPLAYER_SONG[] = {{247, 300}, {330, 300}, {330, 300}, {370, 300}, {555, 300}};
+  static const Note EASY_SONG[] = {{494, 300}, {440, 300}, {392, 200}, {440, 200}, {494, 200}, {440, 800}};
+  static const Note MEDIUM_SONG[] = {{440, 300}, {494, 300}, {440, 300}, {392, 800}};
+  static const Note HARD_SONG[] = {{392, 800}, {392, 300}, {370, 300}, {278, 600}};
+  static const Note IMPOSSIBLE_SONG[] = {{494, 800}, {440, 800}, {392, 1600}};
+  static const Note MULTIBALL_SONG[] = {{330, 150}, {392, 150}, {494, 150}, {330, 150}, {392, 150}, {494, 150}, {659, 800}};
+  static const Note EXPERT_SONG[] = {{330, 200}, {440, 200}, {554, 200}, {659, 400}, {554, 200}, {659, 1200}};
+
+  // Played with the winner screen
+  static const Note WINNING_SONG[] = {{440, 300}, {494, 300}, {440, 300}, {370, 300}, {392, 300}, {370, 300}, {330, 800}};
+  static const Note LOSING_SONG[] = {{392, 300}, {370, 300}, {247, 1600}};
+
+}  // namespace pong
+
+#endif  // PONG_SONGS_H
@@ -0,0 +1,486 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_SPECTATOR_H
+#define PONG_SPECTATOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Simulation.h"
+
+// The spectator stream is a series of messages, each uint8(type) uint8(size) then size bytes:
+//
+//   SPECTATE_KEYFRAME  varint(tick) varint(width) varint(height) zigzag[SPECTATE_FIELDS]   the whole frame
+//   SPECTATE_DELTA     varint(ticks since the last frame) uint8(changed fields) zigzag[]    what changed, in field order
+//
+// Positions are sent in 64ths of a cell. A viewer starts at the first keyframe and applies deltas from there.
+
+namespace pong {
+
+  enum SpectateMessage : uint8_t {
+    SPECTATE_KEYFRAME = 1,
+    SPECTATE_DELTA = 2
+  };
+
+  // What a viewer sees, in the order the fields are sent
+  enum SpectateField {
+    FIELD_BALL_X = 0,
+    FIELD_BALL_Y,
+    FIELD_PLAYER_1_Y,
+    FIELD_OPPONENT_Y,
+    FIELD_PLAYER_1_SCORE,
+    FIELD_OPPONENT_SCORE,
+    FIELD_GAME_STATE,
+    FIELD_GAME_MODE,
+    SPECTATE_FIELDS
+  };
+
+  // One tick of a match as spectators see it
+  struct SpectatorFrame {
+    static const int POSITION_SCALE = 64;  // Positions are sent in 1/64ths of a cell
+
+    uint32_t tick = 0;                      // Ticks since the stream started
+    int32_t  width = 0, height = 0;         // The play area
+    int32_t  values[SPECTATE_FIELDS] = {};  // Every field, positions scaled by POSITION_SCALE
+
+    static SpectatorFrame capture(const Simulation &_sim, uint32_t _tick) {
+      SpectatorFrame frame;
+      frame.tick = _tick;
+      frame.width = _sim.width;
+      frame.height = _sim.height;
+      frame.values[FIELD_BALL_X] = scale(float(_sim.ball.getX()));
+      frame.values[FIELD_BALL_Y] = scale(float(_sim.ball.getY()));
+      frame.values[FIELD_PLAYER_1_Y] = scale(float(_sim.player1.getY()));
+      frame.values[FIELD_OPPONENT_Y] = scale(float(_sim.getOpponent()->getY()));
+      frame.values[FIELD_PLAYER_1_SCORE] = _sim.player1.getScore();
+      frame.values[FIELD_OPPONENT_SCORE] = _sim.getOpponent()->getScore();
+      frame.values[FIELD_GAME_STATE] = int32_t(_sim.gameState);
+      frame.values[FIELD_GAME_MODE] = int32_t(_sim.gameMode);
+      return frame;
+    }
+    float position(SpectateField _field) const {
+      return float(values[_field]) / POSITION_SCALE;
+    }
+    static int32_t scale(float _position) {
+      return int32_t(_position * POSITION_SCALE);
+    }
+  };
+
+  // Turns each tick into a keyframe and a delta once, however many viewers there are
+  class SpectatorEncoder {
+   public:  // Encoding
+    void encode(const SpectatorFrame &_frame) {
+      keyframe.clear();
+      keyframe.push_back(char(SPECTATE_KEYFRAME));
+      keyframe.push_back(0);
+      putVarint(keyframe, _frame.tick);
+      putVarint(keyframe, uint32_t(_frame.width));
+      putVarint(keyframe, uint32_t(_frame.height));
+      for (int i = 0; i < SPECTATE_FIELDS; i++) putVarint(keyframe, zigzag(_frame.values[i]));
+      keyframe[1] = char(keyframe.size() - 2);
+
+      // The delta is only good for viewers that have the previous frame
+      delta.clear();
+      delta.push_back(char(SPECTATE_DELTA));
+      delta.push_back(0);
+      putVarint(delta, _frame.tick - previous.tick);
+      delta.push_back(0);
+      uint8_t changed = 0;
+      for (int i = 0; i < SPECTATE_FIELDS; i++) {
+        if (_frame.values[i] == previous.values[i]) continue;
+        changed |= uint8_t(1 << i);
+        putVarint(delta, zigzag(_frame.values[i] - previous.values[i]));
+      }
+      delta[2 + varintSize(_frame.tick - previous.tick)] = char(changed);
+      delta[1] = char(delta.size() - 2);
+      previous = _frame;
+    }
+    const std::string &getKeyframe() const {
+      return keyframe;
+    }
+    const std::string &getDelta() const {
+      return delta;
+    }
+
+   public:  // Varints
+    static void putVarint(std::string &_out, uint32_t _value) {
+      while (_value >= 0x80) {
+        _out.push_back(char(_value | 0x80));
+        _value >>= 7;
+      }
+      _out.push_back(char(_value));
+    }
+    static size_t varintSize(uint32_t _value) {
+      size_t size = 1;
+      while (_value >= 0x80) {
+        _value >>= 7;
+        size++;
+      }
+      return size;
+    }
+    static uint32_t zigzag(int32_t _value) {
+      return (uint32_t(_value) << 1) ^ uint32_t(-int32_t(uint32_t(_value) >> 31));
+    }
+
+   private:  // Data
+    SpectatorFrame previous;  // The frame the delta is from
+    std::string    keyframe;  // The last frame on its own
+    std::string    delta;     // The last frame as changes from the one before
+  };
+
+  // Rebuilds frames from the stream, skipping deltas until the first keyframe
+  class SpectatorDecoder {
+   public:  // Decoding
+    void feed(const uint8_t *_data, size_t _size) {
+      // Drop what's been read before adding more so the buffer stays a message or two long
+      buffer.erase(buffer.begin(), buffer.begin() + ptrdiff_t(cursor));
+      cursor = 0;
+      buffer.insert(buffer.end(), _data, _data + _size);
+    }
+    bool next(SpectatorFrame &_frame) {
+      // Apply every whole message waiting, returns true with the newest frame when any changed it
+      bool updated = false;
+      while (buffer.size() - cursor >= 2 && buffer.size() - cursor >= size_t(2) + buffer[cursor + 1]) {
+        const uint8_t *message = &buffer[cursor + 2];
+        const uint8_t *end = message + buffer[cursor + 1];
+        uint8_t        type = buffer[cursor];
+        cursor += 2 + buffer[cursor + 1];
+        if (type == SPECTATE_KEYFRAME) {
+          SpectatorFrame frame;
+          uint32_t       width, height;
+          bool           ok = getVarint(message, end, frame.tick) && getVarint(message, end, width) && getVarint(message, end, height);
+          frame.width = int32_t(width);
+          frame.height = int32_t(height);
+          for (int i = 0; ok && i < SPECTATE_FIELDS; i++) ok = getZigzag(message, end, frame.values[i]);
+          if (!ok) continue;
+          current = frame;
+          synced = updated = true;
+          keyframes++;
+        } else if (type == SPECTATE_DELTA && synced) {
+          uint32_t ticks;
+          if (!getVarint(message, end, ticks) || message >= end) continue;
+          uint8_t changed = *message++;
+          current.tick += ticks;
+          for (int i = 0; i < SPECTATE_FIELDS; i++) {
+            int32_t change;
+            if ((changed & (1 << i)) && getZigzag(message, end, change)) current.values[i] += change;
+          }
+          updated = true;
+        }
+      }
+      if (updated) _frame = current;
+      return updated;
+    }
+    uint64_t getKeyframeCount() const {
+      return keyframes;
+    }
+
+   private:  // Helpers
+    static bool getVarint(const uint8_t *&_in, const uint8_t *_end, uint32_t &_value) {
+      _value = 0;
+      for (int shift = 0; shift < 35 && _in < _end; shift += 7) {
+        uint8_t byte = *_in++;
+        _value |= uint32_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+      }
+      return false;
+    }
+    static bool getZigzag(const uint8_t *&_in, const uint8_t *_end, int32_t &_value) {
+      uint32_t raw;
+      if (!getVarint(_in, _end, raw)) return false;
+      _value = int32_t(raw >> 1) ^ -int32_t(raw & 1);
+      return true;
+    }
+
+   private:  // Data
+    std::vector<uint8_t> buffer;          // Bytes received and not yet decoded
+    size_t               cursor = 0;      // Where the next message starts in buffer
+    SpectatorFrame       current;         // The frame as of the last message
+    bool                 synced = false;  // A keyframe has been seen
+    uint64_t             keyframes = 0;   // Keyframes decoded
+  };
+
+#ifdef __linux__
+  // How the broadcast is going
+  struct SpectatorStats {
+    uint64_t ticks = 0;            // Frames published
+    uint64_t fanoutNs = 0;         // Time spent encoding and handing frames to every client
+    uint64_t lastFanoutNs = 0;     // Time the last frame took
+    uint64_t bytesSent = 0;        // Bytes written to clients
+    uint64_t keyframesSent = 0;    // Keyframes queued, one per new client or resync
+    uint64_t resyncs = 0;          // Times a slow client's backlog was dropped for the latest keyframe
+    uint64_t clientsAccepted = 0;  // Viewers that connected
+    uint64_t clientsClosed = 0;    // Viewers that went away
+  };
+
+  // Streams a match to any number of terminal viewers over TCP or a Unix socket with one epoll loop. Every tick is
+  // encoded once and the same bytes go to every viewer, a viewer that falls too far behind loses its backlog and
+  // picks up again from the next frame's keyframe.
+  class SpectatorServer {
+   public:  // Constants
+    static const size_t MAX_PENDING_BYTES = 1024;  // Backlog after which a viewer skips to the latest keyframe
+    static const int    SEND_BUFFER_BYTES = 4096;  // Kernel buffer per viewer, small so a stalled viewer backs up here
+    static const int    MAX_EVENTS = 256;          // Events handled per epoll_wait
+
+   public:  // Constructor
+    SpectatorServer() {}
+    ~SpectatorServer() {
+      close();
+    }
+    SpectatorServer(const SpectatorServer &) = delete;
+    SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+   public:  // Listening
+    bool listenTcp(uint16_t _port) {
+      // Listen on every interface, 0 picks any free port
+      int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd < 0) return false;
+      int reuse = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      sockaddr_in address;
+      memset(&address, 0, sizeof(address));
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_ANY);
+      address.sin_port = htons(_port);
+      if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) return ::close(fd), false;
+      socklen_t length = sizeof(address);
+      getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+      tcpPort = ntohs(address.sin_port);
+      return addListener(fd, true);
+    }
+    bool listenUnix(const char *_path) {
+      int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd < 0) return false;
+      sockaddr_un address;
+      memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      if (strlen(_path) >= sizeof(address.sun_path)) return ::close(fd), false;
+      strcpy(address.sun_path, _path);
+      unlink(_path);
+      if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) return ::close(fd), false;
+      unixPath = _path;
+      return addListener(fd, false);
+    }
+    void close() {
+      for (std::unique_ptr<Client> &client : clients) ::close(client->fd);
+      clients.clear();
+      if (epoll >= 0) ::close(epoll);
+      epoll = -1;
+      if (!unixPath.empty()) unlink(unixPath.c_str());
+      unixPath.clear();
+      tcpPort = 0;
+    }
+
+   public:  // Broadcasting
+    void publish(const Simulation &_sim) {
+      // Encode the tick once, then queue it for every viewer and write what the sockets will take straight away
+      auto startTime = std::chrono::steady_clock::now();
+      encoder.encode(SpectatorFrame::capture(_sim, tick++));
+      for (size_t i = 0; i < clients.size();) {
+        Client &client = *clients[i];
+        if (client.listener || send(client)) {
+          i++;
+        } else {
+          drop(i);
+        }
+      }
+      uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+      stats.ticks++;
+      stats.fanoutNs += ns;
+      stats.lastFanoutNs = ns;
+    }
+    void service(int _timeoutMs = 0) {
+      // Take new viewers, finish writing to slow ones and notice the ones that left
+      if (epoll < 0) return;
+      epoll_event events[MAX_EVENTS];
+      int         count = epoll_wait(epoll, events, MAX_EVENTS, _timeoutMs);
+      for (int e = 0; e < count; e++) {
+        Client *client = static_cast<Client *>(events[e].data.ptr);
+        if (client->listener) {
+          accept(*client);
+          continue;
+        }
+        bool open = true;
+        if (events[e].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) open = false;
+        if (open && (events[e].events & EPOLLIN)) open = discardInput(*client);
+        if (open && (events[e].events & EPOLLOUT)) open = flush(*client);
+        if (!open) drop(client->slot);
+      }
+    }
+
+   public:  // Accessors
+    uint16_t getTcpPort() const {
+      return tcpPort;
+    }
+    size_t getClientCount() const {
+      return clients.size() - listeners;
+    }
+    const SpectatorStats &getStats() const {
+      return stats;
+    }
+
+   private:  // Clients
+    struct Client {
+      int                  fd = -1;               // The socket
+      size_t               slot = 0;              // Where the client is in clients
+      bool                 listener = false;      // Accepts viewers rather than being one
+      bool                 tcp = false;           // Listens for TCP rather than on a Unix socket
+      bool                 needsKeyframe = true;  // Deltas are no use until the viewer has a whole frame
+      bool                 watchingOut = false;   // Waiting for the socket to take more
+      std::vector<uint8_t> pending;               // Bytes queued, always starting at a message boundary
+      size_t               sent = 0;              // Bytes of the first queued message already written
+    };
+
+    bool addListener(int _fd, bool _tcp) {
+      if (listen(_fd, SOMAXCONN) != 0 || !ensureEpoll()) return ::close(_fd), false;
+      std::unique_ptr<Client> client(new Client());
+      client->fd = _fd;
+      client->listener = true;
+      client->tcp = _tcp;
+      if (!watch(*client, EPOLL_CTL_ADD, EPOLLIN)) return ::close(_fd), false;
+      client->slot = clients.size();
+      clients.push_back(std::move(client));
+      listeners++;
+      return true;
+    }
+    void accept(Client &_listener) {
+      for (;;) {
+        int fd = accept4(_listener.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        // Frames the kernel holds can't be skipped, so let it hold few and keep the backlog where it can be dropped
+        int sendBuffer = SEND_BUFFER_BYTES;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+        if (_listener.tcp) {
+          int noDelay = 1;
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        }
+        std::unique_ptr<Client> client(new Client());
+        client->fd = fd;
+        if (!watch(*client, EPOLL_CTL_ADD, EPOLLIN | EPOLLRDHUP)) {
+          ::close(fd);
+          continue;
+        }
+        client->slot = clients.size();
+        clients.push_back(std::move(client));
+        stats.clientsAccepted++;
+      }
+    }
+    bool send(Client &_client) {
+      // Drop the backlog of a viewer that can't keep up, keeping the message half written so the stream stays whole
+      if (_client.pending.size() - _client.sent > MAX_PENDING_BYTES) {
+        _client.pending.resize(_client.sent ? messageEnd(_client.pending, 0) : 0);
+        _client.needsKeyframe = true;
+        stats.resyncs++;
+      }
+      const std::string &message = _client.needsKeyframe ? encoder.getKeyframe() : encoder.getDelta();
+      if (_client.needsKeyframe) stats.keyframesSent++;
+      _client.needsKeyframe = false;
+      _client.pending.insert(_client.pending.end(), message.begin(), message.end());
+      return flush(_client);
+    }
+    bool flush(Client &_client) {
+      // Write as much as the socket takes, then watch for room only while something is left
+      while (_client.sent < _client.pending.size()) {
+        ssize_t written = ::send(_client.fd, &_client.pending[_client.sent], _client.pending.size() - _client.sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written < 0) {
+          if (errno == EINTR) continue;
+          if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+          break;
+        }
+        _client.sent += size_t(written);
+        stats.bytesSent += uint64_t(written);
+      }
+
+      // Forget the whole messages already written so the queue starts at the one in progress
+      size_t start = 0;
+      while (start < _client.pending.size() && messageEnd(_client.pending, start) <= _client.sent) start = messageEnd(_client.pending, start);
+      if (start == _client.pending.size()) {
+        _client.pending.clear();
+        _client.sent = 0;
+      } else if (start) {
+        _client.pending.erase(_client.pending.begin(), _client.pending.begin() + ptrdiff_t(start));
+        _client.sent -= start;
+      }
+
+      bool waiting = !_client.pending.empty();
+      if (waiting != _client.watchingOut) {
+        if (!watch(_client, EPOLL_CTL_MOD, EPOLLIN | EPOLLRDHUP | (waiting ? uint32_t(EPOLLOUT) : 0u))) return false;
+        _client.watchingOut = waiting;
+      }
+      return true;
+    }
+    bool discardInput(Client &_client) {
+      // Viewers have nothing to say, reading only tells when they've gone
+      char buffer[256];
+      for (;;) {
+        ssize_t size = recv(_client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (size > 0) continue;
+        if (size == 0) return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+      }
+    }
+    void drop(size_t _slot) {
+      ::close(clients[_slot]->fd);
+      clients[_slot] = std::move(clients.back());
+      clients[_slot]->slot = _slot;
+      clients.pop_back();
+      stats.clientsClosed++;
+    }
+    bool ensureEpoll() {
+      if (epoll < 0) epoll = epoll_create1(EPOLL_CLOEXEC);
+      return epoll >= 0;
+    }
+    bool watch(Client &_client, int _operation, uint32_t _events) {
+      epoll_event event;
+      event.events = _events;
+      event.data.ptr = &_client;
+      return epoll_ctl(epoll, _operation, _client.fd, &event) == 0;
+    }
+    static size_t messageEnd(const std::vector<uint8_t> &_bytes, size_t _start) {
+      return _start + 2 + _bytes[_start + 1];
+    }
+
+   private:  // Data
+    int                                  epoll = -1;     // The event loop
+    std::vector<std::unique_ptr<Client>> clients;        // Listeners and viewers
+    size_t                               listeners = 0;  // Listeners among clients
+    uint16_t                             tcpPort = 0;    // The TCP port listened on, 0 for none
+    std::string                          unixPath;       // The Unix socket listened on, empty for none
+    SpectatorEncoder                     encoder;        // The current tick, encoded once for everyone
+    uint32_t                             tick = 0;       // Frames published
+    SpectatorStats                       stats;          // How the broadcast is going
+  };
+#endif
+
+}  // namespace pong
+
+#endif  // PONG_SPECTATOR_H
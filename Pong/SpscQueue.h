@@ -0,0 +1,76 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_SPSC_QUEUE_H
+#define PONG_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace pong {
+
+  // A fixed size lock-free queue for exactly one producer thread and one consumer thread
+  template <typename T, size_t Capacity>
+  class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+   public:  // Producer
+    bool push(const T &_item) {
+      size_t tail = tailIndex.load(std::memory_order_relaxed);
+      if (tail - headCache == Capacity) {
+        // Only look at the consumer's index when the cached one says we're full
+        headCache = headIndex.load(std::memory_order_acquire);
+        if (tail - headCache == Capacity) return false;
+      }
+      items[tail & (Capacity - 1)] = _item;
+      tailIndex.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+   public:  // Consumer
+    bool pop(T &_item) {
+      size_t head = headIndex.load(std::memory_order_relaxed);
+      if (head == tailCache) {
+        // Only look at the producer's index when the cached one says we're empty
+        tailCache = tailIndex.load(std::memory_order_acquire);
+        if (head == tailCache) return false;
+      }
+      _item = items[head & (Capacity - 1)];
+      headIndex.store(head + 1, std::memory_order_release);
+      return true;
+    }
+    bool peek(T &_item) {
+      size_t head = headIndex.load(std::memory_order_relaxed);
+      if (head == tailIndex.load(std::memory_order_acquire)) return false;
+      _item = items[head & (Capacity - 1)];
+      return true;
+    }
+
+   public:  // Accessors
+    size_t size() const {
+      return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+    }
+
+   private:  // Data
+    // The indices only ever increase and sit on their own cache lines so the threads don't fight over them
+    alignas(64) std::atomic<size_t> headIndex{0};  // Next item to pop, written by the consumer
+    size_t tailCache = 0;                          // Consumer's last view of tailIndex
+    alignas(64) std::atomic<size_t> tailIndex{0};  // Next free slot, written by the producer
+    size_t headCache = 0;                          // Producer's last view of headIndex
+    alignas(64) T items[Capacity];                 // The ring of items
+  };
+
+}  // namespace pong
+
+#endif  // PONG_SPSC_QUEUE_H
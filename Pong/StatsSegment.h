@@ -0,0 +1,222 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_STATS_SEGMENT_H
+#define PONG_STATS_SEGMENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pong {
+
+  // The game's health as a monitor sees it, published every few frames
+  struct GameStats {
+    uint64_t updatedAtMs = 0;          // Wall clock time of the publish, in ms since the epoch
+    uint64_t ticks = 0;                // Physics ticks played
+    uint64_t frames = 0;               // Frames drawn
+    uint64_t rallies = 0;              // Rallies played out to a point
+    uint64_t paddleHits = 0;           // Balls returned by a paddle
+    uint64_t renderBytes = 0;          // Bytes written to the terminal
+    float    frameP50Ms = 0;           // Median of the recent frame times
+    float    frameP99Ms = 0;           // 99th percentile of the recent frame times
+    float    frameMaxMs = 0;           // Longest of the recent frame times
+    float    renderBytesPerFrame = 0;  // Bytes written per frame shown since the last publish
+    float    inputEventsPerSec = 0;    // Key events read per second since the last publish
+    int32_t  gameMode = -1;            // The GameMode being played
+    int32_t  gameState = -1;           // The GameState of play
+    int32_t  player1Score = 0;         // Player 1's score
+    int32_t  player2Score = 0;         // Player 2's score
+    int32_t  cpuScore = 0;             // The CPU's score
+    int32_t  survivalBest = 0;         // Most returns in one game of survival
+    int32_t  longestRally = 0;         // Most paddle hits in one rally
+    uint32_t processId = 0;            // The game publishing
+    uint32_t running = 0;              // 1 while the game is running, 0 once it has closed
+  };
+  static_assert(std::is_trivially_copyable<GameStats>::value && sizeof(GameStats) % 8 == 0,
+                "GameStats is copied through the segment a word at a time");
+
+  // GameStats in a memory mapped file, written by the game and read by any number of monitors in other processes.
+  // It's a seqlock: the writer makes the sequence odd, stores the record a word at a time and makes it even again.
+  // A reader copies the words between two reads of the sequence and tries again if it changed. The writer never
+  // waits for or even knows about the readers, so watching the game can't slow it down.
+  class StatsSegment {
+   public:  // Constants
+    static const uint32_t VERSION = 1;  // Bumped whenever GameStats changes
+    static const size_t   WORDS = sizeof(GameStats) / sizeof(uint64_t);
+
+   public:  // Constructor
+    StatsSegment() {}
+    ~StatsSegment() {
+      close();
+    }
+    StatsSegment(const StatsSegment &) = delete;
+    StatsSegment &operator=(const StatsSegment &) = delete;
+
+   public:  // Opening
+    bool create(const char *_path) {
+      // Make the segment and take the writer's side of it, there should only ever be one writer
+      close();
+      if (!map(_path, true)) return false;
+      layout = new (data) Layout();
+      memcpy(layout->magic, "PONGSTA1", 8);
+      layout->version = VERSION;
+      layout->recordSize = uint32_t(sizeof(GameStats));
+      writable = true;
+      return true;
+    }
+    bool open(const char *_path) {
+      // Map a segment another process is writing to read from it
+      close();
+      if (!map(_path, false)) return false;
+      layout = reinterpret_cast<Layout *>(data);
+      if (memcmp(layout->magic, "PONGSTA1", 8) != 0 || layout->version != VERSION || layout->recordSize != sizeof(GameStats))
+        return close(), false;
+      return true;
+    }
+    void close() {
+      unmap();
+      layout = NULL;
+      writable = false;
+    }
+    bool isOpen() const {
+      return layout != NULL;
+    }
+
+   public:  // Writer
+    static uint32_t processId() {
+      // Put in GameStats so a monitor can tell which game it's watching
+#ifdef _WIN32
+      return uint32_t(GetCurrentProcessId());
+#else
+      return uint32_t(getpid());
+#endif
+    }
+    void publish(const GameStats &_stats) {
+      if (!writable) return;
+      uint64_t words[WORDS];
+      memcpy(words, &_stats, sizeof(words));
+
+      // Odd while the words are being stored, the fence keeps the stores from being seen before it
+      uint64_t sequence = layout->sequence.load(std::memory_order_relaxed);
+      layout->sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (size_t i = 0; i < WORDS; i++) layout->words[i].store(words[i], std::memory_order_relaxed);
+      layout->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+   public:  // Readers
+    bool read(GameStats *_stats, int _attempts = 64) const {
+      // A consistent copy of the last publish, false if the writer kept getting in the way or nothing was published
+      if (!layout) return false;
+      for (int attempt = 0; attempt < _attempts; attempt++) {
+        uint64_t before = layout->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        uint64_t words[WORDS];
+        for (size_t i = 0; i < WORDS; i++) words[i] = layout->words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (layout->sequence.load(std::memory_order_relaxed) != before) continue;
+        if (before == 0) return false;
+        memcpy(_stats, words, sizeof(words));
+        return true;
+      }
+      return false;
+    }
+    uint64_t getPublishCount() const {
+      return layout ? layout->sequence.load(std::memory_order_relaxed) / 2 : 0;
+    }
+
+   private:  // Types
+    struct Layout {
+      char                  magic[8] = {};      // PONGSTA1
+      uint32_t              version = 0;        // VERSION of the writer
+      uint32_t              recordSize = 0;     // sizeof(GameStats) of the writer
+      std::atomic<uint64_t> sequence{0};        // Publishes times two, odd while one is in progress
+      std::atomic<uint64_t> words[WORDS] = {};  // The record
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The segment is shared between processes, so its atomics can't use locks");
+
+   private:  // Mapping
+#ifdef _WIN32
+    bool map(const char *_path, bool _writable) {
+      DWORD access = _writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+      fileHandle = CreateFileA(_path, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                               _writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+      if (fileHandle == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER fileSize;
+      if (!_writable && (!GetFileSizeEx(fileHandle, &fileSize) || uint64_t(fileSize.QuadPart) < sizeof(Layout))) return unmap(), false;
+      mapping = CreateFileMappingA(fileHandle, NULL, _writable ? PAGE_READWRITE : PAGE_READONLY, 0, DWORD(sizeof(Layout)), NULL);
+      if (!mapping) return unmap(), false;
+      data = MapViewOfFile(mapping, _writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, sizeof(Layout));
+      if (!data) return unmap(), false;
+      return true;
+    }
+    void unmap() {
+      if (data) UnmapViewOfFile(data);
+      if (mapping) CloseHandle(mapping);
+      if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+      data = NULL;
+      mapping = NULL;
+      fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    bool map(const char *_path, bool _writable) {
+      // The writer starts a fresh file so a reader of the old one can't see it change size under it
+      if (_writable) ::unlink(_path);
+      int fd = _writable ? ::open(_path, O_RDWR | O_CREAT | O_EXCL, 0644) : ::open(_path, O_RDONLY);
+      if (fd < 0) return false;
+      struct stat info;
+      bool        sized = _writable ? ftruncate(fd, off_t(sizeof(Layout))) == 0
+                                    : fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(Layout);
+      if (!sized) {
+        ::close(fd);
+        return false;
+      }
+      void *mapped = mmap(NULL, sizeof(Layout), _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (mapped == MAP_FAILED) return false;
+      data = mapped;
+      return true;
+    }
+    void unmap() {
+      if (data) munmap(data, sizeof(Layout));
+      data = NULL;
+    }
+#endif
+
+   private:  // Data
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;  // The open segment
+    HANDLE mapping = NULL;                     // Its file mapping
+#endif
+    void *  data = NULL;       // The mapped segment
+    Layout *layout = NULL;     // The segment's contents
+    bool    writable = false;  // This side publishes
+  };
+
+}  // namespace pong
+
+#endif  // PONG_STATS_SEGMENT_H
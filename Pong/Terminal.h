@@ -0,0 +1,291 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_TERMINAL_H
+#define PONG_TERMINAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+namespace pong {
+
+  // What showing frames has cost in calls to the operating system
+  struct TerminalStats {
+    uint64_t frames = 0;             // Frames presented
+    uint64_t syscalls = 0;           // Output calls made for all frames
+    uint64_t bytes = 0;              // Bytes written for all frames
+    uint64_t resizes = 0;            // Times the terminal changed size
+    size_t   syscallsLastFrame = 0;  // Output calls made for the last frame
+  };
+
+  // Where the frames the Screen renders end up. Frames are VT sequences and each one goes out in as few calls as the
+  // platform allows, normally one.
+  class Terminal {
+   public:  // Constructor
+    virtual ~Terminal() {}
+
+   public:  // Setup
+    virtual bool open(int _width, int _height) = 0;  // Take over the terminal for a game of this size
+    virtual void close() = 0;                        // Give the terminal back as it was
+
+   public:  // Output
+    virtual void present(const std::string &_frame) = 0;
+    virtual void setTitle(const char *_title) = 0;
+
+   public:  // State
+    virtual bool isFocused() {
+      // Whether keys typed now are meant for the game
+      return true;
+    }
+    virtual bool takeResize(int *_columns, int *_rows) {
+      // True once after the terminal changes size, with the new size
+      (void)_columns;
+      (void)_rows;
+      return false;
+    }
+    const TerminalStats &getStats() const {
+      return stats;
+    }
+
+   protected:  // Data
+    TerminalStats stats;  // Output calls made so far
+  };
+
+#ifdef _WIN32
+  // The Windows console with VT processing turned on
+  class ConsoleTerminal : public Terminal {
+   public:  // Setup
+    virtual bool open(int _width, int _height) override {
+      // Size the window and its buffer to the game
+      console = GetStdHandle(STD_OUTPUT_HANDLE);
+      SMALL_RECT consoleRectangle = {short(0), short(0), short(_width), short(_height)};
+      SetConsoleWindowInfo(console, TRUE, &consoleRectangle);
+      COORD consoleSize;
+      consoleSize.X = short(_width);
+      consoleSize.Y = short(_height);
+      SetConsoleScreenBufferSize(console, consoleSize);
+
+      // Let the console interpret the VT sequences the frame renderer emits
+      DWORD consoleMode = 0;
+      GetConsoleMode(console, &consoleMode);
+      SetConsoleMode(console, consoleMode | ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+
+      // Hide the cursor for the whole game
+      CONSOLE_CURSOR_INFO cursor;
+      cursor.dwSize = 10;
+      cursor.bVisible = false;
+      SetConsoleCursorInfo(console, &cursor);
+
+      // Keys only count while this window is in front
+      windowsHandle = GetForegroundWindow();
+      return console != INVALID_HANDLE_VALUE;
+    }
+    virtual void close() override {
+      FreeConsole();
+    }
+
+   public:  // Output
+    virtual void present(const std::string &_frame) override {
+      stats.frames++;
+      stats.syscallsLastFrame = 0;
+      if (_frame.empty()) return;
+      DWORD written = 0;
+      WriteConsoleA(console, _frame.data(), DWORD(_frame.size()), &written, NULL);
+      stats.syscallsLastFrame = 1;
+      stats.syscalls++;
+      stats.bytes += written;
+    }
+    virtual void setTitle(const char *_title) override {
+      SetConsoleTitle(_title);
+    }
+
+   public:  // State
+    virtual bool isFocused() override {
+      return GetForegroundWindow() == windowsHandle;
+    }
+
+   private:  // Data
+    HANDLE console = NULL;        // The console's output
+    HWND   windowsHandle = NULL;  // The console window
+  };
+#else
+  // A VT terminal on stdout, in raw mode on the alternate screen. Every frame is one writev and a resize is noticed
+  // through SIGWINCH.
+  class PosixTerminal : public Terminal {
+   public:  // Constructor
+    ~PosixTerminal() {
+      close();
+    }
+
+   public:  // Setup
+    virtual bool open(int _width, int _height) override {
+      (void)_width;
+      (void)_height;
+      if (opened) return true;
+      if (!isatty(STDOUT_FILENO)) return false;
+
+      // Raw input so keys arrive as they're pressed and aren't echoed, Ctrl+C still interrupts
+      if (tcgetattr(STDIN_FILENO, &originalMode()) == 0) {
+        struct termios raw = originalMode();
+        raw.c_iflag &= ~(IXON | ICRNL);
+        raw.c_lflag &= ~(ICANON | ECHO | IEXTEN);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        hasMode() = true;
+      }
+
+      // Put things back however the game ends, and hear about size changes
+      struct sigaction action = {};
+      action.sa_handler = onSignal;
+      sigemptyset(&action.sa_mask);
+      sigaction(SIGINT, &action, NULL);
+      sigaction(SIGTERM, &action, NULL);
+      action.sa_handler = onResize;
+      sigaction(SIGWINCH, &action, NULL);
+
+      // Draw on the alternate screen with no cursor, starting from a clear one
+      opened = true;
+      pending += "\x1b[?1049h\x1b[?25l\x1b[2J";
+      return true;
+    }
+    virtual void close() override {
+      if (!opened) return;
+      opened = false;
+      signal(SIGWINCH, SIG_DFL);
+      signal(SIGINT, SIG_DFL);
+      signal(SIGTERM, SIG_DFL);
+      restore();
+    }
+
+   public:  // Output
+    virtual void present(const std::string &_frame) override {
+      // Anything queued since the last frame goes out in the same call as the frame
+      struct iovec parts[2] = {{const_cast<char *>(pending.data()), pending.size()}, {const_cast<char *>(_frame.data()), _frame.size()}};
+      stats.frames++;
+      stats.syscallsLastFrame = 0;
+      writeAll(parts, 2);
+      pending.clear();
+    }
+    virtual void setTitle(const char *_title) override {
+      // OSC 0 sets the window title, sent with the next frame
+      pending += "\x1b]0;";
+      pending += _title;
+      pending += '\x07';
+    }
+
+   public:  // State
+    virtual bool takeResize(int *_columns, int *_rows) override {
+      if (!resized()) return false;
+      resized() = 0;
+      struct winsize size;
+      if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0) return false;
+      *_columns = size.ws_col;
+      *_rows = size.ws_row;
+      stats.resizes++;
+
+      // Whatever was on screen is in the wrong place now, start again from a clear one
+      pending += "\x1b[2J";
+      return true;
+    }
+    bool getSize(int *_columns, int *_rows) const {
+      struct winsize size;
+      if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0) return false;
+      *_columns = size.ws_col;
+      *_rows = size.ws_row;
+      return true;
+    }
+
+   private:  // Helpers
+    void writeAll(struct iovec *_parts, int _count) {
+      // Usually a single writev, a slow terminal can take a frame in pieces
+      for (;;) {
+        while (_count > 0 && _parts[0].iov_len == 0) {
+          _parts++;
+          _count--;
+        }
+        if (_count == 0) return;
+        ssize_t written = writev(STDOUT_FILENO, _parts, _count);
+        stats.syscalls++;
+        stats.syscallsLastFrame++;
+        if (written < 0) {
+          if (errno == EINTR || errno == EAGAIN) continue;
+          return;
+        }
+        stats.bytes += uint64_t(written);
+
+        // Step over what went out, the first part left may be half written
+        size_t left = size_t(written);
+        for (; _count > 0 && left >= _parts[0].iov_len; _parts++, _count--) left -= _parts[0].iov_len;
+        if (_count > 0) {
+          _parts[0].iov_base = static_cast<char *>(_parts[0].iov_base) + left;
+          _parts[0].iov_len -= left;
+        }
+      }
+    }
+    static void restore() {
+      // Only async signal safe calls, this also runs from the signal handler
+      static const char reset[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+      ssize_t           ignored = write(STDOUT_FILENO, reset, sizeof(reset) - 1);
+      (void)ignored;
+      if (hasMode()) tcsetattr(STDIN_FILENO, TCSANOW, &originalMode());
+    }
+    static void onSignal(int _signal) {
+      restore();
+      signal(_signal, SIG_DFL);
+      raise(_signal);
+    }
+    static void onResize(int) {
+      resized() = 1;
+    }
+
+    // Shared with the signal handlers, there is only one terminal
+    static struct termios &originalMode() {
+      static struct termios mode;
+      return mode;
+    }
+    static bool &hasMode() {
+      static bool has = false;
+      return has;
+    }
+    static volatile sig_atomic_t &resized() {
+      static volatile sig_atomic_t flag = 0;
+      return flag;
+    }
+
+   private:  // Data
+    bool        opened = false;  // The terminal is in raw mode on the alternate screen
+    std::string pending;         // Sequences to send ahead of the next frame
+  };
+#endif
+
+}  // namespace pong
+
+#endif  // PONG_TERMINAL_H
@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_THREAD_POOL_H
+#define PONG_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pong {
+
+  // A fixed set of worker threads that split a range of indices between them and the calling thread
+  class ThreadPool {
+   public:  // Constructor
+    explicit ThreadPool(size_t _threads = 0) {
+      // Zero means one thread per core, the calling thread counts as one of them
+      if (_threads == 0) _threads = std::thread::hardware_concurrency();
+      if (_threads == 0) _threads = 1;
+      for (size_t i = 1; i < _threads; i++) workers.emplace_back([this] { run(); });
+    }
+    ~ThreadPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      wake.notify_all();
+      for (std::thread &worker : workers) worker.join();
+    }
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+   public:  // Accessors
+    size_t getThreadCount() const {
+      return workers.size() + 1;
+    }
+
+   public:  // Work
+    template <typename Body>
+    void parallelFor(size_t _count, size_t _grain, Body &&_body) {
+      // Call _body(begin, end) over [0, _count) in chunks of at least _grain and return once every chunk is done.
+      // The body is called through a plain function pointer so a job costs no allocation.
+      if (_grain == 0) _grain = 1;
+      size_t chunks = (_count + _grain - 1) / _grain;
+      if (chunks > getThreadCount()) chunks = getThreadCount();
+      if (chunks <= 1) {
+        if (_count > 0) _body(size_t(0), _count);
+        return;
+      }
+
+      uint64_t jobGeneration;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        job.body = &_body;
+        job.call = [](void *_context, size_t _begin, size_t _end) { (*static_cast<Body *>(_context))(_begin, _end); };
+        job.count = _count;
+        job.chunks = chunks;
+        nextChunk = 0;
+        chunksLeft = chunks;
+        jobGeneration = ++generation;
+      }
+      wake.notify_all();
+
+      // Work alongside the pool, then wait for the chunks still running elsewhere
+      runChunks(jobGeneration);
+      std::unique_lock<std::mutex> lock(mutex);
+      finished.wait(lock, [this] { return chunksLeft == 0; });
+    }
+
+    template <typename Body>
+    uint64_t parallelForStealing(size_t _count, Body &&_body) {
+      // Call _body(slot, index) for every index in [0, _count), for work whose cost varies too much to split evenly up
+      // front. Each thread starts on an even share and once it runs dry takes half of what's left of the largest
+      // share. Slots are in [0, getThreadCount()) and only one thread runs a slot at a time, so state kept per slot
+      // needs no locking. Returns how many times work was stolen.
+      size_t                        slots = getThreadCount();
+      std::unique_ptr<StealRange[]> ranges(new StealRange[slots]);
+      std::atomic<uint64_t>         steals{0};
+      for (size_t i = 0; i < slots; i++) ranges[i].bits.store(StealRange::pack(_count * i / slots, _count * (i + 1) / slots));
+      parallelFor(slots, 1, [&](size_t _begin, size_t _end) {
+        for (size_t slot = _begin; slot < _end; slot++) {
+          size_t   index;
+          uint64_t stolen = 0;
+          while (ranges[slot].take(index) || steal(ranges.get(), slots, slot, index, stolen)) _body(slot, index);
+          steals += stolen;
+        }
+      });
+      return steals.load();
+    }
+
+   private:  // Workers
+    struct Job {
+      void * body = NULL;                           // The caller's body
+      void (*call)(void *, size_t, size_t) = NULL;  // Calls the body with a range
+      size_t count = 0;                             // Indices to cover
+      size_t chunks = 0;                            // Pieces the indices are split into
+    };
+
+    void run() {
+      uint64_t seen = 0;
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          wake.wait(lock, [&] { return stopping || generation != seen; });
+          if (stopping) return;
+          seen = generation;
+        }
+        runChunks(seen);
+      }
+    }
+    void runChunks(uint64_t _generation) {
+      // Take chunks of the given job until there are none left, the last one to finish wakes the caller.
+      // Chunks are few and large so taking them under the lock costs nothing next to running them.
+      std::unique_lock<std::mutex> lock(mutex);
+      while (generation == _generation && nextChunk < job.chunks) {
+        Job    current = job;
+        size_t chunk = nextChunk++;
+        lock.unlock();
+        current.call(current.body, current.count * chunk / current.chunks, current.count * (chunk + 1) / current.chunks);
+        lock.lock();
+        if (--chunksLeft == 0) finished.notify_all();
+      }
+    }
+
+
+    // A share of the indices as begin and end packed into one word, so taking from either end is a single CAS
+    struct alignas(64) StealRange {
+      std::atomic<uint64_t> bits{0};
+
+      static uint64_t pack(size_t _begin, size_t _end) {
+        return (uint64_t(_begin) << 32) | uint64_t(_end);
+      }
+      bool take(size_t &_index) {
+        // The owner takes from the front
+        uint64_t range = bits.load();
+        for (;;) {
+          size_t begin = size_t(range >> 32), end = size_t(range & 0xffffffffu);
+          if (begin >= end) return false;
+          if (bits.compare_exchange_weak(range, pack(begin + 1, end))) {
+            _index = begin;
+            return true;
+          }
+        }
+      }
+    };
+    static bool steal(StealRange *_ranges, size_t _slots, size_t _thief, size_t &_index, uint64_t &_stolen) {
+      // Take the back half of the largest share left, run its first index and keep the rest as the thief's own.
+      // Only the owner makes an empty share non-empty again, so no other thief can be writing the thief's range.
+      for (;;) {
+        size_t   victim = _slots;
+        uint64_t largest = 0, range = 0;
+        for (size_t i = 0; i < _slots; i++) {
+          uint64_t bits = _ranges[i].bits.load();
+          uint64_t begin = bits >> 32, end = bits & 0xffffffffu;
+          if (i != _thief && end > begin && end - begin > largest) {
+            victim = i;
+            largest = end - begin;
+            range = bits;
+          }
+        }
+        if (victim == _slots) return false;
+        size_t begin = size_t(range >> 32), end = size_t(range & 0xffffffffu);
+        size_t middle = begin + (end - begin) / 2;
+        if (!_ranges[victim].bits.compare_exchange_strong(range, StealRange::pack(begin, middle))) continue;
+        _ranges[_thief].bits.store(StealRange::pack(middle + 1, end));
+        _index = middle;
+        _stolen++;
+        return true;
+      }
+    }
+
+   private:  // Data
+    std::vector<std::thread> workers;           // The pool's threads, the caller makes one more
+    std::mutex               mutex;             // Guards the job hand over
+    std::condition_variable  wake;              // Signals the workers there's a new job or they should stop
+    std::condition_variable  finished;          // Signals the caller the last chunk is done
+    Job                      job;               // The job being run
+    size_t                   nextChunk = 0;     // The next chunk to be taken
+    size_t                   chunksLeft = 0;    // Chunks not yet finished
+    uint64_t                 generation = 0;    // Bumped for every job so sleeping workers notice it
+    bool                     stopping = false;  // Set to stop the workers
+  };
+
+}  // namespace pong
+
+#endif  // PONG_THREAD_POOL_H
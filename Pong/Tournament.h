@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_TOURNAMENT_H
+#define PONG_TOURNAMENT_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+namespace pong {
+
+  // The totals of every match one pairing of CPUs played
+  struct PairingStats {
+    static const int RALLY_BUCKETS = 8;  // Rallies of 0, 1, 2, 3-4, 5-8, 9-16, 17-32 and more than 32 hits
+
+    GameMode left = GameMode::HARD;        // Player 1's difficulty
+    GameMode right = GameMode::MEDIUM;     // The opponent's difficulty
+    uint64_t matches = 0;                  // Matches played
+    uint64_t leftWins = 0, rightWins = 0;  // Matches won by each side
+    uint64_t unfinished = 0;               // Matches that ran out of ticks
+    uint64_t ticks = 0;                    // Ticks played
+    uint64_t points = 0;                   // Points scored
+    uint64_t hits = 0;                     // Paddle hits
+    uint64_t rallies[RALLY_BUCKETS] = {};  // Points by how many hits the rally before them had
+
+    static int rallyBucket(uint64_t _hits) {
+      int bucket = 0;
+      while (bucket < RALLY_BUCKETS - 1 && _hits > (bucket < 3 ? uint64_t(bucket) : uint64_t(1) << (bucket - 1))) bucket++;
+      return bucket;
+    }
+    void merge(const PairingStats &_other) {
+      matches += _other.matches;
+      leftWins += _other.leftWins;
+      rightWins += _other.rightWins;
+      unfinished += _other.unfinished;
+      ticks += _other.ticks;
+      points += _other.points;
+      hits += _other.hits;
+      for (int i = 0; i < RALLY_BUCKETS; i++) rallies[i] += _other.rallies[i];
+    }
+  };
+
+  // Plays every pairing of CPU difficulties a number of times across all cores. Matches are interleaved so each
+  // thread's share holds every pairing, and idle threads steal from busy ones as match lengths vary. Each match gets
+  // a fresh simulation seeded from its number, so the results are the same whatever the thread count.
+  class Tournament {
+   public:  // Constructor
+    explicit Tournament(size_t _threads = 0) : pool(_threads) {}
+
+   public:  // Settings
+    void addPairing(GameMode _left, GameMode _right) {
+      PairingStats pairing;
+      pairing.left = _left;
+      pairing.right = _right;
+      pairings.push_back(pairing);
+    }
+    const std::vector<PairingStats> &getPairings() const {
+      return pairings;
+    }
+    size_t getThreadCount() const {
+      return pool.getThreadCount();
+    }
+
+   public:  // Playing
+    std::vector<PairingStats> run(uint64_t _matchesPerPairing, uint32_t _seed, uint64_t _maxTicks, float _tickRate) {
+      // Every thread keeps its own totals, merged once the last match is done
+      size_t                                 count = pairings.size();
+      std::vector<std::vector<PairingStats>> perSlot(pool.getThreadCount(), pairings);
+
+      auto startTime = std::chrono::steady_clock::now();
+      steals = pool.parallelForStealing(size_t(_matchesPerPairing * count), [&](size_t _slot, size_t _index) {
+        PairingStats &stats = perSlot[_slot][_index % count];
+        play(stats, _seed + uint32_t(_index / count), _maxTicks, _tickRate);
+      });
+      seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+      std::vector<PairingStats> results = perSlot[0];
+      for (size_t slot = 1; slot < perSlot.size(); slot++) {
+        for (size_t i = 0; i < count; i++) results[i].merge(perSlot[slot][i]);
+      }
+      return results;
+    }
+    double getSeconds() const {
+      return seconds;
+    }
+    uint64_t getSteals() const {
+      return steals;
+    }
+
+   private:  // Helpers
+    static void play(PairingStats &_stats, uint32_t _seed, uint64_t _maxTicks, float _tickRate) {
+      // The same match the headless runner plays with this seed
+      Simulation sim;
+      sim.autoServe = true;
+      sim.setTickRate(_tickRate);
+      sim.seed(_seed);
+      sim.resetGame();
+      sim.setMode(_stats.right);
+      sim.setPlayer1Cpu(_stats.left);
+      sim.serve();
+      sim.start();
+
+      uint64_t ticks = 0, rallyHits = 0;
+      Inputs   inputs;
+      while (sim.gameState <= GameState::IN_PLAY && ticks < _maxTicks) {
+        uint32_t events = sim.tick(inputs);
+        ticks++;
+        if (events & EVENT_PADDLE_HIT) rallyHits++;
+        if (events & EVENT_POINT_SCORED) {
+          _stats.points++;
+          _stats.hits += rallyHits;
+          _stats.rallies[PairingStats::rallyBucket(rallyHits)]++;
+          rallyHits = 0;
+        }
+      }
+
+      _stats.matches++;
+      _stats.ticks += ticks;
+      if (sim.gameState == GameState::PLAYER_1_WINNER)
+        _stats.leftWins++;
+      else if (sim.gameState > GameState::IN_PLAY)
+        _stats.rightWins++;
+      else
+        _stats.unfinished++;
+    }
+
+   private:  // Data
+    ThreadPool                pool;         // The threads matches are played on
+    std::vector<PairingStats> pairings;     // The pairings to play, with no results
+    double                    seconds = 0;  // Time the last run took
+    uint64_t                  steals = 0;   // Times a thread took work from another in the last run
+  };
+
+}  // namespace pong
+
+#endif  // PONG_TOURNAMENT_H
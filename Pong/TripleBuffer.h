@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_TRIPLE_BUFFER_H
+#define PONG_TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace pong {
+
+  // Hands the newest of a stream of values from one writer thread to one reader thread without either ever waiting.
+  // The writer fills its own buffer and swaps it into the middle, the reader swaps the middle for its own buffer when
+  // there's something new there. Values the reader never got to are simply replaced.
+  template <typename T>
+  class TripleBuffer {
+    static const uint8_t INDEX_MASK = 3;  // Which buffer the middle slot holds
+    static const uint8_t FRESH = 4;       // Set while the middle holds a value the reader hasn't taken
+
+   public:  // Writer
+    T &back() {
+      return buffers[backIndex];
+    }
+    bool publish() {
+      // Swap the finished buffer into the middle, true when the one it replaced was never read
+      uint8_t previous = middle.exchange(uint8_t(backIndex | FRESH), std::memory_order_acq_rel);
+      backIndex = previous & INDEX_MASK;
+      return (previous & FRESH) != 0;
+    }
+
+   public:  // Reader
+    bool update() {
+      // Take the newest value if there is one, the front stays as it was otherwise
+      if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+      frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+      return true;
+    }
+    const T &front() const {
+      return buffers[frontIndex];
+    }
+
+   private:  // Data
+    // Each side only ever touches its own buffer and the middle, the atomic swap is what hands a buffer over
+    alignas(64) std::atomic<uint8_t> middle{1};  // The buffer in between and whether it's fresh
+    alignas(64) uint8_t backIndex = 0;           // The writer's buffer
+    alignas(64) uint8_t frontIndex = 2;          // The reader's buffer
+    T buffers[3];                                // The three values
+  };
+
+}  // namespace pong
+
+#endif  // PONG_TRIPLE_BUFFER_H
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+#ifndef PONG_VECTOR_ENV_H
+#define PONG_VECTOR_ENV_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+namespace pong {
+
+  // What an agent sees of one environment after a step
+  struct EnvObservation {
+    float ballX;      // Ball across the field, 0 at player 1's end and 1 at the opponent's
+    float ballY;      // Ball down the field, 0 at the top and 1 at the bottom
+    float ballVX;     // Ball x velocity over the fastest it can go
+    float ballVY;     // Ball y velocity over the fastest it can go
+    float paddleY;    // The agent's paddle down the field
+    float opponentY;  // The CPU's paddle down the field
+  };
+
+  // A batch of independent games where agents play player 1 against the CPU, stepped together
+  class VectorEnv {
+   public:  // Types
+    enum Action : int8_t {
+      ACTION_UP = -1,   // Hold up for the whole tick
+      ACTION_STAY = 0,  // Leave the paddle where it is
+      ACTION_DOWN = 1   // Hold down for the whole tick
+    };
+
+   public:  // Constants
+    static const size_t GRAIN = 64;  // Fewest environments worth handing to another thread
+
+   public:  // Constructor
+    VectorEnv(size_t _count, GameMode _opponent = GameMode::MEDIUM, size_t _threads = 0)
+        : envs(_count), opponent(_opponent), pool(_threads) {}
+
+   public:  // Accessors
+    size_t size() const {
+      return envs.size();
+    }
+    size_t getThreadCount() const {
+      return pool.getThreadCount();
+    }
+    Simulation &getSimulation(size_t _index) {
+      return envs[_index].sim;
+    }
+
+   public:  // Batch API
+    void reset(const uint32_t *_seeds, EnvObservation *_observations) {
+      // Start a fresh match in every environment. Matches that finish during step() restart with the next seed
+      // _seeds[i] + size() * episode, so environments never replay each other's matches.
+      pool.parallelFor(envs.size(), GRAIN, [&](size_t _begin, size_t _end) {
+        for (size_t i = _begin; i < _end; i++) {
+          envs[i].nextSeed = _seeds[i];
+          startEpisode(envs[i]);
+          observe(envs[i].sim, _observations[i]);
+        }
+      });
+    }
+    void step(const int8_t *_actions, EnvObservation *_observations, float *_rewards, uint8_t *_done) {
+      // Play one tick in every environment. The reward is +1 for a point won and -1 for a point lost, survival returns
+      // also count +1. Done is set on the step a match ends and the observation is already from the next match.
+      pool.parallelFor(envs.size(), GRAIN, [&](size_t _begin, size_t _end) {
+        for (size_t i = _begin; i < _end; i++) stepEnv(envs[i], _actions[i], _observations[i], _rewards[i], _done[i]);
+      });
+    }
+
+   public:  // Data
+    uint64_t maxEpisodeTicks = 0;  // End a match after this many ticks, 0 for no limit (survival never ends on its own)
+
+   private:  // Environments
+    struct Env {
+      Simulation sim;               // The rules of the game
+      uint32_t   nextSeed = 0;      // Seed of the next match
+      uint64_t   episodeTicks = 0;  // Ticks played in the current match
+    };
+
+    void startEpisode(Env &_env) {
+      Simulation &sim = _env.sim;
+      sim.seed(_env.nextSeed);
+      _env.nextSeed += uint32_t(envs.size());
+      _env.episodeTicks = 0;
+      sim.resetGame();
+      sim.setMode(opponent);
+      sim.serve();
+      sim.start();
+    }
+    void stepEnv(Env &_env, int8_t _action, EnvObservation &_observation, float &_reward, uint8_t &_done) {
+      Simulation &sim = _env.sim;
+      Inputs      inputs;
+      inputs.player1 = int8_t((_action < 0) ? -Inputs::FULL_TICK : (_action > 0) ? Inputs::FULL_TICK : 0);
+
+      // Score the tick, player 1 losing the point is the only way lostLastPoint is set before the serve
+      uint32_t events = sim.tick(inputs);
+      float    reward = 0;
+      if (events & EVENT_SURVIVAL_RETURN) reward += 1;
+      if (events & EVENT_POINT_SCORED) reward += sim.player1.hasLostLastPoint() ? -1.0f : 1.0f;
+      _env.episodeTicks++;
+
+      // Serve again after a point, or start the next match once this one is over
+      bool done = (events & EVENT_GAME_OVER) || (maxEpisodeTicks && _env.episodeTicks >= maxEpisodeTicks);
+      if (done) {
+        startEpisode(_env);
+      } else if (events & EVENT_POINT_SCORED) {
+        sim.serve();
+        sim.start();
+      }
+
+      _reward = reward;
+      _done = done ? 1 : 0;
+      observe(sim, _observation);
+    }
+    static void observe(const Simulation &_sim, EnvObservation &_observation) {
+      float width = float(_sim.width), height = float(_sim.height);
+      _observation.ballX = float(_sim.ball.getX()) / width;
+      _observation.ballY = float(_sim.ball.getY()) / height;
+      _observation.ballVX = float(_sim.ball.getXVelocity()) / float(_sim.maxXSpeed);
+      _observation.ballVY = float(_sim.ball.getYVelocity()) / float(_sim.maxYSpeed);
+      _observation.paddleY = float(_sim.player1.getY()) / height;
+      _observation.opponentY = float(_sim.cpu.getY()) / height;
+    }
+
+   private:  // Data
+    std::vector<Env> envs;      // Every environment, side by side in one allocation
+    GameMode         opponent;  // Difficulty of the CPU in every environment
+    ThreadPool       pool;      // Threads the batch is split over
+  };
+
+}  // namespace pong
+
+#endif  // PONG_VECTOR_ENV_H
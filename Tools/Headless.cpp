@@ -0,0 +1,242 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Plays seeded CPU vs CPU matches with no console as fast as the CPU allows
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "Pong/Simulation.h"
+#include "Pong/Spectator.h"
+
+using namespace pong;
+
+static const char *modeName(GameMode _mode) {
+  switch (_mode) {
+  case GameMode::EASY:
+    return "easy";
+  case GameMode::MEDIUM:
+    return "medium";
+  case GameMode::HARD:
+    return "hard";
+  case GameMode::IMPOSSIBLE:
+    return "impossible";
+  default:
+    return "human";
+  }
+}
+
+static bool parseMode(const char *_name, GameMode *_mode) {
+  const GameMode modes[] = {GameMode::EASY, GameMode::MEDIUM, GameMode::HARD, GameMode::IMPOSSIBLE};
+  for (GameMode mode : modes) {
+    if (strcmp(_name, modeName(mode)) == 0) {
+      *_mode = mode;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseKernel(const char *_name, SwarmKernel *_kernel) {
+  const char *names[] = {"scalar", "sse", "avx2"};
+  for (int i = 0; i < 3; i++) {
+    if (strcmp(_name, names[i]) == 0) {
+      *_kernel = SwarmKernel(i);
+      return BallSwarm::isSupported(*_kernel);
+    }
+  }
+  return false;
+}
+
+static void printUsage() {
+  printf(
+      "Usage: pong_headless [options]\n"
+      "  --matches N      Number of matches to play (default 1000)\n"
+      "  --seed S         Seed of the first match, match i uses S + i (default 1)\n"
+      "  --left MODE      CPU difficulty of player 1: easy, medium, hard, impossible (default hard)\n"
+      "  --right MODE     CPU difficulty of the opponent (default medium)\n"
+      "  --max-ticks N    Give up on a match after N ticks (default 1000000)\n"
+      "  --tick-rate HZ   Physics ticks per second of game time (default 33.3, the original 30 ms tick)\n"
+      "  --balls N        Play multi-ball with N balls for --max-ticks ticks (default 1000) with no winning score\n"
+      "  --kernel K       Swarm kernel for multi-ball: scalar, sse, avx2 (default the best the CPU supports)\n"
+      "  --skip           Jump straight from one ball event to the next instead of playing every tick\n"
+#ifdef __linux__
+      "  --spectate ADDR  Play in real time and broadcast every tick to viewers on a TCP port or Unix socket path\n"
+#endif
+      "  --verbose        Print the result of every match\n");
+}
+
+int main(int argc, char **argv) {
+  // Defaults for the run
+  int         matches = 1000;
+  uint32_t    seed = 1;
+  GameMode    left = GameMode::HARD;
+  GameMode    right = GameMode::MEDIUM;
+  uint64_t    maxTicks = 1000000;
+  float       tickRate = Simulation::REFERENCE_TICK_RATE;
+  bool        verbose = false;
+  int         balls = 0;
+  bool        maxTicksSet = false;
+  bool        skip = false;
+  SwarmKernel kernel = BallSwarm::bestKernel();
+#ifdef __linux__
+  const char *spectate = NULL;
+#endif
+
+  // Read the command line
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--matches") && hasValue) {
+      matches = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && hasValue) {
+      seed = uint32_t(strtoul(argv[++i], NULL, 10));
+    } else if (!strcmp(argv[i], "--left") && hasValue) {
+      if (!parseMode(argv[++i], &left)) return printUsage(), 1;
+    } else if (!strcmp(argv[i], "--right") && hasValue) {
+      if (!parseMode(argv[++i], &right)) return printUsage(), 1;
+    } else if (!strcmp(argv[i], "--max-ticks") && hasValue) {
+      maxTicks = strtoull(argv[++i], NULL, 10);
+      maxTicksSet = true;
+    } else if (!strcmp(argv[i], "--tick-rate") && hasValue) {
+      tickRate = float(atof(argv[++i]));
+    } else if (!strcmp(argv[i], "--balls") && hasValue) {
+      balls = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--kernel") && hasValue) {
+      if (!parseKernel(argv[++i], &kernel)) return printUsage(), 1;
+    } else if (!strcmp(argv[i], "--skip")) {
+      skip = true;
+#ifdef __linux__
+    } else if (!strcmp(argv[i], "--spectate") && hasValue) {
+      spectate = argv[++i];
+#endif
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // Totals over every match
+  uint64_t totalTicks = 0, totalRallies = 0, totalHits = 0;
+  int      leftWins = 0, rightWins = 0, unfinished = 0;
+
+  Simulation sim;
+  sim.autoServe = true;
+  sim.setTickRate(tickRate);
+  sim.swarm.setKernel(kernel);
+  Inputs inputs;
+
+  // Multi-ball runs a fixed number of ticks since with enough balls any winning score is reached at once
+  if (balls > 0) {
+    sim.multiBallCount = balls;
+    sim.multiBallCpu = right;
+    sim.multiBallWinningScore = INT_MAX;
+    if (!maxTicksSet) maxTicks = 1000;
+  }
+
+#ifdef __linux__
+  // Viewers watch at the speed the game plays, every tick is published so skipping is off
+  SpectatorServer server;
+  if (spectate) {
+    char *end;
+    long  port = strtol(spectate, &end, 10);
+    bool  listening = (*end == '\0') ? server.listenTcp(uint16_t(port)) : server.listenUnix(spectate);
+    if (!listening || tickRate <= 0) {
+      fprintf(stderr, "Can't listen for spectators on %s\n", spectate);
+      return 1;
+    }
+    skip = false;
+  }
+  auto frameTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+  auto nextFrame = std::chrono::steady_clock::now();
+#endif
+
+  auto startTime = std::chrono::steady_clock::now();
+  for (int match = 0; match < matches; match++) {
+    // Set up a fresh CPU vs CPU match
+    sim.seed(seed + uint32_t(match));
+    sim.resetGame();
+    sim.setMode(balls > 0 ? GameMode::MULTIBALL : right);
+    sim.setPlayer1Cpu(left);
+    sim.serve();
+    sim.start();
+
+    // Play until someone wins or the match runs too long
+    uint64_t ticks = 0, rallies = 0, hits = 0;
+    while (sim.gameState <= GameState::IN_PLAY && ticks < maxTicks) {
+      // Skipping plays the same ticks, only the ones where nothing can happen are cheaper
+      uint32_t events;
+      if (skip) {
+        uint64_t skipped;
+        events = sim.advanceToNextEvent(maxTicks - ticks, &skipped);
+        ticks += skipped;
+      } else {
+        events = sim.tick(inputs);
+        ticks++;
+      }
+#ifdef __linux__
+      if (spectate) {
+        server.publish(sim);
+        server.service(0);
+        nextFrame += frameTime;
+        std::this_thread::sleep_until(nextFrame);
+      }
+#endif
+      if (events & EVENT_PADDLE_HIT) hits++;
+      if (events & EVENT_POINT_SCORED) rallies++;
+    }
+
+    // Record the outcome
+    if (sim.gameState == GameState::PLAYER_1_WINNER)
+      leftWins++;
+    else if (sim.gameState > GameState::IN_PLAY)
+      rightWins++;
+    else
+      unfinished++;
+    totalTicks += ticks;
+    totalRallies += rallies;
+    totalHits += hits;
+
+    if (verbose) {
+      printf("match %d seed %u: %d - %d in %llu ticks, %llu rallies, %llu hits\n", match, seed + uint32_t(match),
+             sim.player1.getScore(), sim.getOpponent()->getScore(), (unsigned long long)ticks,
+             (unsigned long long)rallies, (unsigned long long)hits);
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  // Report the throughput and results
+  printf("matches:      %d (seed %u, left %s vs right %s)\n", matches, seed, modeName(left), modeName(right));
+  printf("left wins:    %d (%.1f%%)\n", leftWins, matches ? 100.0 * leftWins / matches : 0.0);
+  printf("right wins:   %d (%.1f%%)\n", rightWins, matches ? 100.0 * rightWins / matches : 0.0);
+  printf("unfinished:   %d\n", unfinished);
+  printf("ticks:        %llu (%.1f per match)\n", (unsigned long long)totalTicks, matches ? double(totalTicks) / matches : 0.0);
+  printf("rallies:      %llu (%.2f hits per rally)\n", (unsigned long long)totalRallies,
+         totalRallies ? double(totalHits) / totalRallies : 0.0);
+  printf("elapsed:      %.3f s\n", seconds);
+  printf("ticks/sec:    %.0f\n", seconds > 0 ? totalTicks / seconds : 0.0);
+  printf("rallies/sec:  %.0f\n", seconds > 0 ? totalRallies / seconds : 0.0);
+  if (balls > 0) {
+    const char *kernelNames[] = {"scalar", "sse", "avx2"};
+    double      ballTicks = double(totalTicks) * balls;
+    printf("balls:        %d (%s kernel)\n", balls, kernelNames[int(kernel)]);
+    printf("ns/ball/tick: %.3f\n", ballTicks > 0 ? seconds * 1e9 / ballTicks : 0.0);
+  }
+  return 0;
+}
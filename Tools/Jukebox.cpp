@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Plays every song in the game through the audio engine and reports its queue latency and drops
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "Pong/Audio.h"
+#include "Pong/Songs.h"
+
+using namespace pong;
+
+static const int SAMPLE_RATE = 22050;
+
+static void printUsage() {
+  printf(
+      "Usage: pong_jukebox [sink] [--burst N]\n"
+      "  --null           Discard the audio (default)\n"
+      "  --wav FILE       Record the audio into a .wav file\n"
+      "  --raw            Write raw S16_LE mono samples to stdout, e.g. | aplay -f S16_LE -r 22050\n"
+#ifdef PONG_WITH_ALSA
+      "  --alsa           Play through the default ALSA device\n"
+#endif
+      "  --burst N        Also queue N paddle hits at once to show how many get dropped (default 1000)\n");
+}
+
+int main(int argc, char **argv) {
+  std::unique_ptr<AudioSink> sink(new NullAudioSink());
+  int                        burst = 1000;
+  FILE *                     report = stdout;
+
+  // Read the command line
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--null")) {
+      sink.reset(new NullAudioSink());
+    } else if (!strcmp(argv[i], "--wav") && i + 1 < argc) {
+      sink.reset(new WavFileAudioSink(argv[++i], SAMPLE_RATE));
+    } else if (!strcmp(argv[i], "--raw")) {
+      sink.reset(new RawAudioSink(stdout));
+      report = stderr;
+#ifdef PONG_WITH_ALSA
+    } else if (!strcmp(argv[i], "--alsa")) {
+      sink.reset(new AlsaAudioSink(SAMPLE_RATE));
+#endif
+    } else if (!strcmp(argv[i], "--burst") && i + 1 < argc) {
+      burst = atoi(argv[++i]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  AudioEngine audio;
+  audio.start(sink.get(), SAMPLE_RATE);
+
+  // Queue all the songs the way the game does and time how long the calls take
+  auto startTime = std::chrono::steady_clock::now();
+  int  length = 0;
+  length += audio.playSong(THEME_SONG, sizeof(THEME_SONG) / sizeof(Note));
+  length += audio.playSong(MULTIPLAYER_SONG, sizeof(MULTIPLAYER_SONG) / sizeof(Note));
+  length += audio.playSong(EASY_SONG, sizeof(EASY_SONG) / sizeof(Note));
+  length += audio.playSong(MEDIUM_SONG, sizeof(MEDIUM_SONG) / sizeof(Note));
+  length += audio.playSong(HARD_SONG, sizeof(HARD_SONG) / sizeof(Note));
+  length += audio.playSong(IMPOSSIBLE_SONG, sizeof(IMPOSSIBLE_SONG) / sizeof(Note));
+  length += audio.playSong(MULTIBALL_SONG, sizeof(MULTIBALL_SONG) / sizeof(Note));
+  length += audio.playSong(EXPERT_SONG, sizeof(EXPERT_SONG) / sizeof(Note));
+  length += audio.playSong(WINNING_SONG, sizeof(WINNING_SONG) / sizeof(Note));
+  length += audio.playSong(LOSING_SONG, sizeof(LOSING_SONG) / sizeof(Note));
+  double enqueueUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+
+  // Then flood the queue with paddle hits
+  for (int i = 0; i < burst; i++) audio.play(HIT_SOUND[0].frequency, HIT_SOUND[0].duration);
+
+  // Let the audio thread drain the queue
+  while (!audio.isIdle()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  audio.stop();
+
+  AudioEngine::Stats stats = audio.getStats();
+  fprintf(report, "songs:         %d ms of music queued in %.1f us\n", length, enqueueUs);
+  fprintf(report, "notes queued:  %llu\n", (unsigned long long)stats.queued);
+  fprintf(report, "notes dropped: %llu\n", (unsigned long long)stats.dropped);
+  fprintf(report, "notes played:  %llu\n", (unsigned long long)stats.played);
+  fprintf(report, "queue latency: mean %llu us, max %llu us\n", (unsigned long long)stats.meanLatencyUs,
+          (unsigned long long)stats.maxLatencyUs);
+  return 0;
+}
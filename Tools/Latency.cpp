@@ -0,0 +1,378 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+
+// Measures how long a key press takes to show on screen. Plays a match on a pseudo-terminal it opens for itself:
+// key presses are typed into the terminal, read by the game's Keyboard, simulated, drawn, shown through the
+// FramePipeline and the POSIX terminal backend, and read back off the other end the way a terminal emulator would.
+// Every press is followed through each stage on the way and each stage keeps a histogram. No real terminal is needed,
+// so it can run in CI and fail when the latency goes over a limit.
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Pong/FramePipeline.h"
+#include "Pong/Input.h"
+#include "Pong/Profiler.h"
+#include "Pong/Simulation.h"
+
+using namespace pong;
+using namespace std::chrono;
+
+// The stages a key press goes through on its way to the screen
+enum Stage {
+  STAGE_READ,     // Typed into the terminal until the key reader stamped it
+  STAGE_INPUT,    // Stamped until a physics tick read it
+  STAGE_MOVE,     // Read until the paddle had moved a whole row
+  STAGE_PUBLISH,  // Moved until the frame showing it was handed to the pipeline
+  STAGE_RENDER,   // Handed over until its bytes were written to the terminal
+  STAGE_DISPLAY,  // Written until they were read off the other end
+  STAGE_TOTAL,    // Typed until read off the other end
+  STAGE_COUNT
+};
+static const char *const STAGE_NAMES[STAGE_COUNT] = {"read", "input", "move", "publish", "render", "display", "total"};
+
+// The far end of the pseudo-terminal, read on its own thread, noting when each piece of the stream arrived
+class PtyReader {
+ public:  // Constructor
+  ~PtyReader() {
+    stop();
+  }
+
+ public:  // Control
+  void start(int _fd) {
+    fd = _fd;
+    running = true;
+    worker = std::thread([this] { run(); });
+  }
+  void stop() {
+    running = false;
+    if (worker.joinable()) worker.join();
+  }
+
+ public:  // Game thread
+  bool find(uint64_t _offset, Clock::time_point *_time) {
+    // When the stream first reached _offset bytes, dropping what came before
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t                      i = 0;
+    while (i < chunks.size() && chunks[i].end < _offset) i++;
+    chunks.erase(chunks.begin(), chunks.begin() + i);
+    if (chunks.empty()) return false;
+    *_time = chunks.front().time;
+    return true;
+  }
+
+ private:  // Reader thread
+  void run() {
+    uint64_t total = 0;
+    char     buffer[65536];
+    while (running.load(std::memory_order_relaxed)) {
+      struct pollfd poller = {fd, POLLIN, 0};
+      if (poll(&poller, 1, 10) <= 0) continue;
+      ssize_t size = read(fd, buffer, sizeof(buffer));
+      if (size <= 0) continue;
+      total += uint64_t(size);
+      std::lock_guard<std::mutex> lock(mutex);
+      chunks.push_back(Chunk{total, Clock::now()});
+    }
+  }
+
+ private:  // Types
+  struct Chunk {
+    uint64_t          end;   // Bytes read so far once this piece arrived
+    Clock::time_point time;  // When it was read
+  };
+
+ private:  // Data
+  int                fd = -1;         // The pseudo-terminal's master side
+  std::thread        worker;          // The reader thread
+  std::atomic<bool>  running{false};  // Cleared to stop the reader thread
+  std::mutex         mutex;           // Guards chunks
+  std::vector<Chunk> chunks;          // Pieces of the stream not yet looked up
+};
+
+// The game's terminal backend, noting when each frame's bytes went out and how far into the stream they reach
+class ProbeTerminal : public PosixTerminal {
+ public:  // Types
+  struct Write {
+    uint64_t          frame;  // The frame the bytes belong to
+    Clock::time_point time;   // When the write returned
+    uint64_t          end;    // Bytes written so far including these
+  };
+
+ public:  // Constructor
+  void setPipeline(const FramePipeline *_pipeline) {
+    pipeline = _pipeline;
+  }
+
+ public:  // Output
+  virtual void present(const std::string &_frame) override {
+    PosixTerminal::present(_frame);
+    std::lock_guard<std::mutex> lock(mutex);
+    writes.push_back(Write{pipeline ? pipeline->getShowingNumber() : 0, Clock::now(), stats.bytes});
+  }
+
+ public:  // Game thread
+  bool find(uint64_t _frame, Write *_write) {
+    // The first write of the frame or a newer one that replaced it, dropping the ones before
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t                      i = 0;
+    while (i < writes.size() && writes[i].frame < _frame) i++;
+    writes.erase(writes.begin(), writes.begin() + i);
+    if (writes.empty()) return false;
+    *_write = writes.front();
+    return true;
+  }
+
+ private:  // Data
+  const FramePipeline *pipeline = NULL;  // Says which frame is being written
+  std::mutex           mutex;            // Guards writes
+  std::vector<Write>   writes;           // Frames written and not yet looked up
+};
+
+// One key press being followed to the screen
+struct Probe {
+  enum State { IDLE, TYPED, READ, MOVED, PUBLISHED, SETTLING };
+
+  State             state = IDLE;  // How far the press has got
+  Key               key = Key::W;  // The key typed
+  int               row = 0;       // The row the paddle was drawn on when it was typed
+  uint64_t          frame = 0;     // The number of the first frame showing the move
+  Clock::time_point typed;         // When it was typed into the terminal
+  Clock::time_point read;          // When a tick first read it
+  Clock::time_point moved;         // When the paddle reached another row
+  Clock::time_point published;     // When the frame showing the move was handed over
+};
+
+static void printUsage() {
+  printf(
+      "Usage: pong_latency [options]\n"
+      "  --probes N       Key presses to measure (default 100)\n"
+      "  --serial         Show frames on the game's thread instead of a render thread\n"
+      "  --max-p99 MS     Exit with status 2 when the total p99 is over MS milliseconds\n");
+}
+
+static uint64_t nanosBetween(Clock::time_point _from, Clock::time_point _to) {
+  // Stages timed on different threads can overlap by a little, count that as no time
+  return _to > _from ? uint64_t(duration_cast<nanoseconds>(_to - _from).count()) : 0;
+}
+
+static void drawFrame(Screen &_screen, const Simulation &_sim) {
+  // The game's play field: borders, both paddles and the ball
+  int width = _screen.getWidth(), height = _screen.getHeight() - 1;
+  for (int y = 0; y <= height; y++) {
+    char glyph = (y == 0 || y == 2 || y == height) ? '-' : ' ';
+    for (int x = 0; x < width; x++) _screen.put(x, y, glyph, COLOUR_WHITE);
+  }
+  for (int i = -2; i <= 2; i++) {
+    _screen.put(0, int(_sim.player1.getY()) + i, 'I', COLOUR_AQUA);
+    _screen.put(width - 1, int(_sim.cpu.getY()) + i, 'I', COLOUR_AQUA);
+  }
+  _screen.put(int(_sim.ball.getX()), int(_sim.ball.getY()), 'O', COLOUR_GREEN);
+}
+
+int main(int argc, char **argv) {
+  const double PHYSICS_RATE = 240, RENDER_RATE = 60;
+  int          probes = 100;
+  bool         serial = false;
+  double       maxP99 = 0;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--probes") && hasValue) {
+      probes = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--serial")) {
+      serial = true;
+    } else if (!strcmp(argv[i], "--max-p99") && hasValue) {
+      maxP99 = atof(argv[++i]);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // A pseudo-terminal of the game's size, raw so the bytes the game writes arrive untouched
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    fprintf(stderr, "Can't open a pseudo-terminal\n");
+    return 1;
+  }
+  int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if (slave < 0) {
+    fprintf(stderr, "Can't open %s\n", ptsname(master));
+    return 1;
+  }
+  struct winsize size = {};
+  size.ws_col = 100;
+  size.ws_row = 40;
+  ioctl(master, TIOCSWINSZ, &size);
+  struct termios mode;
+  tcgetattr(slave, &mode);
+  cfmakeraw(&mode);
+  tcsetattr(slave, TCSANOW, &mode);
+
+  // The game reads its keys from stdin and draws to stdout, so both become the pseudo-terminal and the report goes
+  // to where stdout was
+  FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+  dup2(slave, STDIN_FILENO);
+  dup2(slave, STDOUT_FILENO);
+  close(slave);
+
+  PtyReader reader;
+  reader.start(master);
+  Keyboard keyboard;
+  ProbeTerminal terminal;
+  FramePipeline pipeline(terminal);
+  terminal.setPipeline(&pipeline);
+
+  // Player 1 is typed for, against a CPU that keeps the ball in play
+  Simulation sim;
+  sim.seed(1);
+  sim.setTickRate(float(PHYSICS_RATE));
+  sim.autoServe = true;
+  sim.winningScore = INT_MAX;
+  sim.resetGame();
+  sim.setMode(GameMode::HARD);
+  sim.serve();
+  sim.start();
+  Screen screen(sim.width, sim.height + 1);
+  terminal.open(sim.width, sim.height + 1);
+  keyboard.start();
+  if (!serial) pipeline.start();
+
+  // The game's loop, with a key press typed whenever the last one has been seen on screen and let go of
+  HdrHistogram      histograms[STAGE_COUNT];
+  Random            random(5);
+  Probe             probe;
+  int               measured = 0, lost = 0;
+  double            tickSeconds = 1.0 / PHYSICS_RATE, accumulator = 0;
+  Clock::time_point loopStartTime = Clock::now(), nextFrameTime = loopStartTime;
+  keyboard.restart(loopStartTime);
+  while (measured + lost < probes) {
+    Clock::time_point loopEndTime = Clock::now();
+
+    // Tick at a fixed rate until caught up, watching for the press to be read and the paddle to move
+    accumulator = std::min(accumulator + duration<double>(loopEndTime - loopStartTime).count(), 0.25);
+    loopStartTime = loopEndTime;
+    Clock::time_point tickEndTime = loopEndTime - duration_cast<Clock::duration>(duration<double>(accumulator));
+    while (accumulator >= tickSeconds) {
+      accumulator -= tickSeconds;
+      tickEndTime += duration_cast<Clock::duration>(duration<double>(tickSeconds));
+      keyboard.advance(tickEndTime);
+      Inputs inputs;
+      inputs.player1 = int8_t(lround((keyboard.heldFraction(Key::S) - keyboard.heldFraction(Key::W)) * Inputs::FULL_TICK));
+      uint32_t events = sim.tick(inputs);
+      Clock::time_point tickTime = Clock::now();
+
+      // A point puts the paddle back in the middle, which would look like the press arriving
+      if ((events & EVENT_POINT_SCORED) && probe.state >= Probe::TYPED && probe.state <= Probe::MOVED) {
+        lost++;
+        probe.state = Probe::SETTLING;
+      }
+      if (probe.state == Probe::TYPED && inputs.player1 != 0) {
+        probe.read = tickTime;
+        probe.state = Probe::READ;
+      }
+      if (probe.state == Probe::READ && int(sim.player1.getY()) != probe.row) {
+        probe.moved = tickTime;
+        probe.state = Probe::MOVED;
+      }
+    }
+
+    // Draw and hand the frame over, the first one after the move is the one to look for on screen
+    drawFrame(screen, sim);
+    Clock::time_point publishTime = Clock::now();
+    pipeline.publish(screen);
+    if (probe.state == Probe::MOVED) {
+      probe.published = publishTime;
+      probe.frame = pipeline.getStats().published;
+      probe.state = Probe::PUBLISHED;
+    }
+
+    // Once its bytes have been read off the pseudo-terminal every stage of the press is known
+    ProbeTerminal::Write written;
+    Clock::time_point    displayed;
+    if (probe.state == Probe::PUBLISHED && terminal.find(probe.frame, &written) && reader.find(written.end, &displayed)) {
+      Clock::time_point stamped = keyboard.getPressTime(probe.key);
+      histograms[STAGE_READ].record(nanosBetween(probe.typed, stamped));
+      histograms[STAGE_INPUT].record(nanosBetween(stamped, probe.read));
+      histograms[STAGE_MOVE].record(nanosBetween(probe.read, probe.moved));
+      histograms[STAGE_PUBLISH].record(nanosBetween(probe.moved, probe.published));
+      histograms[STAGE_RENDER].record(nanosBetween(probe.published, written.time));
+      histograms[STAGE_DISPLAY].record(nanosBetween(written.time, displayed));
+      histograms[STAGE_TOTAL].record(nanosBetween(probe.typed, displayed));
+      measured++;
+      probe.state = Probe::SETTLING;
+    }
+
+    // Give up on a press that never got anywhere, then wait for the key to be let go of before the next
+    if (probe.state != Probe::IDLE && probe.state != Probe::SETTLING && Clock::now() - probe.typed > seconds(1)) {
+      lost++;
+      probe.state = Probe::SETTLING;
+    }
+    if (probe.state == Probe::SETTLING && !keyboard.isDown(Key::W) && !keyboard.isDown(Key::S)) probe.state = Probe::IDLE;
+
+    // Type the next press at a random point while waiting for the next frame, the way a player's key can land
+    // anywhere in one, alternating up and down to stay clear of the walls
+    nextFrameTime += duration_cast<Clock::duration>(duration<double>(1.0 / RENDER_RATE));
+    if (nextFrameTime < Clock::now()) nextFrameTime = Clock::now();
+    if (probe.state == Probe::IDLE) {
+      waitUntil(Clock::now() + duration_cast<Clock::duration>((nextFrameTime - Clock::now()) * random.nextFloat()));
+      probe.key = (probe.key == Key::W) ? Key::S : Key::W;
+      probe.row = int(sim.player1.getY());
+      probe.typed = Clock::now();
+      char character = (probe.key == Key::W) ? 'w' : 's';
+      if (write(master, &character, 1) != 1) break;
+      probe.state = Probe::TYPED;
+    }
+    waitUntil(nextFrameTime);
+  }
+  pipeline.stop();
+  terminal.close();
+  keyboard.stop();
+  reader.stop();
+
+  // Every stage's percentiles, the stages add up to about the total as they're measured one after another
+  fprintf(report, "key presses:     %d measured, %d lost to a point or a paddle against the wall\n", measured, lost);
+  fprintf(report, "frames:          %s, %.0f ticks and %.0f frames per second\n\n", serial ? "game thread" : "render thread",
+          PHYSICS_RATE, RENDER_RATE);
+  fprintf(report, "stage          mean ms    p50 ms    p90 ms    p99 ms    max ms\n");
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    const HdrHistogram &histogram = histograms[stage];
+    fprintf(report, "%-10s %10.3f %9.3f %9.3f %9.3f %9.3f\n", STAGE_NAMES[stage], histogram.getMean() / 1e6,
+            histogram.percentile(0.50) / 1e6, histogram.percentile(0.90) / 1e6, histogram.percentile(0.99) / 1e6,
+            histogram.getMax() / 1e6);
+  }
+  fflush(report);
+
+  double totalP99 = histograms[STAGE_TOTAL].percentile(0.99) / 1e6;
+  if (!measured) return 1;
+  if (maxP99 > 0 && totalP99 > maxP99) {
+    fprintf(report, "\ntotal p99 %.3f ms is over the limit of %.3f ms\n", totalP99, maxP99);
+    return 2;
+  }
+  return 0;
+}
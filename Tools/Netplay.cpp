@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Plays a rollback match between two peers over UDP loopback with added latency, jitter and loss, then checks both
+// peers ended up with the state a single simulation reaches with the same inputs
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Pong/Netplay.h"
+#include "Pong/Replay.h"
+
+using namespace pong;
+
+static void printUsage() {
+  printf(
+      "Usage: pong_netplay [options]\n"
+      "  --frames N       Frames each peer plays (default 20000)\n"
+      "  --tick-rate HZ   Frames per second, time on the link is counted in frames (default 60, as the game plays)\n"
+      "  --latency MS     One way delay added to every packet (default 40)\n"
+      "  --jitter MS      Further delay of up to this much, reordering packets (default 15)\n"
+      "  --loss PCT       Percent of packets dropped (default 5)\n"
+      "  --seed S         Seed of the match, the scripted inputs and the link (default 1)\n");
+}
+
+static std::vector<int8_t> scriptInputs(uint32_t _frames, uint64_t _seed) {
+  // Someone holding up, down or nothing, changing their mind every few frames
+  std::vector<int8_t> inputs(_frames);
+  Random              random(_seed);
+  int8_t              held = 0;
+  for (uint32_t i = 0; i < _frames; i++) {
+    if (random.next() % 8 == 0) held = int8_t(int(random.next() % 3) - 1) * Inputs::FULL_TICK;
+    inputs[i] = held;
+  }
+  return inputs;
+}
+
+static void setUp(Simulation &_sim, float _tickRate) {
+  // Settings both peers have to agree on before the match, the session sets up the rest
+  _sim.setTickRate(_tickRate);
+  _sim.winningScore = INT_MAX;
+}
+
+static void printStats(const char *_name, const RollbackSession &_session) {
+  const NetplayStats &stats = _session.getStats();
+  double              frames = stats.frames ? double(stats.frames) : 1;
+  printf("%s\n", _name);
+  printf("  frames:        %llu (%llu stalled)\n", (unsigned long long)stats.frames, (unsigned long long)stats.stalls);
+  printf("  rollbacks:     %llu (%.3f per frame, %llu frames played again, at most %u)\n", (unsigned long long)stats.rollbacks,
+         stats.rollbacks / frames, (unsigned long long)stats.resimulatedFrames, stats.maxRollbackFrames);
+  printf("  re-sim time:   %.3f us per frame, %.3f us per rollback\n", stats.resimNs / frames / 1000.0,
+         stats.rollbacks ? stats.resimNs / double(stats.rollbacks) / 1000.0 : 0.0);
+  printf("  packets:       %llu sent, %llu dropped, %llu received\n", (unsigned long long)stats.packetsSent,
+         (unsigned long long)stats.packetsDropped, (unsigned long long)stats.packetsReceived);
+}
+
+int main(int argc, char **argv) {
+  uint32_t       frames = 20000;
+  float          tickRate = 60;
+  LinkConditions conditions;
+  conditions.latencyUs = 40000;
+  conditions.jitterUs = 15000;
+  conditions.loss = 0.05f;
+  uint64_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--frames") && hasValue) {
+      frames = uint32_t(strtoul(argv[++i], NULL, 10));
+    } else if (!strcmp(argv[i], "--tick-rate") && hasValue) {
+      tickRate = float(atof(argv[++i]));
+    } else if (!strcmp(argv[i], "--latency") && hasValue) {
+      conditions.latencyUs = uint32_t(atof(argv[++i]) * 1000);
+    } else if (!strcmp(argv[i], "--jitter") && hasValue) {
+      conditions.jitterUs = uint32_t(atof(argv[++i]) * 1000);
+    } else if (!strcmp(argv[i], "--loss") && hasValue) {
+      conditions.loss = float(atof(argv[++i]) / 100);
+    } else if (!strcmp(argv[i], "--seed") && hasValue) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (tickRate <= 0) return printUsage(), 1;
+
+  // Host on any free loopback port and join it
+  Simulation      hostSim, joinSim;
+  RollbackSession host(hostSim), joiner(joinSim);
+  setUp(hostSim, tickRate);
+  setUp(joinSim, tickRate);
+  if (!host.host(0, seed) || !joiner.join("127.0.0.1", host.getPort())) {
+    fprintf(stderr, "Can't open UDP sockets on loopback\n");
+    return 1;
+  }
+  host.setConditions(conditions, seed * 2 + 1);
+  joiner.setConditions(conditions, seed * 2 + 2);
+
+  // Play both peers a frame at a time on a clock that moves one frame per step, so the run is as fast as the
+  // machine and the link conditions still count in frames
+  std::vector<int8_t> hostInputs = scriptInputs(frames, seed * 3 + 1);
+  std::vector<int8_t> joinInputs = scriptInputs(frames, seed * 3 + 2);
+  double              frameUs = 1000000.0 / tickRate;
+  uint64_t            maxSteps = uint64_t(frames) * 10 + 100000;
+  uint64_t            step = 0;
+  for (; step < maxSteps; step++) {
+    uint64_t now = uint64_t(double(step) * frameUs);
+    if (host.getFrame() < frames) {
+      host.advance(hostInputs[host.getFrame()], now);
+    } else {
+      host.poll(now);
+    }
+    if (joiner.getFrame() < frames) {
+      joiner.advance(joinInputs[joiner.getFrame()], now);
+    } else {
+      joiner.poll(now);
+    }
+    if (host.getState() == NetplayState::DISCONNECTED || joiner.getState() == NetplayState::DISCONNECTED) break;
+    if (host.getFrame() == frames && joiner.getFrame() == frames && host.isSynchronized() && joiner.isSynchronized()) break;
+  }
+
+  // The same match in one simulation with every input known up front
+  Simulation reference;
+  setUp(reference, tickRate);
+  reference.seed(seed);
+  reference.resetGame();
+  reference.setMode(GameMode::MULTIPLAYER);
+  reference.autoServe = true;
+  reference.serve();
+  reference.start();
+  for (uint32_t i = 0; i < frames; i++) {
+    Inputs inputs;
+    inputs.player1 = hostInputs[i];
+    inputs.player2 = joinInputs[i];
+    reference.tick(inputs);
+  }
+
+  printf("link:          %.1f ms latency, %.1f ms jitter, %.1f%% loss at %.0f frames per second\n", conditions.latencyUs / 1000.0,
+         conditions.jitterUs / 1000.0, conditions.loss * 100.0, tickRate);
+  printf("steps:         %llu for %u frames\n", (unsigned long long)step, frames);
+  printStats("host (player 1)", host);
+  printStats("joiner (player 2)", joiner);
+
+  uint64_t expected = hashState(reference);
+  printf("score:         %d - %d (reference %d - %d)\n", hostSim.player1.getScore(), hostSim.player2.getScore(), reference.player1.getScore(),
+         reference.player2.getScore());
+  printf("state hash:    host %016llx, joiner %016llx, reference %016llx\n", (unsigned long long)hashState(hostSim),
+         (unsigned long long)hashState(joinSim), (unsigned long long)expected);
+  if (hashState(hostSim) != expected || hashState(joinSim) != expected) {
+    printf("result:        MISMATCH\n");
+    return 1;
+  }
+  printf("result:        ok\n");
+  return 0;
+}
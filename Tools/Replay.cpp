@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Records, verifies and seeks replays without a console
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Pong/Replay.h"
+
+using namespace pong;
+
+static bool parseMode(const char *_name, GameMode *_mode) {
+  const char *   names[] = {"easy", "medium", "hard", "impossible"};
+  const GameMode modes[] = {GameMode::EASY, GameMode::MEDIUM, GameMode::HARD, GameMode::IMPOSSIBLE};
+  for (int i = 0; i < 4; i++) {
+    if (strcmp(_name, names[i]) == 0) {
+      *_mode = modes[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+static void printUsage() {
+  printf(
+      "Usage: pong_replay command FILE [options]\n"
+      "  record FILE      Play a scripted player 1 against the CPU and record it\n"
+      "    --seed S         Seed of the match (default 1)\n"
+      "    --right MODE     CPU difficulty: easy, medium, hard, impossible (default medium)\n"
+      "    --tick-rate HZ   Physics ticks per second of game time (default 240, as the game plays)\n"
+      "    --interval N     Ticks between keyframes (default 1024)\n"
+      "  verify FILE      Play the replay from the start and check every keyframe, the final score and state match\n"
+      "  seek FILE TICK   Show the state after TICK ticks and how long it took to get there\n"
+      "  info FILE        Show what's in the replay\n");
+}
+
+static Inputs scriptedInputs(const Simulation &_sim, uint32_t &_state) {
+  // Someone holding W or S towards the ball, looking up every few ticks and only when it's heading their way
+  static Inputs held;
+  _state = _state * 214013u + 2531011u;
+  if ((_state >> 16) % 4 != 0) return held;
+
+  float target = (float(_sim.ball.getXVelocity()) < 0) ? float(_sim.ball.getY()) : float(_sim.height / 2);
+  float delta = target - float(_sim.player1.getY());
+  held.player1 = int8_t((delta > 1) ? Inputs::FULL_TICK : (delta < -1) ? -Inputs::FULL_TICK : int(delta * 64));
+  return held;
+}
+
+static int record(const char *_path, int argc, char **argv) {
+  uint64_t seed = 1;
+  GameMode right = GameMode::MEDIUM;
+  float    tickRate = 240;
+  uint32_t interval = ReplayWriter::DEFAULT_KEYFRAME_INTERVAL;
+  for (int i = 0; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--seed") && hasValue) {
+      seed = uint64_t(strtoull(argv[++i], NULL, 10));
+    } else if (!strcmp(argv[i], "--right") && hasValue) {
+      if (!parseMode(argv[++i], &right)) return printUsage(), 1;
+    } else if (!strcmp(argv[i], "--tick-rate") && hasValue) {
+      tickRate = float(atof(argv[++i]));
+    } else if (!strcmp(argv[i], "--interval") && hasValue) {
+      interval = uint32_t(strtoul(argv[++i], NULL, 10));
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // Set up the match the way the game does, then record from the first serve
+  Simulation sim;
+  sim.seed(seed);
+  sim.setTickRate(tickRate);
+  sim.resetGame();
+  sim.setMode(right);
+  ReplayWriter writer;
+  if (!writer.begin(_path, sim, seed, interval)) {
+    fprintf(stderr, "Can't write %s\n", _path);
+    return 1;
+  }
+  sim.serve();
+  writer.serve();
+  sim.start();
+  writer.start();
+
+  // Play until someone wins, serving after every point like the game does
+  uint32_t inputState = uint32_t(seed);
+  while (sim.gameState <= GameState::IN_PLAY) {
+    Inputs inputs = scriptedInputs(sim, inputState);
+    writer.tick(inputs);
+    uint32_t events = sim.tick(inputs);
+    if ((events & EVENT_POINT_SCORED) && sim.gameState <= GameState::IN_PLAY) {
+      sim.serve();
+      writer.serve();
+      sim.start();
+      writer.start();
+    }
+  }
+  uint64_t ticks = writer.getTicks();
+  if (!writer.finish()) {
+    fprintf(stderr, "Failed writing %s\n", _path);
+    return 1;
+  }
+
+  ReplayFile replay;
+  replay.open(_path);
+  printf("recorded:     %s\n", _path);
+  printf("score:        %d - %d\n", sim.player1.getScore(), sim.getOpponent()->getScore());
+  printf("ticks:        %llu\n", (unsigned long long)ticks);
+  printf("size:         %llu bytes (%.3f bytes per tick)\n", (unsigned long long)replay.getSize(), ticks ? double(replay.getSize()) / ticks : 0.0);
+  printf("keyframes:    %llu\n", (unsigned long long)replay.getKeyframeCount());
+  return 0;
+}
+
+static int verify(const char *_path) {
+  ReplayFile replay;
+  if (!replay.open(_path)) {
+    fprintf(stderr, "%s is not a replay\n", _path);
+    return 1;
+  }
+
+  auto       startTime = std::chrono::steady_clock::now();
+  Simulation sim;
+  bool       played = replay.verify(sim);
+  double     ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+  // The final score and every bit of the final state have to come out the same
+  const ReplayFooter &footer = replay.getFooter();
+  bool                scoreMatches = sim.player1.getScore() == footer.player1Score && sim.getOpponent()->getScore() == footer.opponentScore;
+  bool                stateMatches = hashState(sim) == footer.stateHash;
+  printf("replayed:     %llu ticks in %.3f ms\n", (unsigned long long)replay.getTicks(), ms);
+  printf("score:        %d - %d (recorded %d - %d)\n", sim.player1.getScore(), sim.getOpponent()->getScore(), footer.player1Score,
+         footer.opponentScore);
+  printf("state hash:   %016llx (recorded %016llx)\n", (unsigned long long)hashState(sim), (unsigned long long)footer.stateHash);
+  if (!played || !scoreMatches || !stateMatches) {
+    printf("result:       MISMATCH\n");
+    return 1;
+  }
+  printf("result:       ok\n");
+  return 0;
+}
+
+static int seek(const char *_path, uint64_t _tick) {
+  ReplayFile replay;
+  if (!replay.open(_path)) {
+    fprintf(stderr, "%s is not a replay\n", _path);
+    return 1;
+  }
+
+  Simulation sim;
+  auto       startTime = std::chrono::steady_clock::now();
+  bool       found = replay.seek(sim, _tick);
+  double     us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+  if (!found) {
+    fprintf(stderr, "Can't seek to tick %llu\n", (unsigned long long)_tick);
+    return 1;
+  }
+  printf("tick:         %llu of %llu, reached in %.1f us\n", (unsigned long long)_tick, (unsigned long long)replay.getTicks(), us);
+  printf("score:        %d - %d\n", sim.player1.getScore(), sim.getOpponent()->getScore());
+  printf("ball:         %.3f, %.3f moving %.3f, %.3f\n", float(sim.ball.getX()), float(sim.ball.getY()), float(sim.ball.getXVelocity()),
+         float(sim.ball.getYVelocity()));
+  printf("paddles:      %.3f, %.3f\n", float(sim.player1.getY()), float(sim.getOpponent()->getY()));
+  return 0;
+}
+
+static int info(const char *_path) {
+  ReplayFile replay;
+  if (!replay.open(_path)) {
+    fprintf(stderr, "%s is not a replay\n", _path);
+    return 1;
+  }
+  const ReplayFooter &footer = replay.getFooter();
+  printf("seed:         %llu\n", (unsigned long long)replay.getSeed());
+  printf("ticks:        %llu\n", (unsigned long long)footer.ticks);
+  printf("score:        %d - %d\n", footer.player1Score, footer.opponentScore);
+  printf("size:         %llu bytes\n", (unsigned long long)replay.getSize());
+  printf("keyframes:    %llu\n", (unsigned long long)footer.keyframes);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) return printUsage(), 1;
+  const char *command = argv[1];
+  const char *path = argv[2];
+  if (!strcmp(command, "record")) return record(path, argc - 3, argv + 3);
+  if (!strcmp(command, "verify") && argc == 3) return verify(path);
+  if (!strcmp(command, "seek") && argc == 4) return seek(path, strtoull(argv[3], NULL, 10));
+  if (!strcmp(command, "info") && argc == 3) return info(path);
+  printUsage();
+  return 1;
+}
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+
+// Shows the live stats a running game publishes, at whatever rate is asked for. Reading never holds up the game, it
+// only maps the segment and copies the record out.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "Pong/Simulation.h"
+#include "Pong/StatsSegment.h"
+
+using namespace pong;
+
+static void printUsage() {
+  printf(
+      "Usage: pong_stats [PATH] [options]\n"
+      "  PATH             The game's stats segment (default pong.stats)\n"
+      "  --interval MS    Time between reads (default 1000)\n"
+      "  --count N        Stop after N reads (default run until interrupted)\n"
+      "  --json           Print each read as a line of JSON\n");
+}
+
+static const char *modeName(int32_t _mode) {
+  switch (GameMode(_mode)) {
+  case GameMode::NOT_STARTED: return "title";
+  case GameMode::MULTIPLAYER: return "multiplayer";
+  case GameMode::EASY: return "easy";
+  case GameMode::MEDIUM: return "medium";
+  case GameMode::HARD: return "hard";
+  case GameMode::IMPOSSIBLE: return "survival";
+  case GameMode::MULTIBALL: return "multi-ball";
+  case GameMode::EXPERT: return "expert";
+  default: return "unknown";
+  }
+}
+
+static const char *stateName(int32_t _state) {
+  switch (GameState(_state)) {
+  case GameState::NOT_STARTED: return "not started";
+  case GameState::PAUSED: return "paused";
+  case GameState::IN_PLAY: return "in play";
+  case GameState::PLAYER_1_WINNER: return "player 1 won";
+  case GameState::PLAYER_2_WINNER: return "player 2 won";
+  case GameState::CPU_WINNER: return "CPU won";
+  default: return "unknown";
+  }
+}
+
+static double ageSeconds(const GameStats &_stats) {
+  // How long ago the record was published, a running game publishes several times a second
+  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+  return double(int64_t(now.count()) - int64_t(_stats.updatedAtMs)) / 1000.0;
+}
+
+static void printStats(const GameStats &_stats, double _ageSeconds) {
+  int32_t opponentScore = (GameMode(_stats.gameMode) == GameMode::MULTIPLAYER) ? _stats.player2Score : _stats.cpuScore;
+  printf("pid %u %s, %s %d-%d | ticks %llu, frames %llu, frame p50 %.2f ms, p99 %.2f ms, max %.2f ms | rallies %llu, longest %d, "
+         "survival best %d | %.0f bytes/frame, %.1f keys/s | %.1f s ago%s\n",
+         _stats.processId, modeName(_stats.gameMode), stateName(_stats.gameState), _stats.player1Score, opponentScore,
+         (unsigned long long)_stats.ticks, (unsigned long long)_stats.frames, _stats.frameP50Ms, _stats.frameP99Ms, _stats.frameMaxMs,
+         (unsigned long long)_stats.rallies, _stats.longestRally, _stats.survivalBest, _stats.renderBytesPerFrame,
+         _stats.inputEventsPerSec, _ageSeconds, _stats.running ? "" : ", closed");
+}
+
+static void printJson(const GameStats &_stats, double _ageSeconds) {
+  printf("{\"pid\": %u, \"running\": %s, \"age_s\": %.3f, \"mode\": \"%s\", \"state\": \"%s\", \"player1_score\": %d, "
+         "\"player2_score\": %d, \"cpu_score\": %d, \"ticks\": %llu, \"frames\": %llu, \"frame_p50_ms\": %.3f, \"frame_p99_ms\": %.3f, "
+         "\"frame_max_ms\": %.3f, \"rallies\": %llu, \"paddle_hits\": %llu, \"longest_rally\": %d, \"survival_best\": %d, "
+         "\"render_bytes\": %llu, \"render_bytes_per_frame\": %.1f, \"input_events_per_s\": %.2f}\n",
+         _stats.processId, _stats.running ? "true" : "false", _ageSeconds, modeName(_stats.gameMode), stateName(_stats.gameState),
+         _stats.player1Score, _stats.player2Score, _stats.cpuScore, (unsigned long long)_stats.ticks, (unsigned long long)_stats.frames,
+         _stats.frameP50Ms, _stats.frameP99Ms, _stats.frameMaxMs, (unsigned long long)_stats.rallies,
+         (unsigned long long)_stats.paddleHits, _stats.longestRally, _stats.survivalBest, (unsigned long long)_stats.renderBytes,
+         _stats.renderBytesPerFrame, _stats.inputEventsPerSec);
+}
+
+int main(int argc, char **argv) {
+  const char *path = "pong.stats";
+  int         interval = 1000;
+  long long   count = -1;
+  bool        json = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--interval") && i + 1 < argc) {
+      interval = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+      count = atoll(argv[++i]);
+    } else if (!strcmp(argv[i], "--json")) {
+      json = true;
+    } else if (argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // A game that quits or dies and starts again makes a new segment, so look for one whenever the last has gone quiet
+  StatsSegment segment;
+  GameStats    stats;
+  for (long long reads = 0; count < 0 || reads < count; reads++) {
+    if (reads) std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    bool have = segment.read(&stats);
+    if (!have || !stats.running || ageSeconds(stats) > 2) {
+      segment.open(path);
+      have = segment.read(&stats);
+    }
+    if (!have) {
+      if (!json) printf("waiting for a game to publish to %s\n", path);
+      fflush(stdout);
+      continue;
+    }
+    if (json) {
+      printJson(stats, ageSeconds(stats));
+    } else {
+      printStats(stats, ageSeconds(stats));
+    }
+    fflush(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Plays CPU difficulties against each other across every core and compares how they do
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Pong/Tournament.h"
+
+using namespace pong;
+
+static const char *modeName(GameMode _mode) {
+  switch (_mode) {
+  case GameMode::EASY:
+    return "easy";
+  case GameMode::MEDIUM:
+    return "medium";
+  case GameMode::HARD:
+    return "hard";
+  case GameMode::IMPOSSIBLE:
+    return "impossible";
+  default:
+    return "human";
+  }
+}
+
+static bool parseMode(const char *_name, size_t _length, GameMode *_mode) {
+  const GameMode modes[] = {GameMode::EASY, GameMode::MEDIUM, GameMode::HARD, GameMode::IMPOSSIBLE};
+  for (GameMode mode : modes) {
+    if (strlen(modeName(mode)) == _length && strncmp(_name, modeName(mode), _length) == 0) {
+      *_mode = mode;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parsePairing(const char *_text, GameMode *_left, GameMode *_right) {
+  // LEFT:RIGHT, for example hard:medium
+  const char *colon = strchr(_text, ':');
+  return colon && parseMode(_text, size_t(colon - _text), _left) && parseMode(colon + 1, strlen(colon + 1), _right);
+}
+
+static void printUsage() {
+  printf(
+      "Usage: pong_tournament [options]\n"
+      "  --matches N      Matches each pairing plays (default 1000)\n"
+      "  --pairing L:R    Add a pairing such as hard:medium, can be repeated (default every difficulty against\n"
+      "                   easy, medium and hard, impossible on the right is survival and never ends)\n"
+      "  --seed S         Seed of each pairing's first match, match i uses S + i (default 1)\n"
+      "  --max-ticks N    Give up on a match after N ticks (default 1000000)\n"
+      "  --tick-rate HZ   Physics ticks per second of game time (default 33.3, the original 30 ms tick)\n"
+      "  --threads N      Threads to play on, 0 for one per core (default 0)\n"
+      "  --scaling        Play the tournament on 1, 2, 4 ... threads up to --threads and report the speed up\n");
+}
+
+static void printResults(const std::vector<PairingStats> &_results) {
+  printf("%-10s  %-10s  %7s  %6s  %6s  %5s  %8s  %5s   rallies by hits: %5s %5s %5s %5s %5s %5s %5s %5s\n", "left", "right", "matches",
+         "left", "right", "unfin", "points", "hits", "0", "1", "2", "3-4", "5-8", "9-16", "17-32", "33+");
+  for (const PairingStats &stats : _results) {
+    double matches = stats.matches ? double(stats.matches) : 1;
+    double points = stats.points ? double(stats.points) : 1;
+    printf("%-10s  %-10s  %7llu  %5.1f%%  %5.1f%%  %5llu  %8llu  %5.2f                    ", modeName(stats.left), modeName(stats.right),
+           (unsigned long long)stats.matches, 100.0 * stats.leftWins / matches, 100.0 * stats.rightWins / matches,
+           (unsigned long long)stats.unfinished, (unsigned long long)stats.points, stats.hits / points);
+    for (int i = 0; i < PairingStats::RALLY_BUCKETS; i++) printf(" %4.1f%%", 100.0 * stats.rallies[i] / points);
+    printf("\n");
+  }
+}
+
+static uint64_t totalPoints(const std::vector<PairingStats> &_results) {
+  uint64_t points = 0;
+  for (const PairingStats &stats : _results) points += stats.points;
+  return points;
+}
+
+int main(int argc, char **argv) {
+  // Defaults for the run
+  uint64_t                                   matches = 1000;
+  uint32_t                                   seed = 1;
+  uint64_t                                   maxTicks = 1000000;
+  float                                      tickRate = Simulation::REFERENCE_TICK_RATE;
+  size_t                                     threads = 0;
+  bool                                       scaling = false;
+  std::vector<std::pair<GameMode, GameMode>> pairings;
+
+  // Read the command line
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--matches") && hasValue) {
+      matches = strtoull(argv[++i], NULL, 10);
+    } else if (!strcmp(argv[i], "--pairing") && hasValue) {
+      GameMode left, right;
+      if (!parsePairing(argv[++i], &left, &right)) return printUsage(), 1;
+      pairings.push_back(std::make_pair(left, right));
+    } else if (!strcmp(argv[i], "--seed") && hasValue) {
+      seed = uint32_t(strtoul(argv[++i], NULL, 10));
+    } else if (!strcmp(argv[i], "--max-ticks") && hasValue) {
+      maxTicks = strtoull(argv[++i], NULL, 10);
+    } else if (!strcmp(argv[i], "--tick-rate") && hasValue) {
+      tickRate = float(atof(argv[++i]));
+    } else if (!strcmp(argv[i], "--threads") && hasValue) {
+      threads = size_t(strtoul(argv[++i], NULL, 10));
+    } else if (!strcmp(argv[i], "--scaling")) {
+      scaling = true;
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (pairings.empty()) {
+    const GameMode modes[] = {GameMode::EASY, GameMode::MEDIUM, GameMode::HARD, GameMode::IMPOSSIBLE};
+    for (GameMode left : modes) {
+      for (int right = 0; right < 3; right++) pairings.push_back(std::make_pair(left, modes[right]));
+    }
+  }
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 1;
+
+  // Play on every thread count asked for, the results are the same each time so only the last is printed
+  std::vector<size_t> threadCounts;
+  for (size_t count = scaling ? 1 : threads; count < threads; count *= 2) threadCounts.push_back(count);
+  threadCounts.push_back(threads);
+
+  std::vector<PairingStats> results;
+  double                    baseline = 0;
+  if (scaling) printf("%7s  %9s  %12s  %8s  %10s  %7s\n", "threads", "seconds", "points/sec", "speed up", "efficiency", "steals");
+  for (size_t count : threadCounts) {
+    Tournament tournament(count);
+    for (const std::pair<GameMode, GameMode> &pairing : pairings) tournament.addPairing(pairing.first, pairing.second);
+    results = tournament.run(matches, seed, maxTicks, tickRate);
+
+    double seconds = tournament.getSeconds();
+    double rate = seconds > 0 ? double(totalPoints(results)) / seconds : 0.0;
+    if (baseline == 0) baseline = rate;
+    if (scaling) {
+      printf("%7zu  %9.3f  %12.0f  %7.2fx  %9.1f%%  %7llu\n", count, seconds, rate, baseline > 0 ? rate / baseline : 0.0,
+             baseline > 0 ? 100.0 * rate / baseline / double(count) : 0.0, (unsigned long long)tournament.getSteals());
+    } else {
+      printf("matches:      %llu per pairing, %zu pairings (seed %u)\n", (unsigned long long)matches, pairings.size(), seed);
+      printf("threads:      %zu (%llu steals)\n", count, (unsigned long long)tournament.getSteals());
+      printf("elapsed:      %.3f s\n", seconds);
+      printf("points/sec:   %.0f\n\n", rate);
+    }
+  }
+  if (scaling) printf("\n");
+  printResults(results);
+  return 0;
+}
@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2020 Mitch Coyer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+*/
+
+// Watches a match broadcast by a spectator server, drawing it in the terminal with ANSI sequences
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Pong/Screen.h"
+#include "Pong/Spectator.h"
+
+using namespace pong;
+
+static void printUsage() {
+  printf(
+      "Usage: pong_watch HOST PORT [options]\n"
+      "       pong_watch PATH [options]\n"
+      "  --frames N       Stop after N frames (default run until the stream ends)\n");
+}
+
+static int connectTcp(const char *_host, const char *_port) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses = NULL;
+  if (getaddrinfo(_host, _port, &hints, &addresses) != 0) return -1;
+  int fd = -1;
+  for (addrinfo *address = addresses; address && fd < 0; address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  return fd;
+}
+
+static int connectUnix(const char *_path) {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(_path) >= sizeof(address.sun_path)) return -1;
+  strcpy(address.sun_path, _path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+static void drawFrame(Screen &_screen, const SpectatorFrame &_frame) {
+  // The same layout as the game: borders above and below the score and along the bottom
+  int width = _frame.width, height = _frame.height;
+  if (_screen.getWidth() != width || _screen.getHeight() != height + 1) _screen.resize(width, height + 1);
+  for (int y = 0; y <= height; y++) {
+    for (int x = 0; x < width; x++) _screen.put(x, y, (y == 0 || y == 2 || y == height) ? '-' : ' ', COLOUR_WHITE);
+  }
+
+  char score[64];
+  snprintf(score, sizeof(score), "Player 1: %d | Opponent: %d", int(_frame.values[FIELD_PLAYER_1_SCORE]),
+           int(_frame.values[FIELD_OPPONENT_SCORE]));
+  _screen.setCursorPosition(0, 1);
+  _screen.print(score);
+  GameState state = GameState(_frame.values[FIELD_GAME_STATE]);
+  if (state == GameState::PAUSED) {
+    _screen.print(" | Paused");
+  } else if (state > GameState::IN_PLAY) {
+    _screen.setColour(COLOUR_GREEN);
+    _screen.print(state == GameState::PLAYER_1_WINNER ? " | Player 1 wins" : " | Opponent wins");
+    _screen.setColour(COLOUR_WHITE);
+  }
+
+  // Paddles are five cells centred on their position, the ball is one
+  int paddles[2][2] = {{0, int(_frame.position(FIELD_PLAYER_1_Y))}, {width - 1, int(_frame.position(FIELD_OPPONENT_Y))}};
+  for (auto &paddle : paddles) {
+    for (int i = -2; i <= 2; i++) _screen.put(paddle[0], paddle[1] + i, 'I', COLOUR_AQUA);
+  }
+  _screen.put(int(_frame.position(FIELD_BALL_X)), int(_frame.position(FIELD_BALL_Y)), 'O', COLOUR_GREEN);
+}
+
+int main(int argc, char **argv) {
+  // Read the command line, one argument is a Unix socket and two are a host and port
+  const char *target[2] = {NULL, NULL};
+  int         targets = 0;
+  uint64_t    maxFrames = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+      maxFrames = strtoull(argv[++i], NULL, 10);
+    } else if (argv[i][0] != '-' && targets < 2) {
+      target[targets++] = argv[i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (targets == 0) return printUsage(), 1;
+  int fd = (targets == 2) ? connectTcp(target[0], target[1]) : connectUnix(target[0]);
+  if (fd < 0) {
+    fprintf(stderr, "Can't connect to %s%s%s\n", target[0], targets == 2 ? ":" : "", targets == 2 ? target[1] : "");
+    return 1;
+  }
+
+  // Clear the terminal and hide the cursor, then redraw whenever the stream moves on
+  fputs("\x1b[2J\x1b[?25l", stdout);
+  SpectatorDecoder decoder;
+  SpectatorFrame   frame;
+  Screen           screen;
+  uint64_t         frames = 0;
+  uint8_t          buffer[4096];
+  while (maxFrames == 0 || frames < maxFrames) {
+    ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+    if (size <= 0) break;
+    decoder.feed(buffer, size_t(size));
+    if (!decoder.next(frame)) continue;
+    drawFrame(screen, frame);
+    const std::string &output = screen.present();
+    fwrite(output.data(), 1, output.size(), stdout);
+    fflush(stdout);
+    frames++;
+  }
+  close(fd);
+
+  // Leave the terminal as it was, below the last frame
+  printf("\x1b[0m\x1b[?25h\x1b[%d;1H\n", screen.getHeight() + 1);
+  fprintf(stderr, "%llu frames, %llu keyframes\n", (unsigned long long)frames, (unsigned long long)decoder.getKeyframeCount());
+  return 0;
+}